@@ -0,0 +1,127 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include <wx/datetime.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "daw/wmi_process.h"
+
+namespace daw {
+	namespace bench {
+		using clock = std::chrono::steady_clock;
+
+		// Keeps the compiler from dropping the work that made value, it has
+		// to assume value is read
+		template<typename T>
+		void keep( T const &value ) {
+#ifdef _MSC_VER
+			static void const *volatile sink = nullptr;
+			sink = &value;
+			_ReadWriteBarrier( );
+#else
+			asm volatile( "" : : "r"( &value ) : "memory" );
+#endif
+		}
+
+		// The fastest of runs calls of func, in seconds.  The fastest run is
+		// the one the rest of the machine disturbed least
+		template<typename Function>
+		double best_of( size_t runs, Function &&func ) {
+			auto result = std::numeric_limits<double>::max( );
+			for( size_t n = 0; n < std::max( runs, size_t{1} ); ++n ) {
+				auto const start = clock::now( );
+				func( );
+				auto const elapsed =
+				  std::chrono::duration<double>( clock::now( ) - start ).count( );
+				result = std::min( result, elapsed );
+			}
+			return result;
+		}
+
+		// Busy waits, sleeping is far too coarse for a simulated round trip
+		inline void spin_for( clock::duration duration ) {
+			auto const until = clock::now( ) + duration;
+			while( clock::now( ) < until ) {}
+		}
+
+		inline void print_ms( char const *name, double seconds ) {
+			std::printf( "%-40s %10.3f ms\n", name, seconds * 1e3 );
+		}
+
+		// count processes that look like a Windows host's: a few dozen names
+		// shared by many processes, long command lines and memory values
+		// spread over a few orders of magnitude
+		inline std::vector<wmi_process> make_processes( size_t count,
+		                                                uint32_t seed = 1 ) {
+			static wchar_t const *const names[] = {
+			  L"svchost.exe",  L"chrome.exe",   L"RuntimeBroker.exe",
+			  L"conhost.exe",  L"explorer.exe", L"MsMpEng.exe",
+			  L"dllhost.exe",  L"sqlservr.exe", L"w3wp.exe",
+			  L"Code.exe",     L"java.exe",     L"python.exe"};
+			auto rng = std::mt19937( seed );
+			auto result = std::vector<wmi_process>( );
+			result.reserve( count );
+			for( size_t n = 0; n < count; ++n ) {
+				auto row = wmi_process{};
+				auto const pid = static_cast<uint32_t>( 4 * n + 8 );
+				auto const name = names[rng( ) % std::size( names )];
+				row.process_id = pid;
+				row.parent_process_id = static_cast<uint32_t>( 4 * ( rng( ) % ( n + 1 ) ) );
+				row.session_id = rng( ) % 3;
+				row.name = std::wstring( name );
+				row.command_line = std::wstring( L"C:\\Program Files\\" ) + name +
+				                   L" --type=worker --id=" + std::to_wstring( rng( ) );
+				row.handle = std::to_wstring( pid );
+				row.creation_date = wxDateTime(
+				  wxLongLong( 1'600'000'000'000LL + static_cast<long long>( rng( ) ) ) );
+				row.thread_count = 1 + rng( ) % 64;
+				row.page_faults = rng( ) % 1'000'000;
+				row.working_set_size = uint64_t{1} << ( 12 + rng( ) % 20 );
+				row.working_set_size = row.working_set_size.value + rng( ) % 4096;
+				row.peak_working_set_size = row.working_set_size.value * 2;
+				row.page_file_usage = row.working_set_size.value / 2;
+				row.peak_page_file_usage = row.working_set_size.value;
+				row.read_transfer_count = rng( );
+				row.write_transfer_count = rng( );
+				row.cpu_time = rng( );
+				row.cpu_usage = rng( ) % 10'000;
+				result.push_back( std::move( row ) );
+			}
+			return result;
+		}
+	} // namespace bench
+} // namespace daw
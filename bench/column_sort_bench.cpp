@@ -0,0 +1,121 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "bench.h"
+#include "daw/column_items.h"
+#include "daw/process_store.h"
+#include "daw/wmi_process.h"
+
+namespace {
+	using column_number = daw::wmi_process::column_number;
+	using row_id = daw::process_store::row_id;
+
+	constexpr size_t runs = 5;
+
+	// Each column through the store's typed comparators against the virtual
+	// ColumnItem compare of the rows
+	void sort_every_column( std::vector<daw::wmi_process> const &processes,
+	                        daw::process_store const &store,
+	                        std::vector<row_id> const &ids ) {
+		std::printf( "  %-24s %12s %12s\n", "column", "virtual ms", "typed ms" );
+		for( size_t c = 0; c < daw::wmi_process::column_names.size( ); ++c ) {
+			auto const col = static_cast<column_number>( c );
+			auto const old_sort = daw::bench::best_of( runs, [&] {
+				auto rows = processes;
+				std::stable_sort( rows.begin( ), rows.end( ),
+				                  [c]( daw::wmi_process const &lhs,
+				                       daw::wmi_process const &rhs ) {
+					                  return lhs[c] < rhs[c];
+				                  } );
+				daw::bench::keep( rows );
+			} );
+			auto const typed_sort = daw::bench::best_of( runs, [&] {
+				auto rows = ids;
+				daw::sort_rows( store, rows, col, true );
+				daw::bench::keep( rows );
+			} );
+			std::printf( "  %-24ls %12.3f %12.3f\n",
+			             daw::wmi_process::column_names[c].wc_str( ), old_sort * 1e3,
+			             typed_sort * 1e3 );
+		}
+	}
+
+	// The string column's order three ways: folding both strings on each
+	// compare, the interned 8 byte sort key with folding only on ties, and
+	// sort_rows, which ranks strings that repeat
+	template<column_number col>
+	void sort_strings( daw::process_store const &store,
+	                   std::vector<row_id> const &ids ) {
+		auto const values = store.view<col>( );
+		auto const name = daw::wmi_process::column_names[static_cast<size_t>( col )];
+		std::printf( "  %ls\n", name.wc_str( ) );
+		daw::bench::print_ms( "    fold on compare", daw::bench::best_of( runs, [&] {
+			                      auto rows = ids;
+			                      std::stable_sort( rows.begin( ), rows.end( ),
+			                                        [&]( row_id lhs, row_id rhs ) {
+				                                        return daw::compare_nocase(
+				                                                 store.strings[values[lhs]],
+				                                                 store.strings[values[rhs]] ) < 0;
+			                                        } );
+			                      daw::bench::keep( rows );
+		                      } ) );
+		daw::bench::print_ms( "    sort key", daw::bench::best_of( runs, [&] {
+			                      auto rows = ids;
+			                      std::stable_sort( rows.begin( ), rows.end( ),
+			                                        [&]( row_id lhs, row_id rhs ) {
+				                                        return store.compare_strings(
+				                                                 values[lhs], values[rhs] ) < 0;
+			                                        } );
+			                      daw::bench::keep( rows );
+		                      } ) );
+		daw::bench::print_ms( "    sort_rows", daw::bench::best_of( runs, [&] {
+			                      auto rows = ids;
+			                      daw::sort_rows( store, rows, col, true );
+			                      daw::bench::keep( rows );
+		                      } ) );
+	}
+
+	void run( size_t count ) {
+		auto const processes = daw::bench::make_processes( count );
+		auto store = daw::process_store( );
+		auto ids = std::vector<row_id>( );
+		for( auto const &row : processes ) {
+			ids.push_back( store.add( row ) );
+		}
+		std::printf( "%zu rows\n", count );
+		sort_every_column( processes, store, ids );
+		std::printf( "  string columns\n" );
+		sort_strings<column_number::Name>( store, ids );
+		sort_strings<column_number::CommandLine>( store, ids );
+	}
+} // namespace
+
+// Sort time per column before and after the typed comparators
+int main( ) {
+	run( 5'000 );
+	run( 50'000 );
+}
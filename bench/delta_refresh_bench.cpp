@@ -0,0 +1,200 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <wx/datetime.h>
+
+#include "bench.h"
+#include "daw/process_source.h"
+#include "daw/process_store.h"
+#include "daw/wmi_process.h"
+#include "daw/wmi_process_table.h"
+
+namespace {
+	using column_number = daw::wmi_process::column_number;
+
+	// Serves processes whose counters move on every call, with a few
+	// processes replaced each tick.  Counts the bytes of the columns each
+	// call asked for, what a host would have had to send
+	class counting_source final : public daw::process_source {
+		std::vector<daw::wmi_process> m_processes;
+		uint32_t m_next_pid;
+		size_t m_churn;
+		size_t m_bytes = 0;
+
+		// Only the columns asked for, like a projected query.  Counts the
+		// bytes they take
+		daw::wmi_process project( daw::wmi_process const &row,
+		                          daw::column_set columns ) {
+			auto result = daw::wmi_process{};
+			for( size_t n = 0; n < daw::wmi_process::column_count; ++n ) {
+				if( !columns[n] ) {
+					continue;
+				}
+				daw::process_store::visit_column(
+				  static_cast<column_number>( n ), [&]( auto c ) {
+					  constexpr auto cn = decltype( c )::value;
+					  auto const &field = row.column<cn>( );
+					  result.column<cn>( ) = field;
+					  if constexpr( daw::process_store::column_kind<cn>( ) ==
+					                daw::process_store::column_kinds::String ) {
+						  m_bytes += field.value.size( ) * sizeof( wchar_t );
+					  } else {
+						  m_bytes += sizeof( field.value );
+					  }
+				  } );
+			}
+			if( columns[static_cast<size_t>( column_number::CpuUsage )] ) {
+				result.cpu_time = row.cpu_time;
+				m_bytes += sizeof( row.cpu_time );
+			}
+			return result;
+		}
+
+		daw::wmi_process make_process( uint32_t pid ) const {
+			auto row = daw::wmi_process{};
+			row.process_id = pid;
+			row.parent_process_id = 4;
+			row.name = L"process" + std::to_wstring( pid ) + L".exe";
+			row.command_line =
+			  L"C:\\Program Files\\Vendor\\Product\\process" + std::to_wstring( pid ) +
+			  L".exe --service --config C:\\ProgramData\\Vendor\\product.ini";
+			row.handle = std::to_wstring( pid );
+			row.creation_date = wxDateTime( wxLongLong( 1'000 + pid ) );
+			return row;
+		}
+
+		std::vector<daw::wmi_process> serve( daw::column_set columns ) {
+			for( auto &row : m_processes ) {
+				row.working_set_size = row.working_set_size.value + 4096;
+				row.page_faults = row.page_faults.value + 1;
+				row.read_transfer_count = row.read_transfer_count.value + 512;
+				row.cpu_time += 100'000;
+			}
+			auto result = std::vector<daw::wmi_process>( );
+			result.reserve( m_processes.size( ) );
+			for( auto const &row : m_processes ) {
+				result.push_back( project( row, columns ) );
+			}
+			return result;
+		}
+
+	public:
+		counting_source( size_t count, size_t churn )
+		  : m_next_pid( static_cast<uint32_t>( count ) )
+		  , m_churn( churn ) {
+			for( uint32_t pid = 0; pid < count; ++pid ) {
+				m_processes.push_back( make_process( pid ) );
+			}
+		}
+
+		// Replaces the first churn processes with new ones
+		void tick( ) {
+			for( size_t n = 0; n < m_churn; ++n ) {
+				auto &row = m_processes[( m_next_pid + n ) % m_processes.size( )];
+				row = make_process( m_next_pid++ );
+			}
+		}
+
+		size_t take_bytes( ) {
+			return std::exchange( m_bytes, 0 );
+		}
+
+		std::vector<daw::wmi_process> get_processes( std::wstring const &,
+		                                             daw::column_set columns ) override {
+			return serve( columns );
+		}
+
+		std::vector<daw::wmi_process>
+		get_processes( std::wstring const &, daw::column_set columns,
+		               std::vector<uint32_t> const &process_ids ) override {
+			auto result = std::vector<daw::wmi_process>( );
+			for( auto const &row : m_processes ) {
+				if( std::find( process_ids.begin( ), process_ids.end( ),
+				               row.process_id.value ) != process_ids.end( ) ) {
+					result.push_back( project( row, columns ) );
+				}
+			}
+			return result;
+		}
+
+		void for_each_process(
+		  std::wstring const &, daw::column_set columns,
+		  std::function<void( daw::wmi_process const & )> const &func ) override {
+			for( auto const &row : serve( columns ) ) {
+				func( row );
+			}
+		}
+
+		void terminate_process( std::wstring const &, uint32_t ) override {}
+	};
+
+	struct result_t {
+		double seconds;
+		size_t bytes;
+	};
+
+	// The slowest part of a refresh is the host, which is not measured here:
+	// the bytes are what it would have had to send
+	result_t refresh( size_t count, bool is_full ) {
+		static constexpr size_t ticks = 20;
+		static constexpr size_t runs = 3;
+		auto source = std::make_shared<counting_source>( count, count / 100 );
+		auto table = daw::wmi_process_table( L"host", source );
+		table.update_data( );
+		table.apply_update( );
+		source->take_bytes( );
+		auto const seconds = daw::bench::best_of( runs, [&] {
+			for( size_t n = 0; n < ticks; ++n ) {
+				source->tick( );
+				if( is_full ) {
+					// Showing a column again fetches every column of every row
+					table.set_column_visible( static_cast<int>( column_number::Name ), true );
+				}
+				table.update_data( );
+				table.apply_update( );
+			}
+		} );
+		return {seconds / ticks, source->take_bytes( ) / ( runs * ticks )};
+	}
+} // namespace
+
+// A refresh that fetches every column of every process against one that
+// fetches the counters and only the new processes in full, 1% of them
+// replaced each tick
+int main( ) {
+	for( auto const count : {size_t{2'000}, size_t{5'000}, size_t{20'000}} ) {
+		std::printf( "%zu processes\n", count );
+		for( auto const is_full : {true, false} ) {
+			auto const result = refresh( count, is_full );
+			std::printf( "  %-6s %10.3f ms %12zu bytes\n", is_full ? "full" : "delta",
+			             result.seconds * 1e3, result.bytes );
+		}
+	}
+}
@@ -0,0 +1,127 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <wx/datetime.h>
+
+#include "daw/column_items.h"
+#include "daw/wmi_process.h"
+#include "daw/wmi_record_decoder.h"
+
+namespace daw {
+	namespace bench {
+		// A Win32_Process record in memory, its properties indexed like
+		// process_property_list.  Dates are held as milliseconds, the CIM
+		// datetime text is not parsed
+		struct fake_record {
+			std::array<uint64_t, process_property_list.size( )> integers{};
+			std::array<std::wstring, process_property_list.size( )> strings;
+		};
+
+		// Reads a fake_record by handle like IWbemObjectAccess, the handle is
+		// the property's index
+		struct fake_access {
+			using record_t = fake_record;
+			using handle_t = size_t;
+
+			std::optional<handle_t> resolve( record_t &, wchar_t const *name,
+			                                 cim_kinds ) const {
+				for( size_t n = 0; n < process_property_list.size( ); ++n ) {
+					if( std::wstring_view( process_property_list[n].name ) == name ) {
+						return n;
+					}
+				}
+				return std::nullopt;
+			}
+
+			uint32_t read_uint32( record_t &record, handle_t handle ) const {
+				return static_cast<uint32_t>( record.integers[handle] );
+			}
+
+			uint64_t read_uint64( record_t &record, handle_t handle ) const {
+				return record.integers[handle];
+			}
+
+			// Leaves dest alone when it already holds the value, like the
+			// decoder's own accessors
+			void read_string( record_t &record, handle_t handle,
+			                  String &dest ) const {
+				auto const str = std::wstring_view( record.strings[handle] );
+				if( std::wstring_view( dest.value.wc_str( ), dest.value.length( ) ) !=
+				    str ) {
+					dest = str;
+				}
+			}
+
+			wxDateTime read_datetime( record_t &record, handle_t handle ) const {
+				return wxDateTime(
+				  wxLongLong( static_cast<long long>( record.integers[handle] ) ) );
+			}
+		};
+
+		// The records a host would send for processes
+		inline std::vector<fake_record>
+		make_records( std::vector<wmi_process> const &processes ) {
+			using P = process_properties;
+			auto result = std::vector<fake_record>( );
+			result.reserve( processes.size( ) );
+			for( auto const &row : processes ) {
+				auto record = fake_record{};
+				auto const set = [&]( P prop, uint64_t value ) {
+					record.integers[static_cast<size_t>( prop )] = value;
+				};
+				auto const set_string = [&]( P prop, String const &value ) {
+					record.strings[static_cast<size_t>( prop )] =
+					  std::wstring( value.value.wc_str( ), value.value.length( ) );
+				};
+				set_string( P::Name, row.name );
+				set_string( P::CommandLine, row.command_line );
+				set_string( P::Handle, row.handle );
+				set( P::ProcessId, row.process_id.value );
+				set( P::ParentProcessId, row.parent_process_id.value );
+				set( P::SessionId, row.session_id.value );
+				set( P::CreationDate,
+				     static_cast<uint64_t>(
+				       row.creation_date.value.GetValue( ).GetValue( ) ) );
+				set( P::ThreadCount, row.thread_count.value );
+				set( P::PageFaults, row.page_faults.value );
+				set( P::PageFileUsage, row.page_file_usage.value / 1024 );
+				set( P::PeakPageFileUsage, row.peak_page_file_usage.value / 1024 );
+				set( P::WorkingSetSize, row.working_set_size.value );
+				set( P::PeakWorkingSetSize, row.peak_working_set_size.value / 1024 );
+				set( P::ReadTransferCount, row.read_transfer_count.value );
+				set( P::WriteTransferCount, row.write_transfer_count.value );
+				set( P::KernelModeTime, row.cpu_time / 2 );
+				set( P::UserModeTime, row.cpu_time - row.cpu_time / 2 );
+				result.push_back( std::move( record ) );
+			}
+			return result;
+		}
+	} // namespace bench
+} // namespace daw
@@ -0,0 +1,140 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "daw/parallel.h"
+#include "daw/process_store.h"
+#include "daw/wmi_process.h"
+#include "daw/wmi_projection.h"
+#include "daw/wmi_record_decoder.h"
+#include "fake_record.h"
+
+namespace {
+	using column_number = daw::wmi_process::column_number;
+	using row_id = daw::process_store::row_id;
+
+	constexpr size_t runs = 5;
+	constexpr size_t thread_counts[] = {1, 2, 4, 8};
+
+	daw::process_store make_store( size_t count, std::vector<row_id> &ids ) {
+		auto store = daw::process_store( );
+		for( auto const &row : daw::bench::make_processes( count ) ) {
+			ids.push_back( store.add( row ) );
+		}
+		return store;
+	}
+
+	// The sort a header click hands to the worker thread.  Only the sort is
+	// timed, the snapshot is taken on the UI thread
+	void sort_snapshots( size_t count ) {
+		auto ids = std::vector<row_id>( );
+		auto const store = make_store( count, ids );
+		std::printf( "sort snapshot, %zu rows\n", count );
+		for( auto const col : {column_number::WorkingSetSize, column_number::Name} ) {
+			std::printf( "  %ls\n",
+			             daw::wmi_process::column_names[static_cast<size_t>( col )]
+			               .wc_str( ) );
+			daw::bench::print_ms( "    take snapshot", daw::bench::best_of( runs, [&] {
+				                      daw::bench::keep(
+				                        daw::make_sort_snapshot( store, ids, col, true ) );
+			                      } ) );
+			auto const snapshot = daw::make_sort_snapshot( store, ids, col, true );
+			for( auto const threads : thread_counts ) {
+				auto best = std::numeric_limits<double>::max( );
+				for( size_t n = 0; n < runs; ++n ) {
+					auto copy = snapshot;
+					best = std::min( best, daw::bench::best_of( 1, [&] {
+						                 daw::bench::keep( copy.sort( threads ) );
+					                 } ) );
+				}
+				std::printf( "    %zu threads %34.3f ms\n", threads, best * 1e3 );
+			}
+		}
+	}
+
+	// Records decoded into wmi_process on each thread count, the way
+	// decode_records splits them
+	void decode_records( size_t count ) {
+		static constexpr size_t min_records_per_thread = 512;
+		auto records = daw::bench::make_records( daw::bench::make_processes( count ) );
+		auto decode = daw::record_decoder<daw::bench::fake_access>(
+		  daw::bench::fake_access{}, daw::all_columns( ) );
+		decode.resolve( records.front( ) );
+		std::printf( "decode, %zu records\n", count );
+		for( auto const threads : thread_counts ) {
+			auto const seconds = daw::bench::best_of( runs, [&] {
+				auto result = std::vector<daw::wmi_process>( records.size( ) );
+				daw::parallel_for(
+				  records.size( ),
+				  [&]( size_t first, size_t last ) {
+					  for( auto n = first; n < last; ++n ) {
+						  decode( records[n], result[n] );
+					  }
+				  },
+				  threads, min_records_per_thread );
+				daw::bench::keep( result );
+			} );
+			std::printf( "  %zu threads %36.3f ms\n", threads, seconds * 1e3 );
+		}
+	}
+
+	// sort_rows on the UI thread, around background_sort_rows in
+	// wmi_process_table.cpp.  A frame is ~16 ms
+	void sort_latency( ) {
+		std::printf( "sort_rows on the UI thread\n" );
+		std::printf( "  %8s %14s %14s %14s\n", "rows", "Working Set", "Name",
+		             "CommandLine" );
+		for( auto const count : {1'000UL, 2'000UL, 5'000UL, 10'000UL, 20'000UL,
+		                         50'000UL} ) {
+			auto ids = std::vector<row_id>( );
+			auto const store = make_store( count, ids );
+			auto const time_sort = [&]( column_number col ) {
+				return daw::bench::best_of( runs, [&] {
+					auto rows = ids;
+					daw::sort_rows( store, rows, col, true );
+					daw::bench::keep( rows );
+				} );
+			};
+			std::printf( "  %8lu %11.3f ms %11.3f ms %11.3f ms\n", count,
+			             time_sort( column_number::WorkingSetSize ) * 1e3,
+			             time_sort( column_number::Name ) * 1e3,
+			             time_sort( column_number::CommandLine ) * 1e3 );
+		}
+	}
+} // namespace
+
+// Scaling of the parallel sort and decode with the thread count, and the
+// sort latency that background_sort_rows is chosen from
+int main( ) {
+	std::printf( "%u hardware threads\n", std::thread::hardware_concurrency( ) );
+	sort_snapshots( 100'000 );
+	sort_snapshots( 500'000 );
+	decode_records( 100'000 );
+	sort_latency( );
+}
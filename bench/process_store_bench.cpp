@@ -0,0 +1,122 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <numeric>
+#include <vector>
+
+#include "bench.h"
+#include "daw/process_store.h"
+#include "daw/wmi_process.h"
+
+namespace {
+	using column_number = daw::wmi_process::column_number;
+	using row_id = daw::process_store::row_id;
+
+	// The layout before the store, a vector of rows whose columns are
+	// compared through ColumnItem
+	void sort_rows( std::vector<daw::wmi_process> &rows, column_number col ) {
+		auto const c = static_cast<size_t>( col );
+		std::stable_sort( rows.begin( ), rows.end( ),
+		                  [c]( daw::wmi_process const &lhs, daw::wmi_process const &rhs ) {
+			                  return lhs[c].compare( rhs[c] ) < 0;
+		                  } );
+	}
+
+	void run( size_t count ) {
+		static constexpr size_t runs = 5;
+		static constexpr uint64_t large = uint64_t{1} << 28U;
+		auto const processes = daw::bench::make_processes( count );
+		std::printf( "%zu rows\n", count );
+
+		auto store = daw::process_store( );
+		auto ids = std::vector<row_id>( );
+		daw::bench::print_ms( "  build rows", daw::bench::best_of( runs, [&] {
+			                      auto rows = processes;
+			                      daw::bench::keep( rows );
+		                      } ) );
+		daw::bench::print_ms( "  build store", daw::bench::best_of( runs, [&] {
+			                      store.clear( );
+			                      ids.clear( );
+			                      for( auto const &row : processes ) {
+				                      ids.push_back( store.add( row ) );
+			                      }
+		                      } ) );
+
+		for( auto const col : {column_number::WorkingSetSize, column_number::Name,
+		                       column_number::CreationDate} ) {
+			auto const name = daw::wmi_process::column_names[static_cast<size_t>( col )];
+			std::printf( "  sort on %ls\n", name.wc_str( ) );
+			daw::bench::print_ms( "    rows", daw::bench::best_of( runs, [&] {
+				                      auto rows = processes;
+				                      sort_rows( rows, col );
+				                      daw::bench::keep( rows );
+			                      } ) );
+			daw::bench::print_ms( "    store", daw::bench::best_of( runs, [&] {
+				                      auto rows = ids;
+				                      daw::sort_rows( store, rows, col, true );
+				                      daw::bench::keep( rows );
+			                      } ) );
+		}
+
+		std::printf( "  filter working set > 256MB\n" );
+		daw::bench::print_ms( "    rows", daw::bench::best_of( runs, [&] {
+			                      auto const n = std::count_if(
+			                        processes.begin( ), processes.end( ),
+			                        []( daw::wmi_process const &row ) {
+				                        return row.working_set_size.value > large;
+			                        } );
+			                      daw::bench::keep( n );
+		                      } ) );
+		daw::bench::print_ms( "    store", daw::bench::best_of( runs, [&] {
+			                      auto const values =
+			                        store.view<column_number::WorkingSetSize>( );
+			                      auto const n = std::count_if(
+			                        values.begin( ), values.end( ),
+			                        []( uint64_t value ) { return value > large; } );
+			                      daw::bench::keep( n );
+		                      } ) );
+
+		std::printf( "  total working set\n" );
+		daw::bench::print_ms( "    rows", daw::bench::best_of( runs, [&] {
+			                      auto const total = std::accumulate(
+			                        processes.begin( ), processes.end( ), uint64_t{0},
+			                        []( uint64_t sum, daw::wmi_process const &row ) {
+				                        return sum + row.working_set_size.value;
+			                        } );
+			                      daw::bench::keep( total );
+		                      } ) );
+		daw::bench::print_ms( "    store", daw::bench::best_of( runs, [&] {
+			                      auto const total =
+			                        store.total<column_number::WorkingSetSize>( );
+			                      daw::bench::keep( total );
+		                      } ) );
+	}
+} // namespace
+
+// The column store against the vector of wmi_process rows it replaced
+int main( ) {
+	run( 10'000 );
+	run( 100'000 );
+}
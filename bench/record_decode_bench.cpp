@@ -0,0 +1,139 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <wx/datetime.h>
+
+#include "bench.h"
+#include "daw/column_items.h"
+#include "daw/wmi_process.h"
+#include "daw/wmi_projection.h"
+#include "daw/wmi_record_decoder.h"
+#include "fake_record.h"
+
+namespace {
+	size_t allocation_count = 0;
+} // namespace
+
+// Every allocation of the bench is counted
+void *operator new( size_t size ) {
+	++allocation_count;
+	if( auto ptr = std::malloc( size == 0 ? 1 : size ) ) {
+		return ptr;
+	}
+	throw std::bad_alloc( );
+}
+
+void operator delete( void *ptr ) noexcept {
+	std::free( ptr );
+}
+
+void operator delete( void *ptr, size_t ) noexcept {
+	std::free( ptr );
+}
+
+namespace {
+	// The decode before it read from the BSTR: every read looks the property
+	// up by a std::wstring name, a string property is copied into a
+	// std::wstring and from there into the String
+	struct copying_access {
+		using record_t = daw::bench::fake_record;
+		using handle_t = wchar_t const *;
+
+		static size_t index_of( std::wstring const &name ) {
+			for( size_t n = 0; n < daw::process_property_list.size( ); ++n ) {
+				if( name == daw::process_property_list[n].name ) {
+					return n;
+				}
+			}
+			return 0;
+		}
+
+		std::optional<handle_t> resolve( record_t &, wchar_t const *name,
+		                                 daw::cim_kinds ) const {
+			return name;
+		}
+
+		uint32_t read_uint32( record_t &record, handle_t name ) const {
+			return static_cast<uint32_t>( read_uint64( record, name ) );
+		}
+
+		uint64_t read_uint64( record_t &record, handle_t name ) const {
+			return record.integers[index_of( std::wstring( name ) )];
+		}
+
+		void read_string( record_t &record, handle_t name,
+		                  daw::String &dest ) const {
+			auto const value = std::wstring( record.strings[index_of( name )] );
+			dest = std::wstring_view( value );
+		}
+
+		wxDateTime read_datetime( record_t &record, handle_t name ) const {
+			return wxDateTime( wxLongLong(
+			  static_cast<long long>( record.integers[index_of( name )] ) ) );
+		}
+	};
+
+	template<typename Accessor>
+	void run( char const *name, std::vector<daw::bench::fake_record> &records ) {
+		static constexpr size_t runs = 5;
+		auto decode =
+		  daw::record_decoder<Accessor>( Accessor{}, daw::all_columns( ) );
+		decode.resolve( records.front( ) );
+		auto processes = std::vector<daw::wmi_process>( records.size( ) );
+
+		// The first refresh fills empty rows, the next ones decode the same
+		// processes into the rows they filled.  Prints the fastest of runs
+		auto const time_refresh = [&]( char const *refresh, size_t refresh_runs ) {
+			auto const before = allocation_count;
+			auto const seconds = daw::bench::best_of( refresh_runs, [&] {
+				for( size_t n = 0; n < records.size( ); ++n ) {
+					decode( records[n], processes[n] );
+				}
+				daw::bench::keep( processes );
+			} );
+			auto const allocations = ( allocation_count - before ) / refresh_runs;
+			std::printf( "  %-16s %8.2f allocations %8.0f ns per record\n", refresh,
+			             static_cast<double>( allocations ) /
+			               static_cast<double>( records.size( ) ),
+			             seconds * 1e9 / static_cast<double>( records.size( ) ) );
+		};
+		std::printf( "%s\n", name );
+		time_refresh( "first refresh", 1 );
+		time_refresh( "unchanged", runs );
+	}
+} // namespace
+
+// Allocations per decoded record through the copying accessor against the
+// one that compares the property with what the String already holds
+int main( ) {
+	auto records = daw::bench::make_records( daw::bench::make_processes( 10'000 ) );
+	run<copying_access>( "copy through std::wstring", records );
+	run<daw::bench::fake_access>( "compare, then assign", records );
+}
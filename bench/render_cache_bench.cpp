@@ -0,0 +1,120 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "daw/process_store.h"
+#include "daw/wmi_process.h"
+#include "daw/wmi_process_table.h"
+#include "fake_process_source.h"
+
+namespace {
+	using column_number = daw::wmi_process::column_number;
+
+	// The rows a grid of a usual size shows
+	constexpr int visible_rows = 40;
+
+	// Busy processes change a few counters between refreshes
+	void churn( std::vector<daw::wmi_process> &processes, std::mt19937 &rng ) {
+		for( auto &row : processes ) {
+			if( rng( ) % 10 == 0 ) {
+				row.cpu_usage = rng( ) % 10'000;
+				row.working_set_size = row.working_set_size.value + rng( ) % 4096;
+				row.page_faults = row.page_faults.value + rng( ) % 100;
+			}
+		}
+	}
+
+	// Every numeric and date cell of every row, what the constructors of
+	// Memory, Date and Integer did on each refresh
+	size_t format_every_cell( daw::wmi_process_table const &table ) {
+		auto const &store = table.store( );
+		size_t count = 0;
+		for( auto id : table.rows( ) ) {
+			for( size_t c = 0; c < daw::wmi_process::column_names.size( ); ++c ) {
+				auto const cn = static_cast<column_number>( c );
+				if( daw::process_store::column_kind( cn ) !=
+				    daw::process_store::column_kinds::String ) {
+					count += store.to_string( id, cn ).size( );
+				}
+			}
+		}
+		return count;
+	}
+
+	// The cells the grid asks for, through the render cache
+	size_t format_viewport( daw::wmi_process_table &table ) {
+		size_t count = 0;
+		auto const rows = std::min( visible_rows, table.GetNumberRows( ) );
+		for( int row = 0; row < rows; ++row ) {
+			for( int col = 0; col < table.GetNumberCols( ); ++col ) {
+				count += table.GetValue( row, col ).size( );
+			}
+		}
+		return count;
+	}
+
+	void run( size_t count ) {
+		static constexpr size_t refreshes = 10;
+		auto rng = std::mt19937( 3 );
+		auto processes = daw::bench::make_processes( count );
+		auto source = std::make_shared<daw::test::fake_process_source>( processes );
+		auto table = daw::wmi_process_table( L"host", source );
+		table.sort_column( column_number::WorkingSetSize,
+		                   daw::wmi_process_table::SortOrder::Descending );
+		table.update_data( );
+		table.apply_update( );
+
+		// Per refresh, only the formatting is timed
+		auto eager = 0.0;
+		auto lazy = 0.0;
+		for( size_t n = 0; n < refreshes; ++n ) {
+			churn( processes, rng );
+			source->set_processes( processes );
+			table.update_data( );
+			table.apply_update( );
+			eager += daw::bench::best_of( 1, [&] {
+				daw::bench::keep( format_every_cell( table ) );
+			} );
+			lazy += daw::bench::best_of( 1, [&] {
+				daw::bench::keep( format_viewport( table ) );
+			} );
+		}
+		std::printf( "%zu rows, per refresh\n", count );
+		daw::bench::print_ms( "  format every cell", eager / refreshes );
+		daw::bench::print_ms( "  format the viewport", lazy / refreshes );
+	}
+} // namespace
+
+// Formatting every cell on each refresh against formatting the visible
+// cells when the grid asks for them
+int main( ) {
+	run( 1'000 );
+	run( 10'000 );
+	run( 50'000 );
+}
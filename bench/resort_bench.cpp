@@ -0,0 +1,121 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "daw/process_store.h"
+#include "daw/wmi_process.h"
+
+namespace {
+	using column_number = daw::wmi_process::column_number;
+	using row_id = daw::process_store::row_id;
+
+	constexpr size_t runs = 5;
+
+	// A refresh where percent of the processes changed their value in col,
+	// a tenth as many ended and as many started
+	std::vector<row_id> refresh( daw::process_store &store, std::vector<row_id> ids,
+	                             column_number col, size_t percent,
+	                             std::mt19937 &rng ) {
+		auto const changed = ids.size( ) * percent / 100;
+		for( size_t n = 0; n < changed; ++n ) {
+			auto const id = ids[rng( ) % ids.size( )];
+			auto row = store.to_process( id );
+			row.working_set_size = uint64_t{1} << ( 12 + rng( ) % 20 );
+			row.cpu_usage = rng( ) % 10'000;
+			store.assign( id, col, row );
+		}
+		auto started = daw::bench::make_processes( changed / 10 + 1, rng( ) );
+		for( auto &row : started ) {
+			auto const ended =
+			  ids.begin( ) + static_cast<std::ptrdiff_t>( rng( ) % ids.size( ) );
+			store.remove( *ended );
+			ids.erase( ended );
+			row.process_id = static_cast<uint32_t>( 1'000'000 + rng( ) % 1'000'000 );
+			ids.push_back( store.add( row ) );
+		}
+		return ids;
+	}
+
+	void run( size_t count, column_number col ) {
+		std::printf( "%zu rows on %ls\n", count,
+		             daw::wmi_process::column_names[static_cast<size_t>( col )]
+		               .wc_str( ) );
+		std::printf( "  %-10s %14s %14s\n", "changed", "sort ms", "resort ms" );
+		for( auto const percent : {1UL, 5UL, 20UL, 50UL} ) {
+			auto rng = std::mt19937( 11 );
+			auto store = daw::process_store( );
+			auto ids = std::vector<row_id>( );
+			for( auto const &row : daw::bench::make_processes( count ) ) {
+				ids.push_back( store.add( row ) );
+			}
+			auto previous = ids;
+			daw::sort_rows( store, previous, col, true );
+			auto const rows = refresh( store, ids, col, percent, rng );
+
+			auto const sort = daw::bench::best_of( runs, [&] {
+				auto sorted = rows;
+				daw::sort_rows( store, sorted, col, true );
+				daw::bench::keep( sorted );
+			} );
+			auto const resort = daw::bench::best_of( runs, [&] {
+				daw::bench::keep( daw::resort_rows( store, previous, rows, col ) );
+			} );
+			std::printf( "  %8lu%% %14.3f %14.3f\n", percent, sort * 1e3,
+			             resort * 1e3 );
+		}
+
+		// Toggling the direction reads the current order backwards
+		auto store = daw::process_store( );
+		auto ids = std::vector<row_id>( );
+		for( auto const &row : daw::bench::make_processes( count ) ) {
+			ids.push_back( store.add( row ) );
+		}
+		auto ascending = ids;
+		daw::sort_rows( store, ascending, col, true );
+		std::printf( "  toggle direction\n" );
+		daw::bench::print_ms( "    sort descending", daw::bench::best_of( runs, [&] {
+			                      auto rows = ids;
+			                      daw::sort_rows( store, rows, col, false );
+			                      daw::bench::keep( rows );
+		                      } ) );
+		daw::bench::print_ms( "    reverse", daw::bench::best_of( runs, [&] {
+			                      auto rows = ascending;
+			                      std::reverse( rows.begin( ), rows.end( ) );
+			                      daw::bench::keep( rows );
+		                      } ) );
+	}
+} // namespace
+
+// Sorting from scratch after a refresh against repairing the previous
+// permutation, and reversing it against sorting the other way
+int main( ) {
+	for( auto const count : {10'000UL, 50'000UL} ) {
+		run( count, column_number::WorkingSetSize );
+		run( count, column_number::CpuUsage );
+	}
+}
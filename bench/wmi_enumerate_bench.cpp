@@ -0,0 +1,78 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <atlcomcli.h>
+#include <chrono>
+#include <cstdio>
+#include <Wbemidl.h>
+
+#include "bench.h"
+#include "daw/wmi_enumerate.h"
+#include "daw/wmi_process.h"
+
+namespace {
+	// A host that pays round_trip for every Next call, plus per_record for
+	// each record it hands out.  The records are null
+	struct fake_enumerator {
+		unsigned long remaining;
+		daw::bench::clock::duration round_trip;
+		daw::bench::clock::duration per_record;
+
+		HRESULT Next( long, ULONG count, IWbemClassObject **objects,
+		              ULONG *returned ) {
+			auto const n = std::min<unsigned long>( count, remaining );
+			daw::bench::spin_for( round_trip + per_record * n );
+			for( ULONG i = 0; i < n; ++i ) {
+				objects[i] = nullptr;
+			}
+			remaining -= n;
+			*returned = n;
+			return remaining == 0 ? WBEM_S_FALSE : WBEM_S_NO_ERROR;
+		}
+	};
+} // namespace
+
+// Records per second for each batch size, on a host with a LAN-like round
+// trip and one with a WAN-like one
+int main( ) {
+	using std::chrono::microseconds;
+	static constexpr unsigned long record_count = 2'000;
+	for( auto const round_trip : {microseconds( 200 ), microseconds( 2'000 )} ) {
+		std::printf( "%lu records, %lld us round trip\n", record_count,
+		             static_cast<long long>( round_trip.count( ) ) );
+		for( auto const batch_size : {1UL, 16UL, 64UL, 128UL, 256UL, 512UL} ) {
+			auto opts = daw::wmi_enumerate_options{};
+			opts.batch_size = batch_size;
+			size_t seen = 0;
+			auto const seconds = daw::bench::best_of( 3, [&] {
+				auto enumerator =
+				  fake_enumerator{record_count, round_trip, microseconds( 1 )};
+				daw::for_each_wmi_record(
+				  &enumerator, opts,
+				  [&]( CComPtr<IWbemClassObject> & ) { ++seen; } );
+			} );
+			daw::bench::keep( seen );
+			std::printf( "  batch %4lu %12.0f records/s\n", batch_size,
+			             record_count / seconds );
+		}
+	}
+}
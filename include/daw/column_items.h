@@ -22,11 +22,22 @@
 //
 #pragma once
 
+#include <array>
 #include <cstdint>
+#include <string_view>
 #include <wx/datetime.h>
 #include <wx/string.h>
 
 namespace daw {
+	// Large enough for any formatted integer, memory size or date
+	using format_buffer = std::array<wchar_t, 32>;
+
+	// Format into buff without allocating, the result points into buff
+	std::wstring_view format_integer( uint64_t value, format_buffer &buff ) noexcept;
+	std::wstring_view format_memory( uint64_t value, format_buffer &buff ) noexcept;
+	// value is in hundredths of a percent
+	std::wstring_view format_percent( uint64_t value, format_buffer &buff ) noexcept;
+
 	struct ColumnItem {
 		ColumnItem( ) noexcept = default;
 		ColumnItem( ColumnItem const & ) noexcept = default;
@@ -39,9 +50,10 @@ namespace daw {
 		virtual wxString to_string( ) const = 0;
 	};
 
+	// The value types only format their value when to_string is called, most
+	// cells are never displayed
 	struct Memory : ColumnItem {
 		uint64_t value = 0;
-		wxString str_value = L"";
 
 		Memory( ) = default;
 
@@ -53,12 +65,25 @@ namespace daw {
 		wxString to_string( ) const override;
 	};
 
+	// Hundredths of a percent, 1234 is 12.34%
+	struct Percent : ColumnItem {
+		uint32_t value = 0;
+
+		Percent( ) = default;
+
+		explicit Percent( uint32_t v );
+
+		Percent &operator=( uint32_t v );
+
+		int compare( ColumnItem const &rhs ) const override;
+		wxString to_string( ) const override;
+	};
+
 	struct Date : ColumnItem {
 		enum class date_formats { Combined, DateOnly, TimeOnly };
 
 		wxDateTime value = {};
 		date_formats date_format = date_formats::Combined;
-		wxString str_value = L"";
 
 		Date( ) = default;
 
@@ -73,17 +98,14 @@ namespace daw {
 	template<typename T>
 	struct Integer : ColumnItem {
 		T value = 0;
-		wxString str_value = L"";
 
 		Integer( ) noexcept = default;
 
 		Integer( uint64_t v ) noexcept
-		  : value( v )
-		  , str_value( std::to_wstring( value ) ) {}
+		  : value( v ) {}
 
 		Integer &operator=( uint64_t v ) noexcept {
 			value = v;
-			str_value = std::to_wstring( value );
 			return *this;
 		}
 
@@ -99,7 +121,9 @@ namespace daw {
 		}
 
 		wxString to_string( ) const override {
-			return str_value;
+			auto buff = format_buffer{};
+			auto const str = format_integer( value, buff );
+			return wxString( str.data( ), str.size( ) );
 		}
 	};
 
@@ -139,4 +163,28 @@ namespace daw {
 	}
 
 	wxString to_wstring( Memory value );
+
+	wxString memory_value_to_wstring( uint64_t value );
+	wxString to_date_string( Date::date_formats date_format,
+	                         wxDateTime const &value );
+	// Returns an empty view for the formats that need wxDateTime
+	std::wstring_view format_date( Date::date_formats date_format,
+	                               wxDateTime const &value, format_buffer &buff );
+
+	// Case folding used for sorting, the same on every platform.  Like
+	// _wcsnicmp in the "C" locale only A-Z are folded, to lower case
+	constexpr wchar_t fold_case( wchar_t c ) noexcept {
+		if( c >= L'A' && c <= L'Z' ) {
+			return static_cast<wchar_t>( c - L'A' + L'a' );
+		}
+		return c;
+	}
+
+	// Case insensitive, a string sorts before the strings it is a prefix of
+	int compare_nocase( std::wstring_view lhs, std::wstring_view rhs ) noexcept;
+
+	// The first 4 folded UTF-16 code units of str packed into 64 bits so that
+	// comparing keys orders strings like compare_nocase.  Equal keys need
+	// compare_nocase to break the tie
+	uint64_t folded_sort_key( std::wstring_view str ) noexcept;
 } // namespace daw
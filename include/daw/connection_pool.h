@@ -0,0 +1,122 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace daw {
+	// Creates connections for a connection_pool and decides when a failure
+	// means that the cached connection can no longer be used
+	template<typename Connection>
+	struct connection_backend {
+		connection_backend( ) noexcept = default;
+		connection_backend( connection_backend const & ) = default;
+		connection_backend( connection_backend && ) noexcept = default;
+		connection_backend &operator=( connection_backend const & ) = default;
+		connection_backend &operator=( connection_backend && ) noexcept = default;
+
+		virtual ~connection_backend( ) = default;
+		virtual std::shared_ptr<Connection> connect( std::wstring const &host ) = 0;
+		virtual bool is_connection_lost( std::exception const &ex ) const = 0;
+	};
+
+	// Keeps one live connection per host.  A connection is reused until an
+	// operation fails with an error the backend reports as a lost connection,
+	// at which point it is dropped and the operation is retried once on a
+	// fresh connection
+	template<typename Connection>
+	class connection_pool {
+		std::unique_ptr<connection_backend<Connection>> m_backend;
+		mutable std::mutex m_mutex;
+		std::unordered_map<std::wstring, std::shared_ptr<Connection>>
+		  m_connections;
+
+	public:
+		using connection_t = Connection;
+
+		explicit connection_pool(
+		  std::unique_ptr<connection_backend<Connection>> backend )
+		  : m_backend( std::move( backend ) ) {}
+
+		std::shared_ptr<Connection> acquire( std::wstring const &host ) {
+			{
+				std::lock_guard<std::mutex> lck( m_mutex );
+				if( auto pos = m_connections.find( host );
+				    pos != m_connections.end( ) ) {
+					return pos->second;
+				}
+			}
+			// Connecting can take a long time, do not block the other hosts
+			auto conn = m_backend->connect( host );
+			std::lock_guard<std::mutex> lck( m_mutex );
+			// Another thread may have connected first, prefer theirs
+			return m_connections.try_emplace( host, std::move( conn ) )
+			  .first->second;
+		}
+
+		// Remove the host's connection if it is still conn
+		void invalidate( std::wstring const &host,
+		                 std::shared_ptr<Connection> const &conn ) {
+			std::lock_guard<std::mutex> lck( m_mutex );
+			if( auto pos = m_connections.find( host );
+			    pos != m_connections.end( ) && pos->second == conn ) {
+				m_connections.erase( pos );
+			}
+		}
+
+		void invalidate( std::wstring const &host ) {
+			std::lock_guard<std::mutex> lck( m_mutex );
+			m_connections.erase( host );
+		}
+
+		void clear( ) {
+			std::lock_guard<std::mutex> lck( m_mutex );
+			m_connections.clear( );
+		}
+
+		size_t size( ) const {
+			std::lock_guard<std::mutex> lck( m_mutex );
+			return m_connections.size( );
+		}
+
+		template<typename Function>
+		auto with_connection( std::wstring const &host, Function &&func ) {
+			auto conn = acquire( host );
+			try {
+				return func( *conn );
+			} catch( std::exception const &ex ) {
+				if( !m_backend->is_connection_lost( ex ) ) {
+					throw;
+				}
+			}
+			invalidate( host, conn );
+			conn = acquire( host );
+			return func( *conn );
+		}
+	};
+} // namespace daw
@@ -0,0 +1,115 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <wx/grid.h>
+#include <wx/string.h>
+
+#include "process_store.h"
+#include "wmi_process_table.h"
+
+namespace daw {
+	// The processes of every host in one table, with a Host column first.
+	// Each host's rows are kept sorted on their own and the fleet order is a
+	// k-way merge of them.  A refresh of one host only sorts that host and
+	// merges its rows back into the order of the others, the grid is told
+	// about the rows that changed
+	struct fleet_table : public wxGridTableBase {
+		using row_id = process_store::row_id;
+		using SortOrder = wmi_process_table::SortOrder;
+
+		struct row_ref {
+			uint32_t host;
+			row_id id;
+		};
+
+		// Column 0 is the host, column n + 1 is wmi_process column n
+		static constexpr int host_column = 0;
+
+	private:
+		struct host_t {
+			wmi_process_table const *table;
+			// What the Host column shows
+			wxString label;
+			// Ascending on m_sort_column, ties on row id
+			std::vector<row_id> sorted;
+		};
+		// A shown row by table, still valid after a host is removed
+		struct shown_t {
+			wmi_process_table const *table;
+			row_id id;
+		};
+		std::vector<host_t> m_hosts;
+		std::vector<row_ref> m_rows;
+		int m_sort_column =
+		  1 + static_cast<int>( wmi_process::column_number::WorkingSetSize );
+		SortOrder m_sort_order = SortOrder::Descending;
+		// Only the first m_row_limit rows are shown, 0 shows all of them
+		size_t m_row_limit = 0;
+
+		bool less( row_ref lhs, row_ref rhs ) const;
+		bool comes_before( row_ref lhs, row_ref rhs ) const;
+		row_ref nth( uint32_t host, size_t pos ) const;
+		size_t shown_count( ) const noexcept;
+		void sort_host( host_t &host );
+		void fill( std::vector<row_ref> &rows, size_t count ) const;
+		void merge_host( uint32_t host );
+		std::vector<shown_t> shown( ) const;
+		void set_rows( std::vector<row_ref> rows, std::vector<shown_t> const &before,
+		               wmi_process_table const *updated );
+
+	public:
+		fleet_table( ) = default;
+
+		void add_host( wmi_process_table const *table );
+		void remove_host( wmi_process_table const *table );
+
+		// Call after the table's rows changed
+		void host_updated( wmi_process_table const *table );
+
+		void sort_column( int col, SortOrder sort_order = SortOrder::Next );
+
+		void set_row_limit( size_t row_limit );
+
+		// The first count rows of the current order over all hosts
+		std::vector<row_ref> top( size_t count ) const;
+
+		// Processes over all hosts, including those not shown
+		size_t total_rows( ) const noexcept;
+
+		int GetNumberRows( ) override;
+		int GetNumberCols( ) override;
+
+		wxString GetValue( int row, int col ) override;
+		wxString GetColLabelValue( int col ) override;
+
+		inline bool IsEmptyCell( int, int ) override {
+			return false;
+		}
+
+		inline void SetValue( int, int, wxString const & ) override {
+		} // Read only table
+	};
+} // namespace daw
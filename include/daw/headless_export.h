@@ -0,0 +1,64 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "process_source.h"
+#include "wmi_process.h"
+
+namespace daw {
+	enum class export_formats { Csv, Ndjson };
+
+	// The columns exported by default.  The rate columns need two samples
+	// of a process and are left out
+	column_set default_export_columns( );
+
+	struct export_options {
+		export_formats format = export_formats::Csv;
+		column_set columns = default_export_columns( );
+		// Hosts queried at the same time
+		size_t concurrency = 16;
+		// Collect again every interval, forever.  Zero collects once
+		std::chrono::seconds interval{0};
+		// Output buffered per host before it is written, this and the
+		// enumerator's batch bound the memory used per host
+		size_t buffer_size = 64 * 1024;
+		std::shared_ptr<process_source> processes = default_process_source( );
+	};
+
+	// Writes the processes of every host to out as UTF-8 CSV or NDJSON.
+	// Rows are formatted as their records arrive from the enumerator and
+	// written in blocks of whole lines, so hosts interleave but lines do
+	// not.  Each row starts with the host and the time the collection
+	// started, numbers are written raw.  A host that fails gets a line on
+	// err.  Returns the number of hosts that failed in the last collection
+	size_t export_processes( std::vector<std::wstring> const &hosts,
+	                         export_options const &opts, std::ostream &out,
+	                         std::ostream &err );
+} // namespace daw
@@ -0,0 +1,123 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace daw {
+	// A bounded multi producer/multi consumer queue that does not lock.  Each
+	// slot carries a sequence number telling producers and consumers whose
+	// turn it is, see Dmitry Vyukov's bounded MPMC queue
+	template<typename T>
+	class lockfree_queue {
+		struct cell_t {
+			std::atomic<size_t> sequence;
+			T value;
+		};
+
+		std::unique_ptr<cell_t[]> m_cells;
+		size_t m_mask;
+		alignas( 64 ) std::atomic<size_t> m_enqueue_pos{0};
+		alignas( 64 ) std::atomic<size_t> m_dequeue_pos{0};
+
+		static size_t round_up_pow2( size_t n ) noexcept {
+			size_t result = 2;
+			while( result < n ) {
+				result <<= 1U;
+			}
+			return result;
+		}
+
+	public:
+		// capacity is rounded up to a power of 2
+		explicit lockfree_queue( size_t capacity )
+		  : m_cells( std::make_unique<cell_t[]>( round_up_pow2( capacity ) ) )
+		  , m_mask( round_up_pow2( capacity ) - 1 ) {
+			for( size_t n = 0; n <= m_mask; ++n ) {
+				m_cells[n].sequence.store( n, std::memory_order_relaxed );
+			}
+		}
+
+		lockfree_queue( lockfree_queue const & ) = delete;
+		lockfree_queue &operator=( lockfree_queue const & ) = delete;
+
+		size_t capacity( ) const noexcept {
+			return m_mask + 1;
+		}
+
+		// Returns false when the queue is full, value is then left alone
+		bool try_push( T &&value ) {
+			auto pos = m_enqueue_pos.load( std::memory_order_relaxed );
+			cell_t *cell = nullptr;
+			while( true ) {
+				cell = &m_cells[pos & m_mask];
+				auto const seq = cell->sequence.load( std::memory_order_acquire );
+				auto const diff =
+				  static_cast<std::ptrdiff_t>( seq ) - static_cast<std::ptrdiff_t>( pos );
+				if( diff == 0 ) {
+					if( m_enqueue_pos.compare_exchange_weak(
+					      pos, pos + 1, std::memory_order_relaxed ) ) {
+						break;
+					}
+				} else if( diff < 0 ) {
+					return false;
+				} else {
+					pos = m_enqueue_pos.load( std::memory_order_relaxed );
+				}
+			}
+			cell->value = std::move( value );
+			cell->sequence.store( pos + 1, std::memory_order_release );
+			return true;
+		}
+
+		// Returns an empty optional when the queue is empty
+		std::optional<T> try_pop( ) {
+			auto pos = m_dequeue_pos.load( std::memory_order_relaxed );
+			cell_t *cell = nullptr;
+			while( true ) {
+				cell = &m_cells[pos & m_mask];
+				auto const seq = cell->sequence.load( std::memory_order_acquire );
+				auto const diff = static_cast<std::ptrdiff_t>( seq ) -
+				                  static_cast<std::ptrdiff_t>( pos + 1 );
+				if( diff == 0 ) {
+					if( m_dequeue_pos.compare_exchange_weak(
+					      pos, pos + 1, std::memory_order_relaxed ) ) {
+						break;
+					}
+				} else if( diff < 0 ) {
+					return std::nullopt;
+				} else {
+					pos = m_dequeue_pos.load( std::memory_order_relaxed );
+				}
+			}
+			auto result = std::optional<T>( std::move( cell->value ) );
+			cell->value = T{};
+			cell->sequence.store( pos + m_mask + 1, std::memory_order_release );
+			return result;
+		}
+	};
+} // namespace daw
@@ -0,0 +1,117 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <future>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace daw {
+	// The number of threads to use when thread_count is 0
+	inline size_t default_thread_count( size_t thread_count = 0 ) noexcept {
+		if( thread_count > 0 ) {
+			return thread_count;
+		}
+		return std::max( std::thread::hardware_concurrency( ), 1U );
+	}
+
+	// Splits [0, count) into one chunk per thread and calls
+	// func( first, last ) for each chunk, the first chunk on the calling
+	// thread.  Waits for all of them and rethrows the first exception
+	template<typename Function>
+	void parallel_for( size_t count, Function &&func, size_t thread_count = 0,
+	                   size_t min_chunk_size = 1 ) {
+		auto const chunks = std::min(
+		  default_thread_count( thread_count ),
+		  std::max( count / std::max( min_chunk_size, size_t{1} ), size_t{1} ) );
+		if( chunks < 2 ) {
+			func( size_t{0}, count );
+			return;
+		}
+		auto const bound = [&]( size_t n ) { return count * n / chunks; };
+		auto tasks = std::vector<std::future<void>>( );
+		tasks.reserve( chunks - 1 );
+		for( size_t n = 1; n < chunks; ++n ) {
+			tasks.push_back( std::async( std::launch::async, [&func, first = bound( n ),
+			                                                   last = bound( n + 1 )]( ) {
+				func( first, last );
+			} ) );
+		}
+		func( size_t{0}, bound( 1 ) );
+		for( auto &task : tasks ) {
+			task.get( );
+		}
+	}
+
+	// Same result as std::stable_sort.  Each thread sorts a chunk, then
+	// neighbouring chunks are merged pairwise, in parallel, until one is left
+	template<typename RandomIterator, typename Compare>
+	void parallel_stable_sort( RandomIterator first, RandomIterator last,
+	                           Compare less, size_t thread_count = 0 ) {
+		// Below this the threads cost more than they save
+		static constexpr size_t min_chunk_size = 4096;
+
+		auto const count = static_cast<size_t>( std::distance( first, last ) );
+		auto const chunks =
+		  std::min( default_thread_count( thread_count ),
+		            std::max( count / min_chunk_size, size_t{1} ) );
+		if( chunks < 2 ) {
+			std::stable_sort( first, last, less );
+			return;
+		}
+		auto bounds = std::vector<RandomIterator>( );
+		bounds.reserve( chunks + 1 );
+		for( size_t n = 0; n <= chunks; ++n ) {
+			bounds.push_back(
+			  first + static_cast<std::ptrdiff_t>( count * n / chunks ) );
+		}
+		parallel_for(
+		  chunks,
+		  [&]( size_t f, size_t l ) {
+			  for( ; f < l; ++f ) {
+				  std::stable_sort( bounds[f], bounds[f + 1], less );
+			  }
+		  },
+		  chunks );
+
+		for( size_t width = 1; width < chunks; width *= 2 ) {
+			auto const merges = ( chunks + 2 * width - 1 ) / ( 2 * width );
+			parallel_for(
+			  merges,
+			  [&]( size_t f, size_t l ) {
+				  for( ; f < l; ++f ) {
+					  auto const lo = f * 2 * width;
+					  auto const mid = std::min( lo + width, chunks );
+					  auto const hi = std::min( lo + 2 * width, chunks );
+					  if( mid < hi ) {
+						  std::inplace_merge( bounds[lo], bounds[mid], bounds[hi], less );
+					  }
+				  }
+			  },
+			  merges );
+		}
+	}
+} // namespace daw
@@ -0,0 +1,67 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "process_rates.h"
+#include "wmi_process.h"
+
+namespace daw {
+	// The raw values of one Win32_PerfRawData_PerfProc_Process instance.  The
+	// "per second" counters are cumulative, the rates come from process_rates
+	struct raw_process_counters {
+		uint32_t process_id = 0;
+		// When the process started, a FILETIME.  Tells a reused process id
+		// apart
+		uint64_t start_time = 0;
+		// PercentProcessorTime, in 100ns units
+		uint64_t processor_time = 0;
+		uint64_t io_read_bytes = 0;
+		uint64_t io_write_bytes = 0;
+		uint32_t page_faults = 0;
+		uint32_t thread_count = 0;
+		uint64_t working_set = 0;
+		uint64_t working_set_peak = 0;
+		uint64_t private_bytes = 0;
+		uint64_t page_file_bytes_peak = 0;
+	};
+
+	// Every process at one refresh
+	struct raw_counter_sample {
+		// Timestamp_Sys100NS, when the counters were read.  A FILETIME
+		uint64_t timestamp = 0;
+		std::vector<raw_process_counters> processes;
+	};
+
+	// The columns apply_raw_counters fills, plus the rates computed from them
+	column_set raw_counter_columns( );
+
+	// Copies the counters of raw into their columns of row
+	void apply_raw_counters( raw_process_counters const &raw, wmi_process &row );
+
+	// The time of sample on the clock of process_rates.  Only the difference
+	// between samples of one host means anything
+	process_rates::clock::time_point sample_time( raw_counter_sample const &sample );
+} // namespace daw
@@ -0,0 +1,77 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "lockfree_queue.h"
+#include "wmi_process.h"
+
+namespace daw {
+	struct process_event {
+		enum class kinds : uint_fast8_t { Started, Stopped };
+
+		kinds kind = kinds::Started;
+		// For Stopped events only the process id and creation date are used
+		wmi_process process{};
+	};
+
+	// Events are pushed from the notification threads and drained on the UI
+	// thread
+	struct process_event_queue {
+		lockfree_queue<process_event> events;
+		// An event was dropped as the queue was full.  The table can no longer
+		// trust the events and must be rebuilt from a full snapshot
+		std::atomic<bool> has_overflowed{false};
+		// The subscription ended, no more events will arrive
+		std::atomic<bool> is_closed{false};
+
+		explicit process_event_queue( size_t capacity = 4096 )
+		  : events( capacity ) {}
+
+		void push( process_event ev ) {
+			if( !events.try_push( std::move( ev ) ) ) {
+				has_overflowed = true;
+			}
+		}
+	};
+
+	// Cancels the subscription when destroyed
+	struct process_subscription {
+		process_subscription( ) = default;
+		process_subscription( process_subscription const & ) = delete;
+		process_subscription &operator=( process_subscription const & ) = delete;
+		virtual ~process_subscription( ) = default;
+	};
+
+	// Pushes a Started/Stopped event to queue for each process created or
+	// ended on machine.  Started events carry the columns in columns.  Throws
+	// when the host does not accept the subscription
+	std::unique_ptr<process_subscription>
+	subscribe_wmi_process_events( std::wstring const &machine,
+	                              column_set columns,
+	                              std::shared_ptr<process_event_queue> queue );
+} // namespace daw
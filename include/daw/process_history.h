@@ -0,0 +1,115 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "snapshot_merge.h"
+#include "wmi_process.h"
+
+namespace daw {
+	// The recent counters of every process of a host.  Each process keeps
+	// one series per counter, stored as the oldest value followed by the
+	// differences between consecutive samples, zigzag and varint encoded.
+	// Counters that barely move cost a byte a sample.  Samples older than
+	// the window, or beyond max_samples, are dropped so memory stays fixed
+	struct process_history {
+		using clock = std::chrono::steady_clock;
+		enum class series_kinds : uint_fast8_t { WorkingSet, ReadRate, WriteRate };
+		static constexpr size_t series_count = 3;
+
+		struct options_t {
+			std::chrono::seconds window = std::chrono::minutes( 10 );
+			// Per process, whatever the refresh interval
+			size_t max_samples = 600;
+		};
+
+		struct stats_t {
+			size_t process_count = 0;
+			// Samples in the window, of every process together
+			size_t sample_count = 0;
+			size_t memory_used = 0;
+			// How long the samples span
+			clock::duration span{};
+
+			// memory_used scaled to 1000 processes sampled for an hour at the
+			// current rate, 0 until there are two samples
+			double bytes_per_1k_process_hours( ) const noexcept;
+		};
+
+	private:
+		// One counter of one process
+		struct series_t {
+			// The value of the oldest sample
+			uint64_t first = 0;
+			// The value of the newest sample, the next delta is from it
+			uint64_t last = 0;
+			// A zigzag varint delta for each sample after the first
+			std::vector<uint8_t> deltas;
+
+			void push_back( uint64_t value );
+			// Forgets the oldest count samples
+			void pop_front( size_t count );
+			void decode( std::vector<uint64_t> &values ) const;
+		};
+
+		struct process_t {
+			// Sample numbers of the oldest and newest sample of the process
+			uint64_t first_sample = 0;
+			uint64_t last_sample = 0;
+			std::array<series_t, series_count> series;
+		};
+
+		options_t m_options;
+		std::unordered_map<row_key, process_t, row_key_hash> m_processes;
+		// When each sample in the window was taken, the front one is sample
+		// number m_first_sample
+		std::deque<clock::time_point> m_sample_times;
+		uint64_t m_first_sample = 0;
+		uint64_t m_next_sample = 0;
+
+		void trim( process_t &process ) const;
+
+	public:
+		process_history( ) = default;
+		explicit process_history( options_t const &options );
+
+		// Adds a sample of every process in rows, taken at now.  Processes
+		// missing from rows repeat their last value, until they have been
+		// missing for the whole window and are forgotten
+		void record( std::vector<wmi_process> const &rows, clock::time_point now );
+
+		// The samples of one counter of a process, oldest first.  Empty when
+		// there is no history for key
+		std::vector<uint64_t> series( row_key const &key, series_kinds kind ) const;
+
+		stats_t stats( ) const;
+
+		void clear( );
+	};
+} // namespace daw
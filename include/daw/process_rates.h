@@ -0,0 +1,79 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "snapshot_merge.h"
+#include "wmi_process.h"
+
+namespace daw {
+	// Turns the cumulative counters of consecutive snapshots of a host into
+	// the rate columns.  Each process is matched to its previous sample on
+	// (process id, creation date) through a hash table, so an update is O(n)
+	struct process_rates {
+		using clock = std::chrono::steady_clock;
+
+	private:
+		struct sample_t {
+			uint64_t cpu_time = 0;
+			uint64_t read_transfer_count = 0;
+			uint64_t write_transfer_count = 0;
+			uint64_t page_faults = 0;
+		};
+		std::unordered_map<row_key, sample_t, row_key_hash> m_samples;
+		// Samples of the processes passed to keep, merged by the next update
+		std::unordered_map<row_key, sample_t, row_key_hash> m_kept;
+		clock::time_point m_sample_time{};
+
+	public:
+		// Fills the rate columns of rows from the samples of the previous
+		// update, and keeps the counters of rows for the next one.  Processes
+		// seen for the first time, or whose counters went backwards, get a
+		// rate of 0.  CPU usage is of one core, a process using two cores
+		// fully is at 200%
+		void update( std::vector<wmi_process> &rows, clock::time_point now );
+
+		// Keeps the counters of row for the next update without filling in
+		// its rates.  Lets the processes a top_selector ranked but did not
+		// keep have a sample next time
+		void keep( wmi_process const &row );
+
+		// How much the counter rate_column is the rate of grew since the last
+		// update, 0 when it went backwards.  The counter itself when row has
+		// no sample there
+		uint64_t counter_change( wmi_process const &row,
+		                         wmi_process::column_number rate_column ) const;
+
+		// Forget the samples, the next update starts over
+		void clear( );
+
+		// Processes with a sample
+		size_t size( ) const noexcept {
+			return m_samples.size( );
+		}
+	};
+} // namespace daw
@@ -0,0 +1,161 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "process_rates.h"
+#include "wmi_process.h"
+
+namespace daw {
+	struct process_event_queue;
+	struct process_subscription;
+
+	// The counter columns of every process at one refresh
+	struct counter_sample {
+		std::vector<wmi_process> processes;
+		// When the host read the counters, on a clock of its own.  Empty when
+		// only the time the rows arrived is known
+		std::optional<process_rates::clock::time_point> time;
+	};
+
+	// Where the process tables come from.  Only the columns asked for need to
+	// be filled in, the other members are left defaulted.  Safe to call from
+	// several threads at once
+	struct process_source {
+		process_source( ) = default;
+		process_source( process_source const & ) = delete;
+		process_source &operator=( process_source const & ) = delete;
+		virtual ~process_source( );
+
+		virtual std::vector<wmi_process>
+		get_processes( std::wstring const &host, column_set columns ) = 0;
+
+		// Only the processes in process_ids, the ones that have ended are left
+		// out
+		virtual std::vector<wmi_process>
+		get_processes( std::wstring const &host, column_set columns,
+		               std::vector<uint32_t> const &process_ids ) = 0;
+
+		// The columns of get_processes, with the time of the sample when the
+		// source knows it.  Only used for refreshes of the counter columns
+		virtual counter_sample get_counters( std::wstring const &host,
+		                                     column_set columns );
+
+		// Calls func with each process as it is read, without collecting them
+		virtual void
+		for_each_process( std::wstring const &host, column_set columns,
+		                  std::function<void( wmi_process const & )> const &func ) = 0;
+
+		// The first count processes ordered on sort_column, see
+		// get_wmi_win32_process_top.  Ranks the processes of for_each_process
+		// unless the source can do better.  rates, when set, are the previous
+		// samples of host, see top_selector
+		virtual top_processes get_top_processes( std::wstring const &host,
+		                                         column_set columns,
+		                                         wmi_process::column_number sort_column,
+		                                         bool is_ascending, size_t count,
+		                                         process_rates *rates );
+
+		// Pushes process start/stop events to queue.  Null when the source
+		// cannot send them and has to be polled, throws when host refuses
+		virtual std::unique_ptr<process_subscription>
+		subscribe_events( std::wstring const &host, column_set columns,
+		                  std::shared_ptr<process_event_queue> queue );
+
+		virtual void terminate_process( std::wstring const &host, uint32_t pid ) = 0;
+	};
+
+	// Ranks the processes offered to it, keeping the first count in sort order
+	// with ties on ProcessId.  A rate column ranks on how much the counter it
+	// is the rate of grew since the last update of rates, like the grid's
+	// rate sort, and every process offered is sampled for the next one.  A
+	// process without a sample, or every process without rates, ranks on the
+	// counter itself
+	class top_selector {
+		struct entry_t {
+			// The change of the counter a rate column ranks on
+			uint64_t rank = 0;
+			wmi_process row;
+		};
+		std::vector<entry_t> m_heap;
+		wmi_process::column_number m_sort_column;
+		bool m_is_ascending;
+		size_t m_count;
+		process_rates *m_rates;
+		size_t m_total = 0;
+		// The rank of the key is_kept last accepted
+		uint64_t m_rank = 0;
+
+		bool is_rate_column( ) const noexcept;
+		uint64_t rank_of( wmi_process const &row ) const;
+		bool comes_first( uint64_t lhs_rank, wmi_process const &lhs,
+		                  uint64_t rhs_rank, wmi_process const &rhs ) const;
+		bool comes_first( entry_t const &lhs, entry_t const &rhs ) const;
+
+	public:
+		top_selector( wmi_process::column_number sort_column, bool is_ascending,
+		              size_t count, process_rates *rates = nullptr );
+
+		// Counts one more process and whether it makes the cut.  key only needs
+		// the columns of sort_key_columns
+		bool is_kept( wmi_process const &key );
+
+		// Keeps row, which is_kept just accepted
+		void keep( wmi_process &&row );
+
+		void offer( wmi_process const &row ) {
+			if( is_kept( row ) ) {
+				keep( wmi_process( row ) );
+			}
+		}
+
+		top_processes take( ) &&;
+	};
+
+	// The columns is_kept reads
+	column_set sort_key_columns( wmi_process::column_number sort_column );
+
+	// Win32_Process through WMI, on the local or a remote host
+	std::shared_ptr<process_source> make_wmi_process_source( );
+
+	// Win32_Process, with the counter only refreshes taken from a
+	// high-performance refresher on Win32_PerfRawData_PerfProc_Process.  Falls
+	// back to Win32_Process on hosts without those counters
+	std::shared_ptr<process_source> make_wmi_refresher_process_source( );
+
+	// Reads /proc/[pid]/... on Linux.  Only knows the local host, "" or ".".
+	// Linux has no page file usage, it is approximated by data plus stack
+	// and its peak by VmPeak, the peak virtual size.  That is an upper bound,
+	// often well above any page file usage the process had
+	std::shared_ptr<process_source>
+	make_proc_process_source( std::string proc_root = "/proc" );
+
+	// The native source of the platform, shared by every table
+	std::shared_ptr<process_source> const &default_process_source( );
+} // namespace daw
@@ -0,0 +1,383 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <cstdint>
+#include <exception>
+#include <numeric>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <wx/string.h>
+
+#include "column_items.h"
+#include "snapshot_merge.h"
+#include "string_arena.h"
+#include "wmi_process.h"
+
+namespace daw {
+	// A read only view of one column of a process_store, indexed by row id
+	template<typename T>
+	struct column_view {
+		T const *first = nullptr;
+		size_t count = 0;
+
+		T const &operator[]( size_t id ) const noexcept {
+			return first[id];
+		}
+
+		T const *begin( ) const noexcept {
+			return first;
+		}
+
+		T const *end( ) const noexcept {
+			return first + count;
+		}
+
+		size_t size( ) const noexcept {
+			return count;
+		}
+	};
+
+	// The processes of one host stored column by column.  Rows keep their id
+	// for as long as the process is in the store, removed rows are zeroed and
+	// reused.  Strings are interned in strings and the string columns hold
+	// their ids
+	struct process_store {
+		using row_id = uint32_t;
+		using string_id = string_arena::string_id;
+		using column_number = wmi_process::column_number;
+		enum class column_kinds : uint_fast8_t {
+			String,
+			Integer,
+			Memory,
+			Date,
+			Percent
+		};
+
+		std::vector<string_id> name;
+		std::vector<string_id> command_line;
+		std::vector<string_id> handle;
+		std::vector<uint32_t> process_id;
+		std::vector<uint32_t> parent_process_id;
+		std::vector<uint32_t> session_id;
+		// wxDateTime milliseconds since the epoch
+		std::vector<int64_t> creation_date;
+		std::vector<uint32_t> thread_count;
+		std::vector<uint32_t> page_faults;
+		std::vector<uint64_t> page_file_usage;
+		std::vector<uint64_t> peak_page_file_usage;
+		std::vector<uint64_t> working_set_size;
+		std::vector<uint64_t> peak_working_set_size;
+		std::vector<uint64_t> read_transfer_count;
+		std::vector<uint64_t> write_transfer_count;
+		// Hundredths of a percent
+		std::vector<uint32_t> cpu_usage;
+		std::vector<uint64_t> read_rate;
+		std::vector<uint64_t> write_rate;
+		std::vector<uint32_t> page_fault_rate;
+
+		string_arena strings;
+		// folded_sort_key of each string in strings, by string id.  Id 0 is
+		// the empty string, whose key is 0
+		std::vector<uint64_t> string_keys = std::vector<uint64_t>( 1, 0 );
+		std::vector<row_id> free_rows;
+		// The row of each key, see find
+		std::unordered_map<row_key, row_id, row_key_hash> rows_by_key;
+
+		template<column_number col>
+		static constexpr auto member( ) noexcept {
+			if constexpr( col == column_number::Name ) {
+				return &process_store::name;
+			} else if constexpr( col == column_number::ProcessId ) {
+				return &process_store::process_id;
+			} else if constexpr( col == column_number::ParentProcessId ) {
+				return &process_store::parent_process_id;
+			} else if constexpr( col == column_number::SessionId ) {
+				return &process_store::session_id;
+			} else if constexpr( col == column_number::Handle ) {
+				return &process_store::handle;
+			} else if constexpr( col == column_number::CreationDate ) {
+				return &process_store::creation_date;
+			} else if constexpr( col == column_number::ThreadCount ) {
+				return &process_store::thread_count;
+			} else if constexpr( col == column_number::PageFaults ) {
+				return &process_store::page_faults;
+			} else if constexpr( col == column_number::WorkingSetSize ) {
+				return &process_store::working_set_size;
+			} else if constexpr( col == column_number::PeakWorkingSetSize ) {
+				return &process_store::peak_working_set_size;
+			} else if constexpr( col == column_number::PageFileUsage ) {
+				return &process_store::page_file_usage;
+			} else if constexpr( col == column_number::PeakPageFileUsage ) {
+				return &process_store::peak_page_file_usage;
+			} else if constexpr( col == column_number::ReadTransferCount ) {
+				return &process_store::read_transfer_count;
+			} else if constexpr( col == column_number::WriteTransferCount ) {
+				return &process_store::write_transfer_count;
+			} else if constexpr( col == column_number::CpuUsage ) {
+				return &process_store::cpu_usage;
+			} else if constexpr( col == column_number::ReadRate ) {
+				return &process_store::read_rate;
+			} else if constexpr( col == column_number::WriteRate ) {
+				return &process_store::write_rate;
+			} else if constexpr( col == column_number::PageFaultRate ) {
+				return &process_store::page_fault_rate;
+			} else {
+				static_assert( col == column_number::CommandLine,
+				               "Unknown column" );
+				return &process_store::command_line;
+			}
+		}
+
+		template<column_number col>
+		static constexpr column_kinds column_kind( ) noexcept {
+			switch( col ) {
+			case column_number::Name:
+			case column_number::Handle:
+			case column_number::CommandLine:
+				return column_kinds::String;
+			case column_number::CreationDate:
+				return column_kinds::Date;
+			case column_number::PageFileUsage:
+			case column_number::PeakPageFileUsage:
+			case column_number::WorkingSetSize:
+			case column_number::PeakWorkingSetSize:
+			case column_number::ReadTransferCount:
+			case column_number::WriteTransferCount:
+			case column_number::ReadRate:
+			case column_number::WriteRate:
+				return column_kinds::Memory;
+			case column_number::CpuUsage:
+				return column_kinds::Percent;
+			default:
+				return column_kinds::Integer;
+			}
+		}
+
+		template<column_number col>
+		auto view( ) const noexcept {
+			auto const &values = this->*member<col>( );
+			using value_t = typename std::decay_t<decltype( values )>::value_type;
+			return column_view<value_t>{values.data( ), values.size( )};
+		}
+
+		// Calls func with the column number as a std::integral_constant, so
+		// that the column specific code is chosen once and not per row
+		template<typename Function>
+		static decltype( auto ) visit_column( column_number col,
+		                                      Function &&func ) {
+			using cn = column_number;
+			switch( col ) {
+			case cn::Name:
+				return func( std::integral_constant<cn, cn::Name>{} );
+			case cn::ProcessId:
+				return func( std::integral_constant<cn, cn::ProcessId>{} );
+			case cn::ParentProcessId:
+				return func( std::integral_constant<cn, cn::ParentProcessId>{} );
+			case cn::SessionId:
+				return func( std::integral_constant<cn, cn::SessionId>{} );
+			case cn::Handle:
+				return func( std::integral_constant<cn, cn::Handle>{} );
+			case cn::CreationDate:
+				return func( std::integral_constant<cn, cn::CreationDate>{} );
+			case cn::ThreadCount:
+				return func( std::integral_constant<cn, cn::ThreadCount>{} );
+			case cn::PageFaults:
+				return func( std::integral_constant<cn, cn::PageFaults>{} );
+			case cn::WorkingSetSize:
+				return func( std::integral_constant<cn, cn::WorkingSetSize>{} );
+			case cn::PeakWorkingSetSize:
+				return func( std::integral_constant<cn, cn::PeakWorkingSetSize>{} );
+			case cn::PageFileUsage:
+				return func( std::integral_constant<cn, cn::PageFileUsage>{} );
+			case cn::PeakPageFileUsage:
+				return func( std::integral_constant<cn, cn::PeakPageFileUsage>{} );
+			case cn::ReadTransferCount:
+				return func( std::integral_constant<cn, cn::ReadTransferCount>{} );
+			case cn::WriteTransferCount:
+				return func( std::integral_constant<cn, cn::WriteTransferCount>{} );
+			case cn::CommandLine:
+				return func( std::integral_constant<cn, cn::CommandLine>{} );
+			case cn::CpuUsage:
+				return func( std::integral_constant<cn, cn::CpuUsage>{} );
+			case cn::ReadRate:
+				return func( std::integral_constant<cn, cn::ReadRate>{} );
+			case cn::WriteRate:
+				return func( std::integral_constant<cn, cn::WriteRate>{} );
+			case cn::PageFaultRate:
+				return func( std::integral_constant<cn, cn::PageFaultRate>{} );
+			default:
+				std::terminate( );
+			}
+		}
+
+		// Number of row ids in use, including free ones
+		size_t capacity( ) const noexcept {
+			return process_id.size( );
+		}
+
+		size_t size( ) const noexcept {
+			return capacity( ) - free_rows.size( );
+		}
+
+		row_id add( wmi_process const &row );
+		// The row as a wmi_process, the reverse of add
+		wmi_process to_process( row_id id ) const;
+		void remove( row_id id );
+		// Drops id from rows_by_key, before its key changes
+		void unindex( row_id id );
+		void clear( );
+
+		// Copy column col of row into the store
+		void assign( row_id id, column_number col, wmi_process const &row );
+		bool is_equal( row_id id, column_number col, wmi_process const &row ) const;
+
+		row_key key( row_id id ) const noexcept {
+			return {process_id[id], creation_date[id]};
+		}
+
+		// The row whose key is key, one of them when several rows share it
+		std::optional<row_id> find( row_key const &key ) const {
+			auto pos = rows_by_key.find( key );
+			if( pos == rows_by_key.end( ) ) {
+				return std::nullopt;
+			}
+			return pos->second;
+		}
+
+		std::wstring_view string_value( row_id id, column_number col ) const;
+
+		static column_kinds column_kind( column_number col ) {
+			return visit_column(
+			  col, []( auto c ) { return column_kind<decltype( c )::value>( ); } );
+		}
+
+		// The value of a numeric column as 64 bits, dates keep their bit
+		// pattern.  For string columns this is the string id
+		uint64_t numeric_value( row_id id, column_number col ) const {
+			return visit_column( col, [&]( auto c ) {
+				return static_cast<uint64_t>( view<decltype( c )::value>( )[id] );
+			} );
+		}
+
+		// <0, 0, >0 like strcmp
+		int compare( column_number col, row_id lhs, row_id rhs ) const;
+
+		wxString to_string( row_id id, column_number col ) const;
+
+		// Sum of a numeric column over all rows.  Free rows are zero so this
+		// runs over the whole column
+		template<column_number col>
+		uint64_t total( ) const {
+			static_assert( column_kind<col>( ) == column_kinds::Integer ||
+			                 column_kind<col>( ) == column_kinds::Memory ||
+			                 column_kind<col>( ) == column_kinds::Percent,
+			               "Only numeric columns can be totalled" );
+			auto const values = view<col>( );
+			return std::accumulate( values.begin( ), values.end( ), uint64_t{0} );
+		}
+
+		// Rebuild the string arena with only the strings still referenced
+		void compact_strings( );
+
+		// Interns str and keeps its sort key
+		string_id intern( std::wstring_view str );
+
+		// Orders two interned strings like compare_nocase, mostly from their
+		// sort keys
+		int compare_strings( string_id lhs, string_id rhs ) const noexcept {
+			if( lhs == rhs ) {
+				return 0;
+			}
+			if( string_keys[lhs] != string_keys[rhs] ) {
+				return string_keys[lhs] < string_keys[rhs] ? -1 : 1;
+			}
+			return compare_nocase( strings[lhs], strings[rhs] );
+		}
+
+		// The case insensitive order of every string in the arena, strings
+		// that compare equal share a rank.  Sorting on ranks avoids folding
+		// the same strings over and over again
+		std::vector<uint32_t> string_ranks( ) const;
+
+		// Ranks only the given ids, the arena also holds command lines and
+		// handles that a Name sort never looks at.  Entries of other ids are
+		// left 0
+		std::vector<uint32_t> string_ranks( std::vector<string_id> ids ) const;
+	};
+
+	// One column of a process_store copied out for sorting, so that the sort
+	// can run on another thread while the store keeps changing.  String
+	// entries point into the store's string arena, it must not be compacted
+	// until the sort is done
+	struct sort_snapshot {
+		struct entry_t {
+			// The value, in an order preserving form, or the string's sort key
+			uint64_t key;
+			std::wstring_view text;
+			process_store::row_id id;
+		};
+		std::vector<entry_t> entries;
+		bool is_ascending = true;
+
+		// Sorts like sort_rows, returns the row ids in their new order
+		std::vector<process_store::row_id> sort( size_t thread_count = 0 );
+	};
+
+	// Orders rows of two stores on col, like process_store::compare does rows
+	// of one store
+	int compare_rows( process_store const &lhs_store, process_store::row_id lhs,
+	                  process_store const &rhs_store, process_store::row_id rhs,
+	                  process_store::column_number col );
+
+	sort_snapshot make_sort_snapshot( process_store const &store,
+	                                  std::vector<process_store::row_id> const &rows,
+	                                  process_store::column_number col,
+	                                  bool is_ascending );
+
+	// Sorts the row ids in rows on column col.  Equal values are ordered on
+	// their row id, so that descending is ascending read backwards.  The
+	// comparison is chosen once per sort and works on the raw column values,
+	// string columns are sorted on their ranks
+	void sort_rows( process_store const &store,
+	                std::vector<process_store::row_id> &rows,
+	                process_store::column_number col, bool is_ascending );
+
+	// The ascending order of rows on col, starting from previous, an
+	// ascending order from before the store changed.  Only the rows that
+	// moved or are new are sorted and then merged back in, so this is about
+	// linear when little changed
+	std::vector<process_store::row_id>
+	resort_rows( process_store const &store,
+	             std::vector<process_store::row_id> const &previous,
+	             std::vector<process_store::row_id> const &rows,
+	             process_store::column_number col );
+
+	// The key of row, as process_store::key returns it once row is added.
+	// Processes without a creation date, e.g. the System Idle Process, share
+	// one so that they keep their key from one snapshot to the next
+	row_key key_of( wmi_process const &row );
+} // namespace daw
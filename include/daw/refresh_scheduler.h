@@ -0,0 +1,140 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace daw {
+	struct refresh_scheduler_options {
+		// Refreshes running at the same time, across all hosts
+		size_t worker_count = 4;
+		// Time between refreshes of a host that is shown
+		std::chrono::milliseconds visible_interval = std::chrono::seconds( 2 );
+		// Time between refreshes of a host that is not shown
+		std::chrono::milliseconds hidden_interval = std::chrono::seconds( 15 );
+		// Each interval is randomly lengthened or shortened by up to this
+		// fraction so that hosts added together do not refresh together
+		double jitter = 0.2;
+		// A refresh that has not finished this long after it started counts
+		// as a missed deadline.  The host then backs off, its next refresh
+		// waits twice its interval, four times after the next miss, and so on
+		std::chrono::milliseconds deadline = std::chrono::seconds( 10 );
+		// The most the interval of a host that keeps missing its deadline is
+		// multiplied by
+		uint32_t max_backoff = 16;
+	};
+
+	// Refreshes many hosts with a fixed number of worker threads.  Each host
+	// has at most one refresh running, due refreshes of visible hosts go
+	// before hidden ones and otherwise the one due first goes first.  The
+	// scheduler knows nothing about the UI, refresh and on_done are called on
+	// a worker thread
+	class refresh_scheduler {
+	public:
+		using host_id = uint64_t;
+		using clock_t = std::chrono::steady_clock;
+		// Does the work, e.g. wmi_process_table::update_data
+		using refresh_function = std::function<void( )>;
+		// Called after each refresh, with the exception refresh threw if any
+		using done_function = std::function<void( std::exception_ptr )>;
+
+		struct host_stats {
+			size_t refresh_count = 0;
+			size_t error_count = 0;
+			size_t missed_deadlines = 0;
+			// Time from when a refresh was due until it started
+			clock_t::duration total_wait{};
+			clock_t::duration max_wait{};
+			clock_t::duration last_duration{};
+		};
+
+	private:
+		struct host_t {
+			refresh_function refresh;
+			done_function on_done;
+			clock_t::time_point due;
+			bool is_visible = false;
+			bool is_running = false;
+			// Refresh again as soon as the running refresh is done
+			bool is_requested = false;
+			bool is_removed = false;
+			// Deadlines missed since the last refresh that was on time
+			uint32_t missed_in_row = 0;
+			host_stats stats;
+		};
+
+		refresh_scheduler_options m_opts;
+		mutable std::mutex m_mutex;
+		std::condition_variable m_wake;
+		// Signalled when a refresh finishes, for remove_host
+		std::condition_variable m_finished;
+		std::unordered_map<host_id, host_t> m_hosts;
+		host_id m_next_id = 1;
+		bool m_is_stopping = false;
+		std::mt19937 m_rng;
+		std::vector<std::thread> m_workers;
+
+		clock_t::duration next_interval( bool is_visible );
+		clock_t::duration backoff_interval( host_t const &host );
+		host_t *next_due( clock_t::time_point now, host_id &id );
+		void request_refresh( host_t &host );
+		void run_worker( );
+
+	public:
+		explicit refresh_scheduler( refresh_scheduler_options opts = {} );
+		refresh_scheduler( refresh_scheduler const & ) = delete;
+		refresh_scheduler &operator=( refresh_scheduler const & ) = delete;
+		// Waits for the running refreshes
+		~refresh_scheduler( );
+
+		// The first refresh is due right away
+		host_id add_host( refresh_function refresh, done_function on_done,
+		                  bool is_visible = false );
+
+		// Waits for a running refresh of the host to finish, so that
+		// whatever refresh uses can be destroyed afterwards.  Must not be
+		// called from refresh or on_done
+		void remove_host( host_id id );
+
+		// A host becoming visible is refreshed right away, unless it is backing
+		// off
+		void set_visible( host_id id, bool is_visible );
+
+		// Refresh as soon as a worker is free, unless the host is backing off
+		// after missing its deadline
+		void refresh_now( host_id id );
+
+		host_stats stats( host_id id ) const;
+		size_t host_count( ) const;
+	};
+} // namespace daw
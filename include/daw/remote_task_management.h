@@ -26,13 +26,20 @@
 #include <wx/app.h>
 #include <wx/string.h>
 
+#include "headless_export.h"
+
 namespace daw {
 	class remote_task_management_app : public wxApp {
 		std::vector<wxString> m_remote_hosts;
+		// Write the process tables to stdout instead of showing the frame
+		bool m_is_headless = false;
+		export_options m_export_options;
 
 	public:
 		remote_task_management_app( ) = default;
 		bool OnInit( ) override;
+		int OnRun( ) override;
+		int OnExit( ) override;
 		void OnInitCmdLine( wxCmdLineParser &parser ) override;
 		bool OnCmdLineParsed( wxCmdLineParser &parser ) override;
 	};
@@ -22,21 +22,57 @@
 //
 #pragma once
 
+#include <exception>
+#include <memory>
 #include <vector>
 #include <wx/event.h>
 #include <wx/frame.h>
+#include <wx/grid.h>
 #include <wx/notebook.h>
 #include <wx/string.h>
 #include <wx/timer.h>
 
 #include <daw/daw_utility.h>
 
+#include "refresh_scheduler.h"
+
 namespace daw {
+	struct fleet_table;
+	struct wmi_process_table;
+
 	class remote_task_management_frame : public wxFrame {
 		std::unique_ptr<wxTimer> m_tmr = nullptr;
 		daw::non_owning_ptr<wxNotebook *> m_notebook = nullptr; 
+		// Refreshes every host's table, shown pages more often
+		std::unique_ptr<refresh_scheduler> m_scheduler =
+		  std::make_unique<refresh_scheduler>( );
+
+		struct page_t {
+			wxGrid *grid;
+			wmi_process_table *table;
+			refresh_scheduler::host_id host_id;
+			// Why the last refresh failed, empty once one succeeds
+			wxString error;
+		};
+		std::vector<page_t> m_pages;
+		// Owned by m_fleet_grid, null until the fleet page is opened
+		fleet_table *m_fleet = nullptr;
+		wxGrid *m_fleet_grid = nullptr;
+		// Rows shown per host, 0 shows every process
+		size_t m_row_limit = 0;
 
 		void add_page( wxString const &host );
+		void add_recording_page( wxString const &path );
+		void add_table_page( wmi_process_table *tbl, wxString const &title );
+		page_t *find_page( wxWindow const *grid );
+		void close_page( page_t const &page );
+		void on_refreshed( wxGrid *grid, std::exception_ptr error );
+		void on_streamed( wxGrid *grid );
+		void on_page_changed( );
+		void apply_events( );
+		void show_fleet( );
+		void set_row_limit( size_t count );
+		void update_status( );
 		void setup_handlers( );
 		void setup_menus( );
 		void setup_notebook( );
@@ -46,5 +82,6 @@ namespace daw {
 		  std::vector<wxString> const &connect_to, wxString const &title,
 		  wxPoint const &pos = wxDefaultPosition,
 		  wxSize const &size = wxDefaultSize );
+		~remote_task_management_frame( ) override;
 	};
 } // namespace daw
\ No newline at end of file
@@ -0,0 +1,97 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <wx/string.h>
+
+#include "snapshot_merge.h"
+
+namespace daw {
+	// A fixed size cache of formatted cells.  Entries are found by row and
+	// column and are only used while the raw value they were formatted from
+	// is unchanged, so nothing needs invalidating when rows change.  A new
+	// entry replaces whatever was in its slot, the grid only asks for the
+	// visible cells so a few thousand slots cover the viewport
+	class render_cache {
+		struct entry_t {
+			row_key key{};
+			uint64_t raw_value = 0;
+			size_t column = static_cast<size_t>( -1 );
+			wxString text;
+		};
+		std::vector<entry_t> m_entries;
+		size_t m_hits = 0;
+		size_t m_misses = 0;
+
+		size_t slot( row_key const &key, size_t column ) const noexcept {
+			auto const h = row_key_hash{}( key ) ^ ( column * 0x9e3779b97f4a7c15ULL );
+			return ( h ^ ( h >> 17U ) ) & ( m_entries.size( ) - 1 );
+		}
+
+	public:
+		// capacity is rounded up to a power of 2
+		explicit render_cache( size_t capacity = 4096 ) {
+			size_t size = 1;
+			while( size < capacity ) {
+				size <<= 1U;
+			}
+			m_entries.resize( size );
+		}
+
+		// Returns the cached text for the cell, calling format( ) when it is
+		// not cached or raw_value changed
+		template<typename Format>
+		wxString const &get( row_key const &key, size_t column, uint64_t raw_value,
+		                     Format &&format ) {
+			auto &entry = m_entries[slot( key, column )];
+			if( entry.column == column && entry.raw_value == raw_value &&
+			    entry.key == key ) {
+				++m_hits;
+				return entry.text;
+			}
+			++m_misses;
+			entry.key = key;
+			entry.column = column;
+			entry.raw_value = raw_value;
+			entry.text = format( );
+			return entry.text;
+		}
+
+		void clear( ) {
+			for( auto &entry : m_entries ) {
+				entry = entry_t{};
+			}
+		}
+
+		size_t hits( ) const noexcept {
+			return m_hits;
+		}
+
+		size_t misses( ) const noexcept {
+			return m_misses;
+		}
+	};
+} // namespace daw
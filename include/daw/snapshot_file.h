@@ -0,0 +1,156 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "snapshot_merge.h"
+#include "wmi_process.h"
+
+namespace daw {
+	// Recorded snapshots of one host, for replaying them later.  The file is
+	// a header followed by frames, each a kind byte, a 32bit payload size, a
+	// 64bit timestamp and the payload.  It is only ever appended to, a frame
+	// cut short by a crash is ignored when reading.
+	//
+	// Strings frames add to the string table, which is shared by all the
+	// snapshots.  Snapshot frames hold one row per process: the index of the
+	// process in the previous snapshot, a bit mask of the columns that changed
+	// and, for those, the zigzag varint difference.  Keyframes compare every
+	// row against zero so that reading can start from them
+	namespace snapshot_file {
+		using clock = std::chrono::system_clock;
+
+		struct writer_options_t {
+			// Snapshots between keyframes
+			size_t keyframe_interval = 30;
+		};
+
+		struct writer {
+			using raw_row = std::array<uint64_t, wmi_process::column_count>;
+
+		private:
+			struct file_closer {
+				void operator( )( std::FILE *f ) const noexcept;
+			};
+			std::unique_ptr<std::FILE, file_closer> m_file;
+			writer_options_t m_options;
+			std::unordered_map<std::wstring, uint64_t> m_string_ids;
+			std::vector<raw_row> m_previous;
+			std::unordered_map<row_key, size_t, row_key_hash> m_previous_index;
+			size_t m_snapshot_count = 0;
+			std::vector<uint8_t> m_buffer;
+
+			void write_frame( uint8_t kind, clock::time_point time );
+
+		public:
+			// Creates or truncates path.  Throws std::runtime_error on failure
+			explicit writer( std::string const &path,
+			                 writer_options_t const &options = {} );
+
+			void append( std::vector<wmi_process> const &rows, clock::time_point time );
+
+			// rows holds every process, but the ones already in the previous
+			// snapshot only hold the columns in columns.  Their other columns
+			// are carried over from that snapshot
+			void append( std::vector<wmi_process> const &rows, column_set columns,
+			             clock::time_point time );
+
+			size_t snapshot_count( ) const noexcept {
+				return m_snapshot_count;
+			}
+		};
+
+		struct reader {
+			using raw_row = writer::raw_row;
+
+		private:
+			struct mapping;
+			struct snapshot_t {
+				clock::time_point time;
+				size_t offset = 0;
+				size_t size = 0;
+				bool is_keyframe = false;
+			};
+			std::unique_ptr<mapping> m_mapping;
+			std::vector<std::wstring> m_strings;
+			std::vector<snapshot_t> m_snapshots;
+			// The last snapshot decoded, so that reading in order only
+			// decodes each frame once
+			std::vector<raw_row> m_current;
+			size_t m_current_index = static_cast<size_t>( -1 );
+
+			void decode( size_t n );
+
+		public:
+			// Maps path into memory and indexes its frames.  Throws
+			// std::runtime_error when it is not a snapshot file
+			explicit reader( std::string const &path );
+			~reader( );
+			reader( reader && ) noexcept;
+			reader &operator=( reader && ) noexcept;
+
+			size_t size( ) const noexcept {
+				return m_snapshots.size( );
+			}
+
+			clock::time_point time( size_t n ) const {
+				return m_snapshots[n].time;
+			}
+
+			// The last snapshot taken at or before time, or the first one
+			size_t find( clock::time_point time ) const;
+
+			std::vector<wmi_process> read( size_t n );
+		};
+	} // namespace snapshot_file
+
+	// Plays a recording back as a host, one snapshot per call.  Safe to
+	// seek from one thread while another reads
+	struct replay_source {
+	private:
+		std::shared_ptr<snapshot_file::reader> m_reader;
+		size_t m_position = 0;
+		mutable std::mutex m_mutex;
+
+	public:
+		explicit replay_source( std::shared_ptr<snapshot_file::reader> reader );
+
+		// The snapshot at the current position, then moves to the next one.
+		// The last snapshot repeats once the end is reached
+		std::vector<wmi_process> operator( )( );
+
+		void seek( snapshot_file::clock::time_point time );
+
+		size_t position( ) const;
+	};
+} // namespace daw
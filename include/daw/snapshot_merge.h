@@ -0,0 +1,326 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace daw {
+	// Identifies the same row across snapshots.  For processes this is the
+	// process id and creation time as process ids are reused
+	struct row_key {
+		uint64_t id = 0;
+		int64_t created = 0;
+	};
+
+	inline bool operator==( row_key const &lhs, row_key const &rhs ) noexcept {
+		return lhs.id == rhs.id && lhs.created == rhs.created;
+	}
+
+	struct row_key_hash {
+		size_t operator( )( row_key const &key ) const noexcept {
+			auto const h = std::hash<uint64_t>{}( key.id );
+			return h ^ ( std::hash<int64_t>{}( key.created ) + 0x9e3779b97f4a7c15ULL +
+			             ( h << 6U ) + ( h >> 2U ) );
+		}
+	};
+
+	struct merge_stats {
+		size_t rows_added = 0;
+		size_t rows_removed = 0;
+		// Rows whose sort column changed and had to be repositioned
+		size_t rows_moved = 0;
+		size_t rows_unchanged = 0;
+		size_t cells_changed = 0;
+		// The whole table was replaced as too much of it changed
+		bool is_reset = false;
+	};
+
+	struct merge_options {
+		// Rows that are not in the new snapshot are removed
+		bool remove_missing = true;
+		// Rows that are only in the new snapshot are added
+		bool add_new = true;
+		// When most rows changed, replace rows with next instead of merging.
+		// Only valid when next holds every column
+		bool allow_reset = true;
+	};
+
+	// Merges the snapshot next into rows, a list of row ids in display order
+	// that is ordered by store.less on sort_column, or unordered when
+	// sort_column is negative.  The rows themselves live in store, which is
+	// accessed through
+	//   key( id ), key( next_row )
+	//   is_equal( id, next_row, col )
+	//   assign( id, next_row, column_mask ) - copy the columns in column_mask
+	//   add( next_row ) -> id
+	//   remove( id )
+	//   less( lhs_id, rhs_id )
+	// next only needs to hold the columns in column_mask(bit n is column n).
+	// Rows that did not change keep their position and only changed cells are
+	// reported.
+	//
+	// Observer is called with
+	//   on_rows_deleted( pos, count ) - highest positions first
+	//   on_rows_inserted( pos, count ) - lowest positions first, each valid at
+	//                                     the time
+	//   on_cell_changed( row, col ) - final positions, after all of the above
+	template<typename Id, typename Next, typename Store, typename Observer>
+	merge_stats merge_rows( std::vector<Id> &rows, std::vector<Next> &&next,
+	                        uint64_t column_mask, int sort_column,
+	                        merge_options opts, Store &&store,
+	                        Observer &&observer ) {
+		static constexpr auto npos = static_cast<size_t>( -1 );
+		using mask_t = uint64_t;
+		enum class row_state : uint_fast8_t { Untouched, Update, Move, Remove };
+
+		auto result = merge_stats{};
+		auto const old_size = rows.size( );
+		auto const is_sort_fetched =
+		  sort_column >= 0 && ( column_mask & ( mask_t{1} << sort_column ) ) != 0;
+		auto const less = [&store]( Id lhs, Id rhs ) {
+			return store.less( lhs, rhs );
+		};
+
+		auto next_index = std::unordered_map<row_key, size_t, row_key_hash>( );
+		next_index.reserve( next.size( ) );
+		for( size_t n = 0; n < next.size( ); ++n ) {
+			next_index.try_emplace( store.key( next[n] ), n );
+		}
+
+		auto is_matched = std::vector<bool>( next.size( ), false );
+		auto state = std::vector<row_state>( old_size, row_state::Untouched );
+		auto match = std::vector<size_t>( old_size, npos );
+		for( size_t n = 0; n < old_size; ++n ) {
+			auto pos = next_index.find( store.key( rows[n] ) );
+			if( pos == next_index.end( ) || is_matched[pos->second] ) {
+				if( opts.remove_missing ) {
+					++result.rows_removed;
+					state[n] = row_state::Remove;
+				}
+				continue;
+			}
+			is_matched[pos->second] = true;
+			match[n] = pos->second;
+			auto const sc = static_cast<size_t>( sort_column );
+			if( is_sort_fetched &&
+			    !store.is_equal( rows[n], next[pos->second], sc ) ) {
+				++result.rows_moved;
+				state[n] = row_state::Move;
+			} else {
+				state[n] = row_state::Update;
+			}
+		}
+		auto added = std::vector<size_t>( );
+		if( opts.add_new ) {
+			for( size_t n = 0; n < next.size( ); ++n ) {
+				if( !is_matched[n] ) {
+					added.push_back( n );
+				}
+			}
+			result.rows_added = added.size( );
+		}
+
+		if( opts.allow_reset && opts.add_new && opts.remove_missing &&
+		    ( result.rows_added + result.rows_moved + result.rows_removed ) * 2 >
+		      old_size ) {
+			// Most of the table changed, replacing it is cheaper than moving rows
+			// around one at a time
+			result = merge_stats{};
+			result.is_reset = true;
+			result.rows_added = next.size( );
+			result.rows_removed = old_size;
+			for( auto id : rows ) {
+				store.remove( id );
+			}
+			rows.clear( );
+			rows.reserve( next.size( ) );
+			for( auto &next_row : next ) {
+				rows.push_back( store.add( std::move( next_row ) ) );
+			}
+			if( sort_column >= 0 ) {
+				std::stable_sort( rows.begin( ), rows.end( ), less );
+			}
+			if( old_size > 0 ) {
+				observer.on_rows_deleted( 0, old_size );
+			}
+			if( !rows.empty( ) ) {
+				observer.on_rows_inserted( 0, rows.size( ) );
+			}
+			return result;
+		}
+
+		auto const is_leaving = [&]( size_t n ) {
+			return state[n] == row_state::Move || state[n] == row_state::Remove;
+		};
+		// Deletions, from the back so that positions stay valid
+		for( size_t n = old_size; n > 0; ) {
+			if( !is_leaving( n - 1 ) ) {
+				--n;
+				continue;
+			}
+			auto const last = n;
+			while( n > 0 && is_leaving( n - 1 ) ) {
+				--n;
+			}
+			observer.on_rows_deleted( n, last - n );
+		}
+
+		// Update the remaining rows in place, remembering the changed cells
+		auto changed = std::vector<mask_t>( );
+		changed.reserve( old_size + added.size( ) );
+		auto to_insert = std::vector<Id>( );
+		size_t out = 0;
+		for( size_t n = 0; n < old_size; ++n ) {
+			mask_t mask = 0;
+			switch( state[n] ) {
+			case row_state::Remove:
+				store.remove( rows[n] );
+				continue;
+			case row_state::Move:
+				store.assign( rows[n], std::move( next[match[n]] ), column_mask );
+				to_insert.push_back( rows[n] );
+				continue;
+			case row_state::Update:
+				for( size_t col = 0; col < 64; ++col ) {
+					if( ( column_mask & ( mask_t{1} << col ) ) != 0 &&
+					    !store.is_equal( rows[n], next[match[n]], col ) ) {
+						mask |= mask_t{1} << col;
+					}
+				}
+				if( mask != 0 ) {
+					store.assign( rows[n], std::move( next[match[n]] ), mask );
+				}
+				break;
+			case row_state::Untouched:
+				break;
+			}
+			rows[out++] = rows[n];
+			changed.push_back( mask );
+			if( mask == 0 ) {
+				++result.rows_unchanged;
+			}
+		}
+		rows.erase( rows.begin( ) + static_cast<std::ptrdiff_t>( out ),
+		            rows.end( ) );
+		for( auto idx : added ) {
+			to_insert.push_back( store.add( std::move( next[idx] ) ) );
+		}
+
+		// New and repositioned rows go to their place in the current order.
+		// They are sorted among themselves and merged into the kept rows in one
+		// forward pass, each run of them is reported at its final position.  On
+		// equal keys kept rows come first, as with std::upper_bound
+		if( !to_insert.empty( ) ) {
+			if( sort_column >= 0 ) {
+				std::stable_sort( to_insert.begin( ), to_insert.end( ), less );
+			}
+			auto merged = std::vector<Id>( );
+			merged.reserve( rows.size( ) + to_insert.size( ) );
+			auto merged_changed = std::vector<mask_t>( );
+			merged_changed.reserve( merged.capacity( ) );
+			size_t kept = 0;
+			for( size_t ins = 0; ins < to_insert.size( ); ) {
+				while( kept < rows.size( ) &&
+				       ( sort_column < 0 || !less( to_insert[ins], rows[kept] ) ) ) {
+					merged.push_back( rows[kept] );
+					merged_changed.push_back( changed[kept++] );
+				}
+				auto const first = merged.size( );
+				while( ins < to_insert.size( ) &&
+				       ( kept == rows.size( ) || less( to_insert[ins], rows[kept] ) ) ) {
+					merged.push_back( to_insert[ins++] );
+					merged_changed.push_back( mask_t{0} );
+				}
+				observer.on_rows_inserted( first, merged.size( ) - first );
+			}
+			auto const rest = static_cast<std::ptrdiff_t>( kept );
+			merged.insert( merged.end( ), rows.begin( ) + rest, rows.end( ) );
+			merged_changed.insert( merged_changed.end( ), changed.begin( ) + rest,
+			                       changed.end( ) );
+			rows = std::move( merged );
+			changed = std::move( merged_changed );
+		}
+
+		for( size_t row = 0; row < changed.size( ); ++row ) {
+			for( size_t col = 0; col < 64 && changed[row] != 0; ++col ) {
+				if( changed[row] & ( mask_t{1} << col ) ) {
+					++result.cells_changed;
+					observer.on_cell_changed( row, col );
+				}
+			}
+		}
+		return result;
+	}
+
+	// Merge a full snapshot, rows not in next are removed and new ones added
+	template<typename Id, typename Next, typename Store, typename Observer>
+	merge_stats merge_snapshot( std::vector<Id> &rows, std::vector<Next> &&next,
+	                            size_t column_count, int sort_column,
+	                            Store &&store, Observer &&observer ) {
+		auto const column_mask =
+		  column_count >= 64 ? ~uint64_t{0} : ( uint64_t{1} << column_count ) - 1;
+		return merge_rows( rows, std::move( next ), column_mask, sort_column,
+		                   merge_options{}, std::forward<Store>( store ),
+		                   std::forward<Observer>( observer ) );
+	}
+
+	// Add row to store and insert it at its sorted position, returns the
+	// position
+	template<typename Id, typename Next, typename Store, typename Observer>
+	size_t insert_row( std::vector<Id> &rows, Next &&row, int sort_column,
+	                   Store &&store, Observer &&observer ) {
+		auto const id = store.add( std::forward<Next>( row ) );
+		auto pos = rows.end( );
+		if( sort_column >= 0 ) {
+			pos = std::upper_bound(
+			  rows.begin( ), rows.end( ), id,
+			  [&store]( Id lhs, Id rhs ) { return store.less( lhs, rhs ); } );
+		}
+		auto const offset = static_cast<size_t>( pos - rows.begin( ) );
+		rows.insert( pos, id );
+		observer.on_rows_inserted( offset, 1 );
+		return offset;
+	}
+
+	// Remove the row identified by key, returns false if it was not found
+	template<typename Id, typename Store, typename Observer>
+	bool erase_row( std::vector<Id> &rows, row_key const &key, Store &&store,
+	                Observer &&observer ) {
+		auto pos = std::find_if( rows.begin( ), rows.end( ),
+		                         [&]( Id id ) { return store.key( id ) == key; } );
+		if( pos == rows.end( ) ) {
+			return false;
+		}
+		auto const offset = static_cast<size_t>( pos - rows.begin( ) );
+		store.remove( *pos );
+		rows.erase( pos );
+		observer.on_rows_deleted( offset, 1 );
+		return true;
+	}
+} // namespace daw
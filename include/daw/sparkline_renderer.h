@@ -0,0 +1,45 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <wx/grid.h>
+
+#include "process_history.h"
+
+namespace daw {
+	// Draws the cell's text with a sparkline of the row's recent history
+	// across it.  Does nothing more when the grid's table is not a
+	// wmi_process_table
+	class sparkline_renderer : public wxGridCellStringRenderer {
+		process_history::series_kinds m_kind;
+
+	public:
+		explicit sparkline_renderer( process_history::series_kinds kind );
+
+		void Draw( wxGrid &grid, wxGridCellAttr &attr, wxDC &dc,
+		           wxRect const &rect, int row, int col,
+		           bool is_selected ) override;
+
+		wxGridCellRenderer *Clone( ) const override;
+	};
+} // namespace daw
@@ -0,0 +1,72 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace daw {
+	// Stores each distinct string once in large blocks that never move, and
+	// hands out small ids for them.  Id 0 is always the empty string
+	class string_arena {
+		static constexpr size_t block_size = 64U * 1024U;
+
+		std::vector<std::unique_ptr<wchar_t[]>> m_blocks;
+		size_t m_block_used = block_size;
+		size_t m_chars = 0;
+		std::vector<std::wstring_view> m_strings;
+		std::unordered_map<std::wstring_view, uint32_t> m_index;
+
+		std::wstring_view store( std::wstring_view str );
+
+	public:
+		using string_id = uint32_t;
+
+		string_arena( );
+		string_arena( string_arena const & ) = delete;
+		string_arena( string_arena && ) noexcept = default;
+		string_arena &operator=( string_arena const & ) = delete;
+		string_arena &operator=( string_arena && ) noexcept = default;
+		~string_arena( ) = default;
+
+		string_id intern( std::wstring_view str );
+
+		std::wstring_view operator[]( string_id id ) const noexcept {
+			return m_strings[id];
+		}
+
+		// Number of distinct strings
+		size_t size( ) const noexcept {
+			return m_strings.size( );
+		}
+
+		// Bytes held by the string data
+		size_t memory_used( ) const noexcept {
+			return m_chars * sizeof( wchar_t );
+		}
+	};
+} // namespace daw
@@ -0,0 +1,83 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <algorithm>
+#include <atlcomcli.h>
+#include <chrono>
+#include <type_traits>
+#include <vector>
+#include <Wbemidl.h>
+
+#include "wmi_impl.h"
+#include "wmi_process.h"
+
+namespace daw {
+	// Pulls the records out of a semi-synchronous enumerator
+	// (WBEM_FLAG_RETURN_IMMEDIATELY | WBEM_FLAG_FORWARD_ONLY) batch_size at a
+	// time, so that a remote host costs one round trip per batch instead of
+	// one per record
+	template<typename Enumerator, typename Function>
+	void for_each_wmi_record( Enumerator &&enumerator,
+	                         wmi_enumerate_options const &opts, Function &&func ) {
+		static_assert(
+		  std::is_invocable_v<Function, CComPtr<IWbemClassObject> &>,
+		  "Function must be callable with CComPtr<IWbemClassObject>" );
+		static_assert(
+		  sizeof( CComPtr<IWbemClassObject> ) == sizeof( IWbemClassObject * ),
+		  "CComPtr must be usable as an array of interface pointers" );
+
+		if( !enumerator ) {
+			return;
+		}
+		auto const batch_size = std::max( opts.batch_size, 1UL );
+		auto const timeout = static_cast<long>( opts.batch_timeout.count( ) );
+		auto records = std::vector<CComPtr<IWbemClassObject>>( batch_size );
+		auto last_record_time = std::chrono::steady_clock::now( );
+		while( true ) {
+			unsigned long record_count = 0;
+			auto const hr = enumerator->Next( timeout, batch_size, &records[0].p,
+			                                  &record_count );
+			if( FAILED( hr ) ) {
+				throw wmi_error_t{"Error enumerating query results", hr};
+			}
+			for( unsigned long n = 0; n < record_count; ++n ) {
+				func( records[n] );
+				records[n].Release( );
+			}
+			if( hr == WBEM_S_FALSE ) {
+				// No more records left
+				break;
+			}
+			// WBEM_S_TIMEDOUT leaves the enumeration open, keep waiting as long
+			// as the host is still producing records
+			auto const now = std::chrono::steady_clock::now( );
+			if( record_count > 0 ) {
+				last_record_time = now;
+			} else if( now - last_record_time > opts.idle_timeout ) {
+				throw wmi_error_t{"Timed out waiting for query results",
+				                  WBEM_E_TIMED_OUT};
+			}
+		}
+	}
+} // namespace daw
@@ -26,9 +26,16 @@
 #include <atlcomcli.h>
 #include <comdef.h>
 #include <exception>
+#include <future>
+#include <memory>
 #include <string>
+#include <vector>
 #include <Wbemidl.h>
 
+#include "connection_pool.h"
+#include "wmi_process.h"
+#include "wmi_refresher.h"
+
 namespace daw {
 	struct wmi_error_t: std::exception {
 		long code;
@@ -47,10 +54,14 @@ namespace daw {
 		~wmi_state_co( );
 	};
 
+	// A connection to a WMI namespace.  COM must already be initialized on
+	// the calling thread, see run_in_mta
 	struct wmi_state_t {
 		CComPtr<IWbemLocator> locator = nullptr;
 		CComPtr<IWbemServices> service = nullptr;
-		wmi_state_co init;
+		// The counters of this connection's processes, set up on first use
+		std::unique_ptr<process_refresher> process_counters =
+		  std::make_unique<process_refresher>( );
 
 		wmi_state_t( wmi_state_t && ) noexcept = default;
 		wmi_state_t &operator=( wmi_state_t && ) noexcept = default;
@@ -58,9 +69,74 @@ namespace daw {
 		wmi_state_t &operator=( wmi_state_t const & ) = delete;
 		~wmi_state_t( ) = default;
 
-		explicit wmi_state_t( DWORD co_init );
+		wmi_state_t( );
 		void connect( std::wstring const &path, std::wstring machine = L"" ); 
 		void set_proxy_blanket( ); 
 		CComPtr<IEnumWbemClassObject> query( std::wstring const &query_str ); 
 	};
+
+	// get_wmi_win32_process for the processes in process_ids, on a connection
+	// already acquired
+	std::vector<wmi_process>
+	query_wmi_win32_process( wmi_state_t &wmi_state, column_set columns,
+	                         std::vector<uint32_t> const &process_ids,
+	                         wmi_enumerate_options const &opts = {} );
+
+	// Decodes the columns of a Win32_Process instance
+	wmi_process decode_wmi_process( CComPtr<IWbemClassObject> &record,
+	                                column_set columns );
+
+	// RPC/DCOM failures that mean the proxy to the remote host is dead
+	bool is_connection_lost( long hr ) noexcept;
+
+	struct wmi_connection_backend : connection_backend<wmi_state_t> {
+		std::shared_ptr<wmi_state_t> connect( std::wstring const &host ) override;
+		bool is_connection_lost( std::exception const &ex ) const override;
+	};
+
+	// The process wide pool of ROOT\CIMV2 connections.  The proxies live in
+	// the multithreaded apartment so they must only be used from inside
+	// run_in_mta.  The apartment is kept alive while connections are pooled
+	connection_pool<wmi_state_t> &wmi_connections( );
+
+	// Release the pooled connections and the apartment they live in before
+	// COM is torn down
+	void close_wmi_connections( );
+
+	namespace impl {
+		// Returns false when the thread already belongs to a single threaded
+		// apartment.  On true the caller must call CoUninitialize
+		bool enter_mta( );
+
+		struct co_uninitializer {
+			co_uninitializer( ) noexcept = default;
+			co_uninitializer( co_uninitializer const & ) = delete;
+			co_uninitializer &operator=( co_uninitializer const & ) = delete;
+			~co_uninitializer( );
+		};
+	} // namespace impl
+
+	// Run func on a thread in the multithreaded apartment.  Calls made from
+	// a STA thread, such as the UI thread, are run on a worker thread and
+	// waited on
+	template<typename Function>
+	auto run_in_mta( Function &&func ) {
+		if( impl::enter_mta( ) ) {
+			impl::co_uninitializer const uninit{};
+			return func( );
+		}
+		return std::async( std::launch::async, [&func]( ) {
+			       wmi_state_co const init( COINIT_MULTITHREADED );
+			       return func( );
+		       } )
+		  .get( );
+	}
+
+	template<typename Function>
+	auto with_wmi_service( std::wstring const &machine, Function &&func ) {
+		return run_in_mta( [&]( ) {
+			return wmi_connections( ).with_connection(
+			  machine, std::forward<Function>( func ) );
+		} );
+	}
 } // namespace daw
@@ -23,7 +23,10 @@
 #pragma once
 
 #include <array>
+#include <bitset>
+#include <chrono>
 #include <cstdint>
+#include <functional>
 #include <iomanip>
 #include <string>
 #include <vector>
@@ -45,7 +48,8 @@ namespace daw {
 	struct wmi_process {
 		wmi_process( ) noexcept = default;
 
-		static std::array<wxString, 14> const column_names;
+		static constexpr size_t column_count = 19;
+		static std::array<wxString, column_count> const column_names;
 		enum class column_number : int {
 			Name,
 			ProcessId,
@@ -61,7 +65,12 @@ namespace daw {
 			PeakPageFileUsage,
 			ReadTransferCount,
 			WriteTransferCount,
-			CommandLine
+			CommandLine,
+			// Rates since the previous snapshot, see process_rates
+			CpuUsage,
+			ReadRate,
+			WriteRate,
+			PageFaultRate
 		};
 		String name;
 		String command_line;
@@ -83,6 +92,64 @@ namespace daw {
 		Memory read_transfer_count;
 		Memory write_transfer_count;
 
+		// Kernel plus user mode time in 100ns units, only read for CpuUsage
+		uint64_t cpu_time = 0;
+		// Rates, filled in by process_rates
+		Percent cpu_usage;
+		Memory read_rate;
+		Memory write_rate;
+		Integer<uint32_t> page_fault_rate;
+
+		// The member backing column col
+		template<column_number col>
+		auto &column( ) noexcept {
+			if constexpr( col == column_number::Name ) {
+				return name;
+			} else if constexpr( col == column_number::ProcessId ) {
+				return process_id;
+			} else if constexpr( col == column_number::ParentProcessId ) {
+				return parent_process_id;
+			} else if constexpr( col == column_number::SessionId ) {
+				return session_id;
+			} else if constexpr( col == column_number::Handle ) {
+				return handle;
+			} else if constexpr( col == column_number::CreationDate ) {
+				return creation_date;
+			} else if constexpr( col == column_number::ThreadCount ) {
+				return thread_count;
+			} else if constexpr( col == column_number::PageFaults ) {
+				return page_faults;
+			} else if constexpr( col == column_number::WorkingSetSize ) {
+				return working_set_size;
+			} else if constexpr( col == column_number::PeakWorkingSetSize ) {
+				return peak_working_set_size;
+			} else if constexpr( col == column_number::PageFileUsage ) {
+				return page_file_usage;
+			} else if constexpr( col == column_number::PeakPageFileUsage ) {
+				return peak_page_file_usage;
+			} else if constexpr( col == column_number::ReadTransferCount ) {
+				return read_transfer_count;
+			} else if constexpr( col == column_number::WriteTransferCount ) {
+				return write_transfer_count;
+			} else if constexpr( col == column_number::CommandLine ) {
+				return command_line;
+			} else if constexpr( col == column_number::CpuUsage ) {
+				return cpu_usage;
+			} else if constexpr( col == column_number::ReadRate ) {
+				return read_rate;
+			} else if constexpr( col == column_number::WriteRate ) {
+				return write_rate;
+			} else {
+				static_assert( col == column_number::PageFaultRate, "Unknown column" );
+				return page_fault_rate;
+			}
+		}
+
+		template<column_number col>
+		auto const &column( ) const noexcept {
+			return const_cast<wmi_process &>( *this ).column<col>( );
+		}
+
 		ColumnItem const &operator[]( size_t n ) const {
 			switch( static_cast<column_number>( n ) ) {
 			case column_number::Name:
@@ -115,14 +182,144 @@ namespace daw {
 				return write_transfer_count;
 			case column_number::CommandLine:
 				return command_line;
+			case column_number::CpuUsage:
+				return cpu_usage;
+			case column_number::ReadRate:
+				return read_rate;
+			case column_number::WriteRate:
+				return write_rate;
+			case column_number::PageFaultRate:
+				return page_fault_rate;
 			default:
 				std::terminate( );
 			}
 		}
+
+		// Copy the value of column col from other
+		void assign_column( column_number col, wmi_process const &other ) {
+			switch( col ) {
+			case column_number::Name:
+				name = other.name;
+				break;
+			case column_number::ProcessId:
+				process_id = other.process_id;
+				break;
+			case column_number::ParentProcessId:
+				parent_process_id = other.parent_process_id;
+				break;
+			case column_number::SessionId:
+				session_id = other.session_id;
+				break;
+			case column_number::Handle:
+				handle = other.handle;
+				break;
+			case column_number::CreationDate:
+				creation_date = other.creation_date;
+				break;
+			case column_number::ThreadCount:
+				thread_count = other.thread_count;
+				break;
+			case column_number::PageFaults:
+				page_faults = other.page_faults;
+				break;
+			case column_number::PageFileUsage:
+				page_file_usage = other.page_file_usage;
+				break;
+			case column_number::PeakPageFileUsage:
+				peak_page_file_usage = other.peak_page_file_usage;
+				break;
+			case column_number::WorkingSetSize:
+				working_set_size = other.working_set_size;
+				break;
+			case column_number::PeakWorkingSetSize:
+				peak_working_set_size = other.peak_working_set_size;
+				break;
+			case column_number::ReadTransferCount:
+				read_transfer_count = other.read_transfer_count;
+				break;
+			case column_number::WriteTransferCount:
+				write_transfer_count = other.write_transfer_count;
+				break;
+			case column_number::CommandLine:
+				command_line = other.command_line;
+				break;
+			case column_number::CpuUsage:
+				cpu_time = other.cpu_time;
+				cpu_usage = other.cpu_usage;
+				break;
+			case column_number::ReadRate:
+				read_rate = other.read_rate;
+				break;
+			case column_number::WriteRate:
+				write_rate = other.write_rate;
+				break;
+			case column_number::PageFaultRate:
+				page_fault_rate = other.page_fault_rate;
+				break;
+			default:
+				std::terminate( );
+			}
+		}
+	};
+
+	// A set of wmi_process columns, indexed by wmi_process::column_number
+	using column_set = std::bitset<wmi_process::column_count>;
+
+	struct wmi_enumerate_options {
+		// Records requested per IEnumWbemClassObject::Next round trip
+		unsigned long batch_size = 256;
+		// How long a single Next call waits to fill its batch
+		std::chrono::milliseconds batch_timeout = std::chrono::seconds( 2 );
+		// Fail when the host has produced no records for this long
+		std::chrono::milliseconds idle_timeout = std::chrono::seconds( 60 );
+		// Threads used to decode the records, 0 is one per core
+		size_t decode_threads = 0;
 	};
 
 	std::vector<wmi_process>
 	get_wmi_win32_process( std::wstring const &machine = L"" );
 
+	// Only the properties backing columns are requested from WMI, the other
+	// members of the results are left defaulted
+	std::vector<wmi_process>
+	get_wmi_win32_process( std::wstring const &machine, column_set columns,
+	                       wmi_enumerate_options const &opts = {} );
+
+	// Only fetches the processes in process_ids
+	std::vector<wmi_process>
+	get_wmi_win32_process( std::wstring const &machine, column_set columns,
+	                       std::vector<uint32_t> const &process_ids,
+	                       wmi_enumerate_options const &opts = {} );
+
+	// Calls func with each process as its record arrives from the host,
+	// without collecting them.  Only the properties backing columns are
+	// requested
+	void for_each_wmi_win32_process(
+	  std::wstring const &machine, column_set columns,
+	  std::function<void( wmi_process const & )> const &func,
+	  wmi_enumerate_options const &opts = {} );
+
+	struct process_rates;
+
+	struct top_processes {
+		// The first processes in sort order
+		std::vector<wmi_process> processes;
+		// Every process on the host, including the ones not kept
+		size_t total = 0;
+	};
+
+	// The first count processes ordered on sort_column, ties on ProcessId.
+	// Records are ranked as they arrive and only count of them are kept, so
+	// memory stays O(count).  A record is only fully decoded when it makes
+	// the cut.  rates, when set, are the previous samples of machine the
+	// rate columns rank against, they keep a sample of every process for
+	// the next call.  See top_selector
+	top_processes get_wmi_win32_process_top( std::wstring const &machine,
+	                                         column_set columns,
+	                                         wmi_process::column_number sort_column,
+	                                         bool is_ascending, size_t count,
+	                                         process_rates *rates = nullptr,
+	                                         wmi_enumerate_options const &opts = {} );
+
 	void terminate_process_by_pid( std::wstring const &machine, uint32_t pid );
 } // namespace daw
@@ -22,32 +22,184 @@
 //
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_set>
 #include <wx/grid.h>
 #include <wx/string.h>
 
 #include <daw/daw_validated.h>
 
+#include "lockfree_queue.h"
+#include "process_history.h"
+#include "process_rates.h"
+#include "process_source.h"
+#include "process_store.h"
+#include "render_cache.h"
+#include "snapshot_file.h"
+#include "snapshot_merge.h"
 #include "wmi_process.h"
 
 namespace daw {
+	struct process_event_queue;
+	struct process_subscription;
+
 	struct wmi_process_table : public wxGridTableBase {
 		using table_data_t = std::vector<wmi_process>;
+		// Where snapshots come from instead of WMI, called by update_data
+		using source_t = std::function<table_data_t( )>;
 		enum class SortOrder : uint_fast8_t { Next, Ascending, Descending };
 
+		// How long the last first load took, measured from the start of its
+		// query
+		struct load_timing {
+			using duration = std::chrono::steady_clock::duration;
+			// The first record arrived from the host
+			std::optional<duration> first_row;
+			// The first rows were shown
+			std::optional<duration> first_paint;
+			// Every row was shown.  A large table may still be sorting
+			std::optional<duration> complete;
+			size_t rows = 0;
+		};
+
 	private:
 		wxString m_remote_host;
-		std::shared_ptr<table_data_t> m_data;
+		// Where update_data fetches the processes of m_remote_host from
+		std::shared_ptr<process_source> m_processes = default_process_source( );
+		source_t m_source;
+		// Every snapshot update_data fetches is appended to it when set
+		mutable std::mutex m_recorder_mutex;
+		std::shared_ptr<snapshot_file::writer> m_recorder;
+		process_store m_store;
+		// Row ids of m_store in display order
+		std::vector<process_store::row_id> m_rows;
+		// Formatted text of the cells the grid has asked for
+		render_cache m_render_cache;
+		struct pending_t {
+			std::unique_ptr<table_data_t> data;
+			// Rows already in the table only take these columns from data.  data
+			// holds every process, rows not in it are removed and new ones added
+			column_set columns;
+			// data was streamed to the UI thread while it was read
+			bool is_streamed = false;
+		};
+		// Filled by update_data on a worker thread, merged by apply_update
+		std::mutex m_pending_mutex;
+		pending_t m_pending;
+		// The rows update_data has fetched the fixed columns for.  Only used by
+		// update_data
+		std::unordered_set<row_key, row_key_hash> m_known_rows;
+		// The previous counters of each process, for the rate columns.  Only
+		// used by update_data
+		process_rates m_rates;
+		// Moves the host's sample times onto the local clock, so they mix with
+		// the samples only timed on arrival.  Only used by update_data
+		std::optional<process_rates::clock::duration> m_host_clock_offset;
+		// Recorded by update_data, read by the grid's sparklines
+		mutable std::mutex m_history_mutex;
+		process_history m_history;
+		// When subscribed, process start/stop arrive as events and show up
+		// before the next poll, which still corrects the rows
+		std::shared_ptr<process_event_queue> m_events;
+		// Only used by update_data
+		std::unique_ptr<process_subscription> m_subscription;
+		std::atomic<bool> m_is_event_driven{false};
+		// update_data subscribes before its next fetch
+		std::atomic<bool> m_wants_events{false};
+		std::atomic<bool> m_needs_full_refresh{false};
+		// Set by the first update_data, which fetches every process
+		std::atomic<bool> m_is_loaded{false};
+		// Hidden columns are not fetched on refresh
+		std::atomic<column_set> m_visible_columns = column_set{}.set( );
+		// When non-zero only the first m_row_limit processes in sort order are
+		// fetched and shown
+		std::atomic<size_t> m_row_limit{0};
+		// Processes on the host, including the ones cut by m_row_limit
+		std::atomic<size_t> m_total_rows{0};
 
 		struct sorted_t {
 			int column = -1;
 			SortOrder sort_order = SortOrder::Descending;
 		} sorted;
 
+		// What update_data fetches for.  A copy of m_remote_host and
+		// m_requested_sort, which the UI thread changes while update_data runs
+		// on a worker
+		struct fetch_request_t {
+			std::wstring host;
+			sorted_t sort;
+		};
+		mutable std::mutex m_request_mutex;
+		fetch_request_t m_request;
+
+		// A first load streams its rows from update_data to the UI thread in
+		// batches, one producer and one consumer
+		lockfree_queue<table_data_t> m_stream{64};
+		std::function<void( )> m_on_stream;
+		// The rows shown so far were streamed and are unsorted, apply_update
+		// sorts them on m_stream_sort once the load is complete
+		bool m_is_streaming = false;
+		sorted_t m_stream_sort;
+		mutable std::mutex m_timing_mutex;
+		std::chrono::steady_clock::time_point m_load_start{};
+		load_timing m_load_timing;
+
+		// Large tables are sorted on a worker thread.  The result replaces
+		// m_rows on the UI thread, unless rows were added, removed or moved in
+		// the meantime and it has to be sorted again
+		struct sort_result_t {
+			sorted_t request;
+			uint64_t rows_version = 0;
+			std::vector<process_store::row_id> rows;
+		};
+		// The latest sort asked for, sorted once it is done
+		sorted_t m_requested_sort;
+		// The last ascending order of each column sorted before, the starting
+		// point when that column is sorted again
+		std::array<std::vector<process_store::row_id>, wmi_process::column_count>
+		  m_sorted_rows;
+		std::future<void> m_sort_task;
+		std::mutex m_sort_mutex;
+		std::optional<sort_result_t> m_sort_result;
+		bool m_is_sort_queued = false;
+		// Changes whenever the rows in m_rows or their order change
+		uint64_t m_rows_version = 0;
+		// Lets callbacks queued on the grid know the table is gone
+		std::shared_ptr<bool> m_is_alive = std::make_shared<bool>( true );
+
+		fetch_request_t fetch_request( ) const;
+		void record( table_data_t const &rows, column_set columns );
+		process_rates::clock::time_point
+		rate_time( std::optional<process_rates::clock::time_point> sampled );
+		void start_subscription( std::wstring const &host );
+		void start_sort( );
+		void finish_sort( );
+		void set_rows( std::vector<process_store::row_id> &&rows,
+		               sorted_t sort_order );
+		// Reads every process of host, handing them to the UI thread in
+		// batches as they arrive
+		table_data_t stream_processes( std::wstring const &host,
+		                               column_set columns );
+
 	public:
-		explicit wmi_process_table( wxString remote_host = L"." );
-		explicit wmi_process_table( std::shared_ptr<table_data_t> data );
+		// The rows are loaded by the first update_data
+		explicit wmi_process_table(
+		  wxString remote_host = L".",
+		  std::shared_ptr<process_source> processes = default_process_source( ) );
+		explicit wmi_process_table( std::shared_ptr<table_data_t> const &data );
 		explicit wmi_process_table( table_data_t const &data );
 		explicit wmi_process_table( table_data_t &&data );
+		// Takes every snapshot from source, e.g. a replay_source.  name stands
+		// in for the host
+		wmi_process_table( wxString name, source_t source );
+		~wmi_process_table( ) override;
 
 		int GetNumberRows( ) override;
 		int GetNumberCols( ) override;
@@ -55,17 +207,92 @@ namespace daw {
 		wxString GetValue( int row, int col ) override;
 		wxString GetColLabelValue( int col ) override;
 
+		// Sorts the rows, on a worker thread when there are many of them
 		void sort_column( int col, SortOrder sort_order = SortOrder::Next );
 
+		bool is_sorting( ) const;
+
 		inline void sort_column( wmi_process::column_number col,
 		                         SortOrder sort_order = SortOrder::Next ) {
 
 			sort_column( static_cast<int>( col ), sort_order );
 		}
 
+		bool is_column_visible( int col ) const;
+		void set_column_visible( int col, bool is_visible );
+
+		// Only keep the first count rows in sort order, 0 shows every row.
+		// Takes effect on the next update_data
+		void set_row_limit( size_t count );
+
+		size_t row_limit( ) const noexcept {
+			return m_row_limit;
+		}
+
+		// Processes on the host, also counting the ones cut by the row limit
+		size_t total_rows( ) const noexcept;
+
+		// The recent values of one counter of the process in row, oldest first
+		std::vector<uint64_t> history( int row,
+		                               process_history::series_kinds kind ) const;
+
+		process_history::stats_t history_stats( ) const;
+
+		// Appends every snapshot fetched from now on to recorder, null stops
+		// recording.  Recording stops when the file cannot be written
+		void set_recorder( std::shared_ptr<snapshot_file::writer> recorder );
+
+		bool is_recording( ) const;
+
+		// Fetches a new snapshot, safe to call from a worker thread
 		void update_data( );
+
+		// Merges the snapshot from update_data into the table and notifies the
+		// grid of the inserted/deleted rows and changed cells.  Must be called
+		// on the UI thread
+		merge_stats apply_update( );
+
+		// Called from update_data whenever a first load has streamed a batch of
+		// rows, e.g. to schedule apply_stream on the UI thread.  Set it before
+		// the first update_data
+		void set_stream_callback( std::function<void( )> on_stream );
+
+		// Shows the rows streamed so far, unsorted until apply_update merges
+		// the complete snapshot.  Must be called on the UI thread.  Returns the
+		// rows added
+		size_t apply_stream( );
+
+		load_timing last_load_timing( ) const;
+
+		// Track process start/stop through the source's events as well as
+		// polling.  Subscribing connects to the host, so the next update_data
+		// does it on its worker.  When the source has no events or the host
+		// does not accept the subscription the table only polls
+		void subscribe_events( );
+
+		// Applies the queued start/stop events.  Must be called on the UI
+		// thread
+		size_t apply_events( );
+
 		void change_host( wxString const &remote_host = L"." );
 
+		process_store const &store( ) const noexcept {
+			return m_store;
+		}
+
+		// The row ids of store( ) in display order
+		std::vector<process_store::row_id> const &rows( ) const noexcept {
+			return m_rows;
+		}
+
+		wxString const &host( ) const noexcept {
+			return m_remote_host;
+		}
+
+		std::shared_ptr<process_source> const &processes( ) const noexcept {
+			return m_processes;
+		}
+
 		inline bool IsEmptyCell( int, int ) override {
 			return false;
 		}
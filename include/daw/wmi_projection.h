@@ -0,0 +1,66 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "wmi_process.h"
+
+namespace daw {
+	column_set all_columns( );
+
+	// Columns the table cannot work without, they are fetched even when hidden
+	column_set required_columns( );
+
+	// Columns that change while a process runs, the rest are fixed once the
+	// process has started
+	column_set counter_columns( );
+
+	// columns plus the counters its rate columns are computed from
+	column_set with_rate_sources( column_set columns );
+
+	inline column_set make_column_set(
+	  std::initializer_list<wmi_process::column_number> cols ) {
+		auto result = column_set{};
+		for( auto col : cols ) {
+			result.set( static_cast<size_t>( col ) );
+		}
+		return result;
+	}
+
+	// The Win32_Process property that backs a column, null for the rate
+	// columns
+	wchar_t const *property_name( wmi_process::column_number col );
+
+	// The minimal list of properties needed to fill columns
+	std::vector<wchar_t const *> projected_properties( column_set columns );
+
+	// Builds "SELECT <properties> FROM <class_name>[ WHERE <where_clause>]"
+	// selecting only the properties needed by columns
+	std::wstring make_projected_query( column_set columns,
+	                                   std::wstring_view class_name,
+	                                   std::wstring_view where_clause = L"" );
+} // namespace daw
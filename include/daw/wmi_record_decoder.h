@@ -0,0 +1,266 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <wx/datetime.h>
+
+#include "column_items.h"
+#include "wmi_process.h"
+
+namespace daw {
+	// The CIM type a Win32_Process property is read as
+	enum class cim_kinds : uint_fast8_t { String, Uint32, Uint64, Datetime };
+
+	// The Win32_Process properties a wmi_process is decoded from
+	enum class process_properties : uint_fast8_t {
+		Name,
+		CommandLine,
+		ProcessId,
+		ParentProcessId,
+		SessionId,
+		Handle,
+		CreationDate,
+		ThreadCount,
+		PageFaults,
+		PageFileUsage,
+		PeakPageFileUsage,
+		WorkingSetSize,
+		PeakWorkingSetSize,
+		ReadTransferCount,
+		WriteTransferCount,
+		KernelModeTime,
+		UserModeTime
+	};
+
+	struct process_property {
+		wchar_t const *name;
+		cim_kinds kind;
+		// The column that needs it
+		wmi_process::column_number column;
+	};
+
+	// Indexed by process_properties
+	inline constexpr std::array<process_property, 17> process_property_list = {{
+	  {L"Name", cim_kinds::String, wmi_process::column_number::Name},
+	  {L"CommandLine", cim_kinds::String, wmi_process::column_number::CommandLine},
+	  {L"ProcessId", cim_kinds::Uint32, wmi_process::column_number::ProcessId},
+	  {L"ParentProcessId", cim_kinds::Uint32,
+	   wmi_process::column_number::ParentProcessId},
+	  {L"SessionId", cim_kinds::Uint32, wmi_process::column_number::SessionId},
+	  {L"Handle", cim_kinds::String, wmi_process::column_number::Handle},
+	  {L"CreationDate", cim_kinds::Datetime,
+	   wmi_process::column_number::CreationDate},
+	  {L"ThreadCount", cim_kinds::Uint32, wmi_process::column_number::ThreadCount},
+	  {L"PageFaults", cim_kinds::Uint32, wmi_process::column_number::PageFaults},
+	  {L"PageFileUsage", cim_kinds::Uint32,
+	   wmi_process::column_number::PageFileUsage},
+	  {L"PeakPageFileUsage", cim_kinds::Uint32,
+	   wmi_process::column_number::PeakPageFileUsage},
+	  {L"WorkingSetSize", cim_kinds::Uint64,
+	   wmi_process::column_number::WorkingSetSize},
+	  {L"PeakWorkingSetSize", cim_kinds::Uint32,
+	   wmi_process::column_number::PeakWorkingSetSize},
+	  {L"ReadTransferCount", cim_kinds::Uint64,
+	   wmi_process::column_number::ReadTransferCount},
+	  {L"WriteTransferCount", cim_kinds::Uint64,
+	   wmi_process::column_number::WriteTransferCount},
+	  {L"KernelModeTime", cim_kinds::Uint64, wmi_process::column_number::CpuUsage},
+	  {L"UserModeTime", cim_kinds::Uint64, wmi_process::column_number::CpuUsage}}};
+
+	// Decodes Win32_Process records into wmi_process through an Accessor that
+	// resolves each property once and then reads it by handle:
+	//
+	//   struct Accessor {
+	//     using record_t = ...;
+	//     using handle_t = ...;
+	//     // Empty when the record has no such property of that kind
+	//     std::optional<handle_t> resolve( record_t &, wchar_t const *name,
+	//                                      cim_kinds kind ) const;
+	//     uint32_t read_uint32( record_t &, handle_t ) const;
+	//     uint64_t read_uint64( record_t &, handle_t ) const;
+	//     // Leaves dest alone when it already holds the value
+	//     void read_string( record_t &, handle_t, String &dest ) const;
+	//     wxDateTime read_datetime( record_t &, handle_t ) const;
+	//   };
+	//
+	// Only the properties of columns are resolved and read
+	template<typename Accessor>
+	class record_decoder {
+	public:
+		using record_t = typename Accessor::record_t;
+		using handle_t = typename Accessor::handle_t;
+
+	private:
+		Accessor m_accessor;
+		column_set m_columns;
+		std::array<handle_t, process_property_list.size( )> m_handles{};
+
+		bool has( wmi_process::column_number col ) const {
+			return m_columns[static_cast<size_t>( col )];
+		}
+
+		handle_t handle( process_properties prop ) const {
+			return m_handles[static_cast<size_t>( prop )];
+		}
+
+		template<typename T>
+		static constexpr T from_kilobytes( T kilobyte_value ) noexcept {
+			return kilobyte_value * static_cast<T>( 1024 );
+		}
+
+	public:
+		record_decoder( Accessor accessor, column_set columns )
+		  : m_accessor( std::move( accessor ) )
+		  , m_columns( columns ) {}
+
+		column_set const &columns( ) const noexcept {
+			return m_columns;
+		}
+
+		// Resolves the handles from one record of the query, they are valid for
+		// every record of the same class.  False when a property is missing
+		bool resolve( record_t &record ) {
+			for( size_t n = 0; n < process_property_list.size( ); ++n ) {
+				auto const &prop = process_property_list[n];
+				if( !has( prop.column ) ) {
+					continue;
+				}
+				auto h = m_accessor.resolve( record, prop.name, prop.kind );
+				if( !h ) {
+					return false;
+				}
+				m_handles[n] = *h;
+			}
+			return true;
+		}
+
+		void operator( )( record_t &record, wmi_process &item ) const {
+			using column_number = wmi_process::column_number;
+			using P = process_properties;
+			auto const u32 = [&]( P prop ) {
+				return m_accessor.read_uint32( record, handle( prop ) );
+			};
+			auto const u64 = [&]( P prop ) {
+				return m_accessor.read_uint64( record, handle( prop ) );
+			};
+			// The identity and the columns that do not change while the process
+			// runs
+			if( has( column_number::Name ) ) {
+				m_accessor.read_string( record, handle( P::Name ), item.name );
+			}
+			if( has( column_number::CommandLine ) ) {
+				m_accessor.read_string( record, handle( P::CommandLine ),
+				                        item.command_line );
+			}
+			if( has( column_number::ProcessId ) ) {
+				item.process_id = u32( P::ProcessId );
+			}
+			if( has( column_number::ParentProcessId ) ) {
+				item.parent_process_id = u32( P::ParentProcessId );
+			}
+			if( has( column_number::SessionId ) ) {
+				item.session_id = u32( P::SessionId );
+			}
+			if( has( column_number::Handle ) ) {
+				m_accessor.read_string( record, handle( P::Handle ), item.handle );
+			}
+			if( has( column_number::CreationDate ) ) {
+				item.creation_date =
+				  m_accessor.read_datetime( record, handle( P::CreationDate ) );
+			}
+			// The counters
+			if( has( column_number::ThreadCount ) ) {
+				item.thread_count = u32( P::ThreadCount );
+			}
+			if( has( column_number::PageFaults ) ) {
+				item.page_faults = u32( P::PageFaults );
+			}
+			if( has( column_number::PageFileUsage ) ) {
+				item.page_file_usage =
+				  from_kilobytes( static_cast<uint64_t>( u32( P::PageFileUsage ) ) );
+			}
+			if( has( column_number::PeakPageFileUsage ) ) {
+				item.peak_page_file_usage =
+				  from_kilobytes( static_cast<uint64_t>( u32( P::PeakPageFileUsage ) ) );
+			}
+			if( has( column_number::WorkingSetSize ) ) {
+				item.working_set_size = u64( P::WorkingSetSize );
+			}
+			if( has( column_number::PeakWorkingSetSize ) ) {
+				item.peak_working_set_size = from_kilobytes(
+				  static_cast<uint64_t>( u32( P::PeakWorkingSetSize ) ) );
+			}
+			if( has( column_number::ReadTransferCount ) ) {
+				item.read_transfer_count = u64( P::ReadTransferCount );
+			}
+			if( has( column_number::WriteTransferCount ) ) {
+				item.write_transfer_count = u64( P::WriteTransferCount );
+			}
+			if( has( column_number::CpuUsage ) ) {
+				item.cpu_time = u64( P::KernelModeTime ) + u64( P::UserModeTime );
+			}
+		}
+	};
+
+	// Decodes through ByHandle when a record can be read that way, resolving
+	// the handles from the first such record.  Through ByName, whose resolve
+	// does not look at the record, otherwise or when a property cannot be
+	// resolved
+	template<typename ByHandle, typename ByName>
+	class fallback_decoder {
+		record_decoder<ByName> m_by_name;
+		mutable record_decoder<ByHandle> m_by_handle;
+		mutable std::once_flag m_resolve_flag;
+		mutable bool m_has_handles = false;
+
+	public:
+		fallback_decoder( ByHandle by_handle, ByName by_name, column_set columns )
+		  : m_by_name( std::move( by_name ), columns )
+		  , m_by_handle( std::move( by_handle ), columns ) {
+
+			auto none = typename ByName::record_t{};
+			m_by_name.resolve( none );
+		}
+
+		// handle_record is record read through ByHandle, null when it cannot be
+		void operator( )( typename ByName::record_t &record,
+		                  typename ByHandle::record_t *handle_record,
+		                  wmi_process &item ) const {
+			if( handle_record ) {
+				std::call_once( m_resolve_flag, [&]( ) {
+					m_has_handles = m_by_handle.resolve( *handle_record );
+				} );
+				if( m_has_handles ) {
+					m_by_handle( *handle_record, item );
+					return;
+				}
+			}
+			m_by_name( record, item );
+		}
+	};
+} // namespace daw
@@ -0,0 +1,100 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <atlcomcli.h>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include <Wbemidl.h>
+#include <wx/datetime.h>
+
+#include "perf_counters.h"
+#include "process_source.h"
+#include "wmi_process.h"
+
+namespace daw {
+	struct wmi_state_t;
+
+	// The high-performance path to the process counters.  A
+	// Win32_PerfRawData_PerfProc_Process enumerator is kept in an
+	// IWbemRefresher, so a sample is one Refresh instead of a WQL query, and
+	// the instances are read by property handle.  Safe to share between
+	// threads
+	class process_refresher {
+		enum class states : uint_fast8_t { New, Ready, Unavailable };
+		struct property_t {
+			long handle = 0;
+			CIMTYPE type = CIM_EMPTY;
+		};
+		struct handles_t {
+			property_t name;
+			property_t process_id;
+			property_t start_time;
+			property_t processor_time;
+			property_t io_read_bytes;
+			property_t io_write_bytes;
+			property_t page_faults;
+			property_t thread_count;
+			property_t working_set;
+			property_t working_set_peak;
+			property_t private_bytes;
+			property_t page_file_bytes_peak;
+			property_t timestamp;
+		};
+		// The Win32_Process identity of a process id, valid while its start time
+		// is the same
+		struct identity_t {
+			uint64_t start_time = 0;
+			wxDateTime creation_date;
+		};
+
+		std::mutex m_mutex;
+		states m_state = states::New;
+		CComPtr<IWbemRefresher> m_refresher;
+		CComPtr<IWbemHiPerfEnum> m_enum;
+		std::optional<handles_t> m_handles;
+		// Reused by every sample
+		std::vector<IWbemObjectAccess *> m_objects;
+		std::unordered_map<uint32_t, identity_t> m_identities;
+
+		bool start( IWbemServices *service );
+		// Empty when the counters are not the ones expected
+		std::optional<raw_counter_sample> sample( );
+
+	public:
+		process_refresher( ) = default;
+		process_refresher( process_refresher const & ) = delete;
+		process_refresher &operator=( process_refresher const & ) = delete;
+		~process_refresher( );
+
+		// The counter columns of every process on the host of wmi_state, with
+		// the process id and creation date of Win32_Process so that the rows
+		// match the ones queried from it, and the time the host read them.
+		// Empty when the host has no refreshable process counters, the caller
+		// then has to query them
+		std::optional<counter_sample> refresh( wmi_state_t &wmi_state );
+	};
+} // namespace daw
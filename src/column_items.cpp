@@ -20,30 +20,108 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 //
-#include <iomanip>
-#include <sstream>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <string_view>
+#include <wx/datetime.h>
 #include <wx/string.h>
 
 #include "daw/column_items.h"
 
 namespace daw {
 	namespace {
-		std::wstring to_2digit_dec( double value ) {
-			std::wstringstream ss;
-			ss << std::fixed << std::setprecision( 2 ) << value;
-			auto result = ss.str( );
-			if( result.find_first_of( L'.' ) != std::wstring::npos ) {
-				while( result.back( ) == L'0' ) {
-					result.resize( result.size( ) - 1 );
+		constexpr std::array<wchar_t const *, 7> memory_units = {
+		  L"B", L"KB", L"MB", L"GB", L"TB", L"PB", L"EB"};
+
+		wchar_t *widen( char const *first, char const *last, wchar_t *out ) noexcept {
+			while( first != last ) {
+				*out++ = static_cast<wchar_t>( *first++ );
+			}
+			return out;
+		}
+
+		wchar_t *write_unsigned( uint64_t value, wchar_t *out ) noexcept {
+			char buff[20];
+			auto const result = std::to_chars( buff, buff + sizeof( buff ), value );
+			return widen( buff, result.ptr, out );
+		}
+
+		wchar_t *write_2digits( unsigned value, wchar_t *out ) noexcept {
+			*out++ = static_cast<wchar_t>( L'0' + ( value / 10U ) % 10U );
+			*out++ = static_cast<wchar_t>( L'0' + value % 10U );
+			return out;
+		}
+
+		// Fixed with 2 decimals, without trailing zeros or a trailing '.'
+		wchar_t *write_2digit_dec( double value, wchar_t *out ) noexcept {
+			char buff[32];
+			auto const result = std::to_chars( buff, buff + sizeof( buff ), value,
+			                                   std::chars_format::fixed, 2 );
+			auto last = result.ptr;
+			if( std::find( buff, last, '.' ) != last ) {
+				while( last[-1] == '0' ) {
+					--last;
+				}
+				if( last[-1] == '.' ) {
+					--last;
 				}
 			}
-			if( result.back( ) == L'.' ) {
-				result.resize( result.size( ) - 1 );
+			return widen( buff, last, out );
+		}
+
+		wchar_t *write_unit( size_t unit, wchar_t *out ) noexcept {
+			for( auto str = memory_units[unit]; *str != 0; ++str ) {
+				*out++ = *str;
 			}
-			return result;
+			return out;
+		}
+
+		std::wstring_view make_view( format_buffer const &buff,
+		                             wchar_t const *last ) noexcept {
+			return std::wstring_view( buff.data( ),
+			                          static_cast<size_t>( last - buff.data( ) ) );
 		}
 	} // namespace
 
+	std::wstring_view format_integer( uint64_t value,
+	                                  format_buffer &buff ) noexcept {
+		return make_view( buff, write_unsigned( value, buff.data( ) ) );
+	}
+
+	std::wstring_view format_memory( uint64_t value, format_buffer &buff ) noexcept {
+		auto out = buff.data( );
+		if( value < 1024ULL ) {
+			out = write_unsigned( value, out );
+			return make_view( buff, write_unit( 0, out ) );
+		}
+		// Waiting until here accounts for when value.value > 2^53 as by
+		auto val = static_cast<double>( value ) / 1024.0;
+		if( val < 1024.0 ) {
+			out = write_unsigned( static_cast<uint64_t>( std::lround( val ) ), out );
+			return make_view( buff, write_unit( 1, out ) );
+		}
+		size_t unit = 2;
+		val /= 1024.0;
+		while( val >= 1024.0 && unit + 1 < memory_units.size( ) ) {
+			val /= 1024.0;
+			++unit;
+		}
+		out = write_2digit_dec( val, out );
+		return make_view( buff, write_unit( unit, out ) );
+	}
+
+	std::wstring_view format_percent( uint64_t value,
+	                                  format_buffer &buff ) noexcept {
+		auto out = write_unsigned( value / 100U, buff.data( ) );
+		*out++ = L'.';
+		out = write_2digits( static_cast<unsigned>( value % 100U ), out );
+		*out++ = L'%';
+		return make_view( buff, out );
+	}
+
 	int Memory::compare( ColumnItem const &rhs ) const {
 		auto const &val = dynamic_cast<Memory const &>( rhs );
 		if( value < val.value ) {
@@ -67,68 +145,100 @@ namespace daw {
 		: value( str.data( ), str.size( ) ) {
 	}
 
+	// Reuses value's buffer when it is large enough
 	String &String::operator=( std::wstring_view str ) {
-		value = wxString( str.data( ), str.size( ) );
+		value.assign( str.data( ), str.size( ) );
 		return *this;
 	}
 
-	int String::compare( ColumnItem const &rhs ) const {
-		auto const &val = dynamic_cast<String const &>( rhs );
-		auto const rlen = std::min( value.size( ), val.value.size( ) );
-		auto const result = _wcsnicmp( value.c_str( ), val.value.c_str( ), rlen );
+	int compare_nocase( std::wstring_view lhs, std::wstring_view rhs ) noexcept {
+		auto const rlen = std::min( lhs.size( ), rhs.size( ) );
+		for( size_t n = 0; n < rlen; ++n ) {
+			auto const l = fold_case( lhs[n] );
+			auto const r = fold_case( rhs[n] );
+			if( l != r ) {
+				return l < r ? -1 : 1;
+			}
+		}
+		if( lhs.size( ) < rhs.size( ) ) {
+			return -1;
+		}
+		if( lhs.size( ) > rhs.size( ) ) {
+			return 1;
+		}
+		return 0;
+	}
 
-		if( result == 0 ) {
-			if( value.size( ) < rlen ) {
-				return -1;
+	uint64_t folded_sort_key( std::wstring_view str ) noexcept {
+		static constexpr size_t key_units = 4;
+		static constexpr uint64_t max_unit = 0xFFFFU;
+		uint64_t result = 0;
+		for( size_t n = 0; n < key_units; ++n ) {
+			result <<= 16U;
+			if( n >= str.size( ) ) {
+				continue;
 			}
-			if( value.size( ) > rlen ) {
-				return 1;
+			auto const unit = static_cast<uint64_t>( fold_case( str[n] ) );
+			if( unit >= max_unit ) {
+				// Only happens with a 32bit wchar_t.  Anything after it would no
+				// longer order correctly, leave it to compare_nocase
+				result |= max_unit;
+				result <<= 16U * ( key_units - n - 1 );
+				break;
 			}
+			result |= unit;
 		}
 		return result;
 	}
 
+	int String::compare( ColumnItem const &rhs ) const {
+		auto const &val = dynamic_cast<String const &>( rhs );
+		return compare_nocase(
+		  std::wstring_view( value.wc_str( ), value.length( ) ),
+		  std::wstring_view( val.value.wc_str( ), val.value.length( ) ) );
+	}
+
 	wxString memory_value_to_wstring( uint64_t value ) {
-		if( value < 1024ULL ) {
-			return std::to_wstring( value ) + L"B";
-		}
-		// Waiting until here accounts for when value.value > 2^53 as by
-		auto val = static_cast<double>( value ) / 1024.0;
-		if( val < 1024.0 ) {
-			return std::to_wstring( lround( val ) ) + L"KB";
-		}
-		val /= 1024.0;
-		if( val < 1024.0 ) {
-			return to_2digit_dec( val ) + L"MB";
-		}
-		val /= 1024.0;
-		if( val < 1024.0 ) {
-			return to_2digit_dec( val ) + L"GB";
-		}
-		val /= 1024.0;
-		if( val < 1024.0 ) {
-			return to_2digit_dec( val ) + L"TB";
-		}
-		val /= 1024.0;
-		if( val < 1024.0 ) {
-			return to_2digit_dec( val ) + L"PB";
-		}
-		val /= 1024.0;
-		return to_2digit_dec( val ) + L"EB";
+		auto buff = format_buffer{};
+		auto const str = format_memory( value, buff );
+		return wxString( str.data( ), str.size( ) );
 	}
 
 	Memory::Memory( uint64_t v )
-	  : value( v )
-	  , str_value( memory_value_to_wstring( v ) ) {}
+	  : value( v ) {}
 
 	Memory &Memory::operator=( uint64_t v ) {
 		value = v;
-		str_value = memory_value_to_wstring( v );
 		return *this;
 	}
 
 	wxString Memory::to_string( ) const {
-		return str_value;
+		return memory_value_to_wstring( value );
+	}
+
+	Percent::Percent( uint32_t v )
+	  : value( v ) {}
+
+	Percent &Percent::operator=( uint32_t v ) {
+		value = v;
+		return *this;
+	}
+
+	int Percent::compare( ColumnItem const &rhs ) const {
+		auto const &val = dynamic_cast<Percent const &>( rhs );
+		if( value < val.value ) {
+			return -1;
+		}
+		if( value > val.value ) {
+			return 1;
+		}
+		return 0;
+	}
+
+	wxString Percent::to_string( ) const {
+		auto buff = format_buffer{};
+		auto const str = format_percent( value, buff );
+		return wxString( str.data( ), str.size( ) );
 	}
 
 	int Date::compare( ColumnItem const &rhs ) const {
@@ -142,32 +252,63 @@ namespace daw {
 		return 0;
 	}
 
-	namespace {
-		wxString to_date_string( Date::date_formats date_format, wxDateTime const & value ) {
-			switch( date_format ) {
-			case Date::date_formats::DateOnly:
-				return value.FormatISODate( );
-			case Date::date_formats::TimeOnly :
-				return value.FormatTime( );
-			case Date::date_formats::Combined:
-			default:
-				return value.Format( L"%Y-%m-%d %H:%M" );
-			}
+	wxString to_date_string( Date::date_formats date_format, wxDateTime const & value ) {
+		if( !value.IsValid( ) ) {
+			// e.g. the System Idle Process has no creation date
+			return wxString{};
 		}
-	} // namespace
+		auto buff = format_buffer{};
+		auto const str = format_date( date_format, value, buff );
+		if( !str.empty( ) ) {
+			return wxString( str.data( ), str.size( ) );
+		}
+		switch( date_format ) {
+		case Date::date_formats::DateOnly:
+			return value.FormatISODate( );
+		case Date::date_formats::TimeOnly :
+			return value.FormatTime( );
+		case Date::date_formats::Combined:
+		default:
+			return value.Format( L"%Y-%m-%d %H:%M" );
+		}
+	}
+
+	std::wstring_view format_date( Date::date_formats date_format,
+	                               wxDateTime const &value,
+	                               format_buffer &buff ) {
+		if( date_format == Date::date_formats::TimeOnly || !value.IsValid( ) ) {
+			// Locale dependent, left to wxDateTime
+			return {};
+		}
+		auto const tm = value.GetTm( );
+		if( tm.year < 1000 || tm.year > 9999 ) {
+			return {};
+		}
+		// Same as the wxDateTime formats, %Y-%m-%d and %Y-%m-%d %H:%M
+		auto out = write_unsigned( static_cast<uint64_t>( tm.year ), buff.data( ) );
+		*out++ = L'-';
+		out = write_2digits( static_cast<unsigned>( tm.mon ) + 1U, out );
+		*out++ = L'-';
+		out = write_2digits( tm.mday, out );
+		if( date_format == Date::date_formats::Combined ) {
+			*out++ = L' ';
+			out = write_2digits( tm.hour, out );
+			*out++ = L':';
+			out = write_2digits( tm.min, out );
+		}
+		return make_view( buff, out );
+	}
 
 	wxString Date::to_string( ) const {
-		return str_value;
+		return daw::to_date_string( date_format, value );
 	}
 
 	Date::Date( wxDateTime tp, date_formats fmt )
 	  : value( tp )
-	  , date_format( fmt )
-		, str_value( daw::to_date_string( date_format, value ) ) {}
+	  , date_format( fmt ) {}
 
 	Date &Date::operator=( wxDateTime v ) {
 		value = v;
-		str_value = daw::to_date_string( date_format, value );
 		return *this;
 	}
 } // namespace daw
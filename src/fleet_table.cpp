@@ -0,0 +1,347 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <queue>
+#include <utility>
+#include <vector>
+#include <wx/grid.h>
+#include <wx/string.h>
+
+#include "daw/column_items.h"
+#include "daw/fleet_table.h"
+#include "daw/process_store.h"
+#include "daw/wmi_process_table.h"
+
+namespace daw {
+	namespace {
+		wxString host_label( wmi_process_table const &table ) {
+			if( table.host( ) == L"." ) {
+				return L"local machine";
+			}
+			return table.host( );
+		}
+
+		process_store::column_number to_column_number( int col ) {
+			return static_cast<process_store::column_number>( col - 1 );
+		}
+	} // namespace
+
+	// Ascending, ties go to the host added first and then the lower row id
+	bool fleet_table::less( row_ref lhs, row_ref rhs ) const {
+		auto const &l = m_hosts[lhs.host];
+		auto const &r = m_hosts[rhs.host];
+		auto result = 0;
+		if( m_sort_column == host_column ) {
+			result = compare_nocase(
+			  std::wstring_view( l.label.wc_str( ), l.label.length( ) ),
+			  std::wstring_view( r.label.wc_str( ), r.label.length( ) ) );
+		} else {
+			result = compare_rows( l.table->store( ), lhs.id, r.table->store( ),
+			                       rhs.id, to_column_number( m_sort_column ) );
+		}
+		if( result != 0 ) {
+			return result < 0;
+		}
+		if( lhs.host != rhs.host ) {
+			return lhs.host < rhs.host;
+		}
+		return lhs.id < rhs.id;
+	}
+
+	// In the order shown
+	bool fleet_table::comes_before( row_ref lhs, row_ref rhs ) const {
+		if( m_sort_order == SortOrder::Ascending ) {
+			return less( lhs, rhs );
+		}
+		return less( rhs, lhs );
+	}
+
+	// The row at pos of host in the order shown.  Descending reads the
+	// sorted rows from the back
+	fleet_table::row_ref fleet_table::nth( uint32_t host, size_t pos ) const {
+		auto const &sorted = m_hosts[host].sorted;
+		if( m_sort_order == SortOrder::Ascending ) {
+			return row_ref{host, sorted[pos]};
+		}
+		return row_ref{host, sorted[sorted.size( ) - 1 - pos]};
+	}
+
+	size_t fleet_table::shown_count( ) const noexcept {
+		return m_row_limit == 0 ? total_rows( ) : m_row_limit;
+	}
+
+	void fleet_table::sort_host( host_t &host ) {
+		auto const &rows = host.table->rows( );
+		if( m_sort_column == host_column ) {
+			// Every row ties on the host, leaving the row id
+			host.sorted = rows;
+			std::sort( host.sorted.begin( ), host.sorted.end( ) );
+			return;
+		}
+		auto const col = to_column_number( m_sort_column );
+		if( host.sorted.empty( ) ) {
+			host.sorted = rows;
+			sort_rows( host.table->store( ), host.sorted, col, true );
+		} else {
+			// Mostly still in order from the last refresh
+			host.sorted = resort_rows( host.table->store( ), host.sorted, rows, col );
+		}
+	}
+
+	// rows has to be the start of the merged order.  A cursor per host after
+	// its rows in there, the heap's top is the cursor whose row comes next
+	void fleet_table::fill( std::vector<row_ref> &rows, size_t count ) const {
+		struct cursor_t {
+			uint32_t host;
+			size_t pos;
+		};
+		auto positions = std::vector<size_t>( m_hosts.size( ) );
+		for( auto const &ref : rows ) {
+			++positions[ref.host];
+		}
+		auto const comes_later = [&]( cursor_t const &lhs, cursor_t const &rhs ) {
+			return comes_before( nth( rhs.host, rhs.pos ), nth( lhs.host, lhs.pos ) );
+		};
+		auto heap = std::priority_queue<cursor_t, std::vector<cursor_t>,
+		                                decltype( comes_later )>( comes_later );
+		for( uint32_t n = 0; n < m_hosts.size( ); ++n ) {
+			if( positions[n] < m_hosts[n].sorted.size( ) ) {
+				heap.push( cursor_t{n, positions[n]} );
+			}
+		}
+		while( rows.size( ) < count && !heap.empty( ) ) {
+			auto c = heap.top( );
+			heap.pop( );
+			rows.push_back( nth( c.host, c.pos ) );
+			if( ++c.pos < m_hosts[c.host].sorted.size( ) ) {
+				heap.push( c );
+			}
+		}
+	}
+
+	std::vector<fleet_table::row_ref> fleet_table::top( size_t count ) const {
+		auto result = std::vector<row_ref>( );
+		result.reserve( std::min( count, total_rows( ) ) );
+		fill( result, count );
+		return result;
+	}
+
+	size_t fleet_table::total_rows( ) const noexcept {
+		size_t result = 0;
+		for( auto const &host : m_hosts ) {
+			result += host.sorted.size( );
+		}
+		return result;
+	}
+
+	// The rows of the other hosts keep their order, a two way merge puts the
+	// rows of host back in.  Once the rows shown of the others run out, the
+	// rest comes from the k-way merge
+	void fleet_table::merge_host( uint32_t host ) {
+		auto const before = shown( );
+		auto const count = shown_count( );
+		auto const &sorted = m_hosts[host].sorted;
+		auto rows = std::vector<row_ref>( );
+		rows.reserve( std::min( count, total_rows( ) ) );
+		size_t pos = 0;
+		for( auto const &ref : m_rows ) {
+			if( ref.host == host ) {
+				continue;
+			}
+			while( rows.size( ) < count && pos < sorted.size( ) &&
+			       comes_before( nth( host, pos ), ref ) ) {
+				rows.push_back( nth( host, pos++ ) );
+			}
+			if( rows.size( ) == count ) {
+				break;
+			}
+			rows.push_back( ref );
+		}
+		fill( rows, count );
+		set_rows( std::move( rows ), before, m_hosts[host].table );
+	}
+
+	std::vector<fleet_table::shown_t> fleet_table::shown( ) const {
+		auto result = std::vector<shown_t>( );
+		result.reserve( m_rows.size( ) );
+		for( auto const &ref : m_rows ) {
+			result.push_back( shown_t{m_hosts[ref.host].table, ref.id} );
+		}
+		return result;
+	}
+
+	// Tells the grid about the rows that are no longer what was shown
+	// before, and about every row of updated as its values changed in place
+	void fleet_table::set_rows( std::vector<row_ref> rows,
+	                            std::vector<shown_t> const &before,
+	                            wmi_process_table const *updated ) {
+		m_rows = std::move( rows );
+		auto grid = GetView( );
+		if( !grid ) {
+			return;
+		}
+		auto const old_count = before.size( );
+		auto const new_count = m_rows.size( );
+		if( new_count < old_count ) {
+			wxGridTableMessage msg( this, wxGRIDTABLE_NOTIFY_ROWS_DELETED,
+			                        static_cast<int>( new_count ),
+			                        static_cast<int>( old_count - new_count ) );
+			grid->ProcessTableMessage( msg );
+		} else if( new_count > old_count ) {
+			wxGridTableMessage msg( this, wxGRIDTABLE_NOTIFY_ROWS_APPENDED,
+			                        static_cast<int>( new_count - old_count ) );
+			grid->ProcessTableMessage( msg );
+		}
+		auto const is_changed = [&]( size_t row ) {
+			auto const &ref = m_rows[row];
+			auto const &host = m_hosts[ref.host];
+			return row >= old_count || host.table == updated ||
+			       before[row].table != host.table || before[row].id != ref.id;
+		};
+		int width = 0;
+		int height = 0;
+		grid->GetClientSize( &width, &height );
+		// One rect per run of changed rows
+		for( size_t row = 0; row < new_count; ) {
+			if( !is_changed( row ) ) {
+				++row;
+				continue;
+			}
+			auto last = row;
+			while( last + 1 < new_count && is_changed( last + 1 ) ) {
+				++last;
+			}
+			auto const first_rect = grid->CellToRect( static_cast<int>( row ), 0 );
+			auto const last_rect = grid->CellToRect( static_cast<int>( last ), 0 );
+			auto rect = wxRect( 0, first_rect.y, width,
+			                    last_rect.y + last_rect.height - first_rect.y );
+			grid->CalcScrolledPosition( rect.x, rect.y, &rect.x, &rect.y );
+			// The whole width, however far the grid is scrolled
+			rect.x = 0;
+			grid->GetGridWindow( )->RefreshRect( rect );
+			row = last + 1;
+		}
+	}
+
+	void fleet_table::add_host( wmi_process_table const *table ) {
+		m_hosts.push_back( host_t{table, host_label( *table ), {}} );
+		sort_host( m_hosts.back( ) );
+		merge_host( static_cast<uint32_t>( m_hosts.size( ) - 1 ) );
+	}
+
+	void fleet_table::remove_host( wmi_process_table const *table ) {
+		auto pos = std::find_if( m_hosts.begin( ), m_hosts.end( ),
+		                         [&]( host_t const &h ) { return h.table == table; } );
+		if( pos == m_hosts.end( ) ) {
+			return;
+		}
+		auto const before = shown( );
+		auto const removed = static_cast<uint32_t>( pos - m_hosts.begin( ) );
+		m_hosts.erase( pos );
+		// The order of the others stays, only the hosts after it move down
+		auto rows = std::vector<row_ref>( );
+		rows.reserve( m_rows.size( ) );
+		for( auto ref : m_rows ) {
+			if( ref.host == removed ) {
+				continue;
+			}
+			if( ref.host > removed ) {
+				--ref.host;
+			}
+			rows.push_back( ref );
+		}
+		fill( rows, shown_count( ) );
+		set_rows( std::move( rows ), before, nullptr );
+	}
+
+	void fleet_table::host_updated( wmi_process_table const *table ) {
+		for( uint32_t n = 0; n < m_hosts.size( ); ++n ) {
+			if( m_hosts[n].table == table ) {
+				// Only this host is sorted again, the others are only merged
+				sort_host( m_hosts[n] );
+				merge_host( n );
+				return;
+			}
+		}
+	}
+
+	void fleet_table::sort_column( int col, SortOrder sort_order ) {
+		if( sort_order == SortOrder::Next ) {
+			if( col == m_sort_column && m_sort_order == SortOrder::Ascending ) {
+				sort_order = SortOrder::Descending;
+			} else {
+				sort_order = SortOrder::Ascending;
+			}
+		}
+		if( col != m_sort_column ) {
+			m_sort_column = col;
+			for( auto &host : m_hosts ) {
+				host.sorted.clear( );
+				sort_host( host );
+			}
+		}
+		m_sort_order = sort_order;
+		auto const before = shown( );
+		set_rows( top( shown_count( ) ), before, nullptr );
+	}
+
+	void fleet_table::set_row_limit( size_t row_limit ) {
+		m_row_limit = row_limit;
+		auto const before = shown( );
+		auto rows = m_rows;
+		auto const count = shown_count( );
+		if( rows.size( ) > count ) {
+			rows.resize( count );
+		} else {
+			fill( rows, count );
+		}
+		set_rows( std::move( rows ), before, nullptr );
+	}
+
+	int fleet_table::GetNumberRows( ) {
+		return static_cast<int>( m_rows.size( ) );
+	}
+
+	int fleet_table::GetNumberCols( ) {
+		return static_cast<int>( wmi_process::column_names.size( ) ) + 1;
+	}
+
+	wxString fleet_table::GetValue( int row, int col ) {
+		if( row < 0 || static_cast<size_t>( row ) >= m_rows.size( ) ) {
+			return wxString{};
+		}
+		auto const ref = m_rows[static_cast<size_t>( row )];
+		auto const &host = m_hosts[ref.host];
+		if( col == host_column ) {
+			return host.label;
+		}
+		return host.table->store( ).to_string( ref.id, to_column_number( col ) );
+	}
+
+	wxString fleet_table::GetColLabelValue( int col ) {
+		if( col == host_column ) {
+			return L"Host";
+		}
+		return wmi_process::column_names[col - 1];
+	}
+} // namespace daw
@@ -0,0 +1,336 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <wx/datetime.h>
+#include <wx/string.h>
+
+#include "daw/headless_export.h"
+#include "daw/process_source.h"
+#include "daw/process_store.h"
+#include "daw/wmi_projection.h"
+
+namespace daw {
+	namespace {
+		using column_number = wmi_process::column_number;
+		using column_kinds = process_store::column_kinds;
+
+		void append_utf8( std::string &out, std::wstring_view str ) {
+			for( size_t n = 0; n < str.size( ); ++n ) {
+				auto cp = static_cast<uint32_t>( str[n] );
+				if( cp >= 0xD800U && cp < 0xDC00U && n + 1 < str.size( ) ) {
+					// A UTF-16 surrogate pair
+					auto const low = static_cast<uint32_t>( str[n + 1] );
+					if( low >= 0xDC00U && low < 0xE000U ) {
+						cp = 0x10000U + ( ( cp - 0xD800U ) << 10U ) + ( low - 0xDC00U );
+						++n;
+					}
+				}
+				if( cp < 0x80U ) {
+					out += static_cast<char>( cp );
+				} else if( cp < 0x800U ) {
+					out += static_cast<char>( 0xC0U | ( cp >> 6U ) );
+					out += static_cast<char>( 0x80U | ( cp & 0x3FU ) );
+				} else if( cp < 0x10000U ) {
+					out += static_cast<char>( 0xE0U | ( cp >> 12U ) );
+					out += static_cast<char>( 0x80U | ( ( cp >> 6U ) & 0x3FU ) );
+					out += static_cast<char>( 0x80U | ( cp & 0x3FU ) );
+				} else {
+					out += static_cast<char>( 0xF0U | ( cp >> 18U ) );
+					out += static_cast<char>( 0x80U | ( ( cp >> 12U ) & 0x3FU ) );
+					out += static_cast<char>( 0x80U | ( ( cp >> 6U ) & 0x3FU ) );
+					out += static_cast<char>( 0x80U | ( cp & 0x3FU ) );
+				}
+			}
+		}
+
+		std::wstring_view to_view( wxString const &str ) {
+			return std::wstring_view( str.wc_str( ), str.length( ) );
+		}
+
+		void append_2digits( std::string &out, unsigned value ) {
+			out += static_cast<char>( '0' + ( value / 10U ) % 10U );
+			out += static_cast<char>( '0' + value % 10U );
+		}
+
+		// YYYY-MM-DDTHH:MM:SS
+		void append_iso( std::string &out, int year, unsigned month, unsigned day,
+		                 unsigned hour, unsigned minute, unsigned second ) {
+			out += std::to_string( year );
+			out += '-';
+			append_2digits( out, month );
+			out += '-';
+			append_2digits( out, day );
+			out += 'T';
+			append_2digits( out, hour );
+			out += ':';
+			append_2digits( out, minute );
+			out += ':';
+			append_2digits( out, second );
+		}
+
+		// In UTC, without depending on the platform's gmtime
+		std::string to_iso( std::chrono::system_clock::time_point time ) {
+			using namespace std::chrono;
+			auto const secs = duration_cast<seconds>( time.time_since_epoch( ) ).count( );
+			auto days = secs / 86400;
+			auto rem = secs % 86400;
+			if( rem < 0 ) {
+				rem += 86400;
+				--days;
+			}
+			// Civil date from days since 1970-01-01
+			days += 719468;
+			auto const era = ( days >= 0 ? days : days - 146096 ) / 146097;
+			auto const doe = static_cast<unsigned>( days - era * 146097 );
+			auto const yoe = ( doe - doe / 1460 + doe / 36524 - doe / 146096 ) / 365;
+			auto const doy = doe - ( 365 * yoe + yoe / 4 - yoe / 100 );
+			auto const mp = ( 5 * doy + 2 ) / 153;
+			auto const day = doy - ( 153 * mp + 2 ) / 5 + 1;
+			auto const month = mp < 10 ? mp + 3 : mp - 9;
+			auto const year = static_cast<int>( yoe ) + static_cast<int>( era * 400 ) +
+			                  ( month <= 2 ? 1 : 0 );
+			auto result = std::string( );
+			append_iso( result, year, month, day, static_cast<unsigned>( rem / 3600 ),
+			            static_cast<unsigned>( rem / 60 % 60 ),
+			            static_cast<unsigned>( rem % 60 ) );
+			result += 'Z';
+			return result;
+		}
+
+		struct row_writer {
+			export_formats format;
+			std::vector<column_number> columns;
+			std::string host;
+			std::string time;
+
+			void append_text( std::string &out, std::string_view text ) const {
+				if( format == export_formats::Ndjson ) {
+					out += '"';
+					for( auto c : text ) {
+						switch( c ) {
+						case '"':
+							out += "\\\"";
+							break;
+						case '\\':
+							out += "\\\\";
+							break;
+						case '\n':
+							out += "\\n";
+							break;
+						case '\r':
+							out += "\\r";
+							break;
+						case '\t':
+							out += "\\t";
+							break;
+						default:
+							if( static_cast<unsigned char>( c ) < 0x20U ) {
+								static constexpr char hex[] = "0123456789abcdef";
+								out += "\\u00";
+								out += hex[( c >> 4 ) & 0xF];
+								out += hex[c & 0xF];
+							} else {
+								out += c;
+							}
+						}
+					}
+					out += '"';
+					return;
+				}
+				if( text.find_first_of( ",\"\r\n" ) == std::string_view::npos ) {
+					out += text;
+					return;
+				}
+				out += '"';
+				for( auto c : text ) {
+					if( c == '"' ) {
+						out += '"';
+					}
+					out += c;
+				}
+				out += '"';
+			}
+
+			void append_name( std::string &out, wxString const &name ) const {
+				auto utf8 = std::string( );
+				append_utf8( utf8, to_view( name ) );
+				append_text( out, utf8 );
+			}
+
+			void append_header( std::string &out ) const {
+				if( format == export_formats::Ndjson ) {
+					return;
+				}
+				out += "Host,Time";
+				for( auto col : columns ) {
+					out += ',';
+					append_name( out, wmi_process::column_names[static_cast<size_t>( col )] );
+				}
+				out += '\n';
+			}
+
+			void append_value( std::string &out, wmi_process const &row,
+			                   column_number col ) const {
+				process_store::visit_column( col, [&]( auto c ) {
+					constexpr auto cn = decltype( c )::value;
+					auto const &field = row.column<cn>( );
+					if constexpr( process_store::column_kind<cn>( ) == column_kinds::String ) {
+						auto utf8 = std::string( );
+						append_utf8( utf8, to_view( field.value ) );
+						append_text( out, utf8 );
+					} else if constexpr( process_store::column_kind<cn>( ) ==
+					                     column_kinds::Date ) {
+						if( !field.value.IsValid( ) ) {
+							if( format == export_formats::Ndjson ) {
+								out += "null";
+							}
+							return;
+						}
+						// In UTC like the Time column
+						auto const tm = field.value.GetTm( wxDateTime::UTC );
+						auto iso = std::string( );
+						append_iso( iso, tm.year, static_cast<unsigned>( tm.mon ) + 1U, tm.mday,
+						            tm.hour, tm.min, tm.sec );
+						iso += 'Z';
+						append_text( out, iso );
+					} else if constexpr( process_store::column_kind<cn>( ) ==
+					                     column_kinds::Percent ) {
+						out += std::to_string( field.value / 100U );
+						out += '.';
+						append_2digits( out, field.value % 100U );
+					} else {
+						out += std::to_string( field.value );
+					}
+				} );
+			}
+
+			void append_row( std::string &out, wmi_process const &row ) const {
+				auto const is_json = format == export_formats::Ndjson;
+				out += is_json ? "{\"Host\":" : "";
+				append_text( out, host );
+				out += is_json ? ",\"Time\":" : ",";
+				append_text( out, time );
+				for( auto col : columns ) {
+					out += ',';
+					if( is_json ) {
+						append_name( out, wmi_process::column_names[static_cast<size_t>( col )] );
+						out += ':';
+					}
+					append_value( out, row, col );
+				}
+				out += is_json ? "}\n" : "\n";
+			}
+		};
+
+		size_t collect( std::vector<std::wstring> const &hosts,
+		                export_options const &opts, std::vector<column_number> const &columns,
+		                std::ostream &out, std::ostream &err ) {
+			auto const time = to_iso( std::chrono::system_clock::now( ) );
+			std::mutex out_mutex;
+			std::atomic<size_t> next_host{0};
+			std::atomic<size_t> failures{0};
+			auto const write = [&]( std::ostream &os, std::string &buffer ) {
+				std::lock_guard<std::mutex> lck( out_mutex );
+				os.write( buffer.data( ), static_cast<std::streamsize>( buffer.size( ) ) );
+				os.flush( );
+				buffer.clear( );
+			};
+			auto const worker = [&]( ) {
+				auto buffer = std::string( );
+				buffer.reserve( opts.buffer_size + 4096 );
+				for( auto n = next_host++; n < hosts.size( ); n = next_host++ ) {
+					auto writer = row_writer{opts.format, columns, {}, time};
+					append_utf8( writer.host, hosts[n] );
+					try {
+						opts.processes->for_each_process(
+						  hosts[n], opts.columns, [&]( wmi_process const &row ) {
+							  writer.append_row( buffer, row );
+							  if( buffer.size( ) >= opts.buffer_size ) {
+								  write( out, buffer );
+							  }
+						  } );
+						write( out, buffer );
+					} catch( std::exception const &ex ) {
+						// The rows written so far stay, the rest of the host is lost
+						write( out, buffer );
+						++failures;
+						auto msg = writer.host + ": " + ex.what( ) + '\n';
+						write( err, msg );
+					}
+				}
+			};
+			auto const thread_count =
+			  std::min( std::max<size_t>( opts.concurrency, 1 ), hosts.size( ) );
+			auto threads = std::vector<std::thread>( );
+			threads.reserve( thread_count );
+			for( size_t n = 1; n < thread_count; ++n ) {
+				threads.emplace_back( worker );
+			}
+			worker( );
+			for( auto &t : threads ) {
+				t.join( );
+			}
+			return failures;
+		}
+	} // namespace
+
+	column_set default_export_columns( ) {
+		using cn = column_number;
+		return all_columns( ) & ~make_column_set( {cn::CpuUsage, cn::ReadRate,
+		                                           cn::WriteRate, cn::PageFaultRate} );
+	}
+
+	size_t export_processes( std::vector<std::wstring> const &hosts,
+	                         export_options const &opts, std::ostream &out,
+	                         std::ostream &err ) {
+		auto columns = std::vector<column_number>( );
+		for( size_t n = 0; n < wmi_process::column_count; ++n ) {
+			if( opts.columns[n] ) {
+				columns.push_back( static_cast<column_number>( n ) );
+			}
+		}
+		{
+			auto header = std::string( );
+			row_writer{opts.format, columns, {}, {}}.append_header( header );
+			out << header << std::flush;
+		}
+		while( true ) {
+			auto const start = std::chrono::steady_clock::now( );
+			auto const failures = collect( hosts, opts, columns, out, err );
+			if( opts.interval.count( ) <= 0 ) {
+				return failures;
+			}
+			std::this_thread::sleep_until( start + opts.interval );
+		}
+	}
+} // namespace daw
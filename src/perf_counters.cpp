@@ -0,0 +1,66 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "daw/perf_counters.h"
+#include "daw/process_rates.h"
+#include "daw/wmi_projection.h"
+
+namespace daw {
+	namespace {
+		// 1601-01-01 to 1970-01-01 in 100ns units
+		constexpr uint64_t filetime_unix_epoch = 116'444'736'000'000'000ULL;
+
+		using hundred_ns = std::chrono::duration<int64_t, std::ratio<1, 10'000'000>>;
+	} // namespace
+
+	column_set raw_counter_columns( ) {
+		return counter_columns( );
+	}
+
+	void apply_raw_counters( raw_process_counters const &raw, wmi_process &row ) {
+		row.process_id = raw.process_id;
+		row.cpu_time = raw.processor_time;
+		row.read_transfer_count = raw.io_read_bytes;
+		row.write_transfer_count = raw.io_write_bytes;
+		row.page_faults = raw.page_faults;
+		row.thread_count = raw.thread_count;
+		row.working_set_size = raw.working_set;
+		row.peak_working_set_size = raw.working_set_peak;
+		// Private Bytes is the commit charge Win32_Process calls PageFileUsage
+		row.page_file_usage = raw.private_bytes;
+		row.peak_page_file_usage = raw.page_file_bytes_peak;
+	}
+
+	process_rates::clock::time_point sample_time( raw_counter_sample const &sample ) {
+		// Counted from 1970, from 1601 a nanosecond clock would overflow
+		auto const since_epoch = sample.timestamp > filetime_unix_epoch
+		                           ? sample.timestamp - filetime_unix_epoch
+		                           : 0;
+		return process_rates::clock::time_point(
+		  std::chrono::duration_cast<process_rates::clock::duration>(
+		    hundred_ns( static_cast<int64_t>( since_epoch ) ) ) );
+	}
+} // namespace daw
@@ -0,0 +1,494 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <dirent.h>
+#include <fcntl.h>
+#include <functional>
+#include <memory>
+#include <signal.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <system_error>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+#include <wx/datetime.h>
+#include <wx/string.h>
+
+#include "daw/parallel.h"
+#include "daw/process_source.h"
+#include "daw/wmi_projection.h"
+
+namespace daw {
+	namespace {
+		using column_number = wmi_process::column_number;
+
+		// Closes the descriptor when done
+		struct file_handle {
+			int fd = -1;
+
+			explicit file_handle( int f ) noexcept
+			  : fd( f ) {}
+			file_handle( file_handle const & ) = delete;
+			file_handle &operator=( file_handle const & ) = delete;
+
+			~file_handle( ) {
+				if( fd >= 0 ) {
+					::close( fd );
+				}
+			}
+		};
+
+		struct dir_handle {
+			DIR *dir;
+
+			explicit dir_handle( DIR *d ) noexcept
+			  : dir( d ) {}
+			dir_handle( dir_handle const & ) = delete;
+			dir_handle &operator=( dir_handle const & ) = delete;
+
+			~dir_handle( ) {
+				if( dir != nullptr ) {
+					::closedir( dir );
+				}
+			}
+		};
+
+		template<typename Integer>
+		bool parse_integer( std::string_view str, Integer &value ) noexcept {
+			auto const result =
+			  std::from_chars( str.data( ), str.data( ) + str.size( ), value );
+			return result.ec == std::errc{ };
+		}
+
+		// The value of a "Key:   1234 kB" line of /proc/[pid]/status, in bytes
+		uint64_t status_kb( std::string_view status, std::string_view key ) noexcept {
+			for( size_t pos = 0; pos < status.size( ); ) {
+				auto const eol = std::min( status.find( '\n', pos ), status.size( ) );
+				auto const line = status.substr( pos, eol - pos );
+				pos = eol + 1;
+				if( line.size( ) <= key.size( ) || line.substr( 0, key.size( ) ) != key ||
+				    line[key.size( )] != ':' ) {
+					continue;
+				}
+				auto const first = line.find_first_not_of( " \t", key.size( ) + 1 );
+				uint64_t value = 0;
+				if( first != std::string_view::npos ) {
+					std::from_chars( line.data( ) + first, line.data( ) + line.size( ),
+					                 value );
+				}
+				return value * 1024U;
+			}
+			return 0;
+		}
+
+		// The value of a "key: 1234" line of /proc/[pid]/io
+		uint64_t io_value( std::string_view io, std::string_view key ) noexcept {
+			for( size_t pos = 0; pos < io.size( ); ) {
+				auto const eol = std::min( io.find( '\n', pos ), io.size( ) );
+				auto const line = io.substr( pos, eol - pos );
+				pos = eol + 1;
+				if( line.size( ) > key.size( ) + 1 &&
+				    line.substr( 0, key.size( ) ) == key && line[key.size( )] == ':' ) {
+					uint64_t value = 0;
+					parse_integer( line.substr( key.size( ) + 2 ), value );
+					return value;
+				}
+			}
+			return 0;
+		}
+
+		// Invalid sequences become U+FFFD
+		void append_wide( std::wstring &out, std::string_view utf8 ) {
+			static constexpr uint32_t replacement = 0xFFFDU;
+			for( size_t n = 0; n < utf8.size( ); ) {
+				auto const lead = static_cast<uint8_t>( utf8[n++] );
+				uint32_t cp = lead;
+				size_t trail = 0;
+				uint32_t min_cp = 0;
+				if( lead >= 0xF0U && lead < 0xF8U ) {
+					cp = lead & 0x07U;
+					trail = 3;
+					min_cp = 0x10000U;
+				} else if( lead >= 0xE0U ) {
+					cp = lead & 0x0FU;
+					trail = 2;
+					min_cp = 0x800U;
+				} else if( lead >= 0xC0U ) {
+					cp = lead & 0x1FU;
+					trail = 1;
+					min_cp = 0x80U;
+				} else if( lead >= 0x80U ) {
+					cp = replacement;
+				}
+				if( lead >= 0xF8U ) {
+					cp = replacement;
+					trail = 0;
+				}
+				for( ; trail > 0; --trail ) {
+					if( n == utf8.size( ) ||
+					    ( static_cast<uint8_t>( utf8[n] ) & 0xC0U ) != 0x80U ) {
+						cp = replacement;
+						break;
+					}
+					cp = ( cp << 6U ) | ( static_cast<uint8_t>( utf8[n++] ) & 0x3FU );
+				}
+				if( cp < min_cp || cp > 0x10FFFFU || ( cp >= 0xD800U && cp < 0xE000U ) ) {
+					cp = replacement;
+				}
+				if constexpr( sizeof( wchar_t ) == 2 ) {
+					if( cp >= 0x10000U ) {
+						cp -= 0x10000U;
+						out += static_cast<wchar_t>( 0xD800U + ( cp >> 10U ) );
+						out += static_cast<wchar_t>( 0xDC00U + ( cp & 0x3FFU ) );
+						continue;
+					}
+				}
+				out += static_cast<wchar_t>( cp );
+			}
+		}
+
+		class proc_process_source final : public process_source {
+			std::string m_root;
+			// m_root, the per process files are opened relative to it
+			int m_root_fd;
+			uint64_t m_ticks_per_second;
+			uint64_t m_page_size;
+			// When the system booted, in ms since the epoch.  Process start times
+			// are in ticks since boot
+			int64_t m_boot_time_ms = 0;
+
+			// Reads the files of one process at a time.  The buffers are reused
+			// from one process to the next, a refresh of many processes does not
+			// allocate per file
+			class reader {
+				proc_process_source const *m_source;
+				std::string m_buffer;
+				std::wstring m_text;
+				std::array<char, 64> m_path{};
+
+			public:
+				explicit reader( proc_process_source const &source )
+				  : m_source( &source ) {
+
+					m_buffer.resize( 4096 );
+				}
+
+				// The whole of /proc/[pid]/name, empty when the file could not be
+				// read, e.g. the process ended or belongs to another user
+				std::string_view read( uint32_t pid, char const *name ) {
+					auto const len =
+					  std::snprintf( m_path.data( ), m_path.size( ), "%u/%s", pid, name );
+					if( len <= 0 || static_cast<size_t>( len ) >= m_path.size( ) ) {
+						return {};
+					}
+					auto const file = file_handle(
+					  ::openat( m_source->m_root_fd, m_path.data( ), O_RDONLY | O_CLOEXEC ) );
+					if( file.fd < 0 ) {
+						return {};
+					}
+					size_t size = 0;
+					while( true ) {
+						if( size == m_buffer.size( ) ) {
+							m_buffer.resize( m_buffer.size( ) * 2 );
+						}
+						auto const count =
+						  ::pread( file.fd, m_buffer.data( ) + size, m_buffer.size( ) - size,
+						           static_cast<off_t>( size ) );
+						if( count < 0 ) {
+							return {};
+						}
+						if( count == 0 ) {
+							break;
+						}
+						size += static_cast<size_t>( count );
+					}
+					return std::string_view( m_buffer.data( ), size );
+				}
+
+				// utf8 decoded, valid until the next call
+				std::wstring_view widen( std::string_view utf8 ) {
+					m_text.clear( );
+					append_wide( m_text, utf8 );
+					return m_text;
+				}
+
+				// The arguments in /proc/[pid]/cmdline are separated by, and end
+				// with, a '\0'.  Decoded with spaces between them, valid until the
+				// next call
+				std::wstring_view widen_arguments( std::string_view cmdline ) {
+					while( !cmdline.empty( ) && cmdline.back( ) == '\0' ) {
+						cmdline.remove_suffix( 1 );
+					}
+					widen( cmdline );
+					std::replace( m_text.begin( ), m_text.end( ), L'\0', L' ' );
+					return m_text;
+				}
+			};
+
+			// Fills the columns of row from /proc/[pid], the ones not in columns
+			// are cleared.  row may hold the previous process, its strings keep
+			// their buffers.  False when the process is gone
+			bool read_process( reader &rdr, uint32_t pid, column_set columns,
+			                   wmi_process &row ) const {
+				auto const has = [&]( column_number col ) {
+					return columns.test( static_cast<size_t>( col ) );
+				};
+				// pid (comm) state ppid ..., comm can hold spaces and parentheses
+				auto const stat = rdr.read( pid, "stat" );
+				auto const comm_first = stat.find( '(' );
+				auto const comm_last = stat.rfind( ')' );
+				if( comm_first == std::string_view::npos ||
+				    comm_last == std::string_view::npos || comm_last < comm_first ) {
+					return false;
+				}
+				// fields[0] is field 3 of proc(5), state
+				std::array<uint64_t, 22> fields{};
+				{
+					auto rest = stat.substr( comm_last + 1 );
+					size_t n = 0;
+					while( n < fields.size( ) ) {
+						auto const first = rest.find_first_not_of( ' ' );
+						if( first == std::string_view::npos ) {
+							break;
+						}
+						rest.remove_prefix( first );
+						auto const last = std::min( rest.find( ' ' ), rest.size( ) );
+						parse_integer( rest.substr( 0, last ), fields[n++] );
+						rest.remove_prefix( last );
+					}
+					if( n < fields.size( ) ) {
+						return false;
+					}
+				}
+				auto const field = [&]( size_t number ) { return fields[number - 3]; };
+
+				row.process_id = pid;
+				row.name = has( column_number::Name )
+				             ? rdr.widen( stat.substr( comm_first + 1,
+				                                       comm_last - comm_first - 1 ) )
+				             : std::wstring_view( );
+				auto handle_buff = format_buffer{};
+				row.handle = has( column_number::Handle )
+				               ? format_integer( pid, handle_buff )
+				               : std::wstring_view( );
+				row.parent_process_id = field( 4 );
+				row.session_id = field( 6 );
+				row.page_faults = field( 10 ) + field( 12 );
+				row.thread_count = field( 20 );
+				row.cpu_time =
+				  ( field( 14 ) + field( 15 ) ) * 10'000'000U / m_ticks_per_second;
+				row.creation_date = wxDateTime( wxLongLong(
+				  m_boot_time_ms +
+				  static_cast<int64_t>( field( 22 ) * 1000U / m_ticks_per_second ) ) );
+
+				// size resident shared text lib data dt, in pages
+				auto pages = std::array<uint64_t, 6>{};
+				if( has( column_number::WorkingSetSize ) ||
+				    has( column_number::PageFileUsage ) ) {
+					auto statm = rdr.read( pid, "statm" );
+					for( auto &value : pages ) {
+						auto const first = statm.find_first_not_of( ' ' );
+						if( first == std::string_view::npos ) {
+							break;
+						}
+						statm.remove_prefix( first );
+						auto const last = std::min( statm.find( ' ' ), statm.size( ) );
+						parse_integer( statm.substr( 0, last ), value );
+						statm.remove_prefix( last );
+					}
+				}
+				row.working_set_size = pages[1] * m_page_size;
+				// Data plus stack is the closest to the private bytes Windows
+				// reports as the page file usage
+				row.page_file_usage = pages[5] * m_page_size;
+
+				auto status = std::string_view( );
+				if( has( column_number::PeakWorkingSetSize ) ||
+				    has( column_number::PeakPageFileUsage ) ) {
+					status = rdr.read( pid, "status" );
+				}
+				row.peak_working_set_size = status_kb( status, "VmHWM" );
+				// Nothing keeps the peak of data plus stack.  The peak virtual
+				// size bounds it from above, mapped files and reserved but
+				// untouched memory included
+				row.peak_page_file_usage = status_kb( status, "VmPeak" );
+
+				auto io = std::string_view( );
+				if( has( column_number::ReadTransferCount ) ||
+				    has( column_number::WriteTransferCount ) ) {
+					// Only readable for our own processes unless privileged, the
+					// others are left at 0.  Like Windows these count every read and
+					// write, not only the ones that reached the disk
+					io = rdr.read( pid, "io" );
+				}
+				row.read_transfer_count = io_value( io, "rchar" );
+				row.write_transfer_count = io_value( io, "wchar" );
+
+				auto command_line = std::wstring_view( );
+				if( has( column_number::CommandLine ) ) {
+					command_line = rdr.widen_arguments( rdr.read( pid, "cmdline" ) );
+				}
+				row.command_line = command_line;
+				return true;
+			}
+
+			// The numeric entries of m_root
+			std::vector<uint32_t> list_processes( ) const {
+				auto const dir = dir_handle( ::opendir( m_root.c_str( ) ) );
+				if( dir.dir == nullptr ) {
+					throw std::system_error( errno, std::generic_category( ),
+					                         "Could not list " + m_root );
+				}
+				auto result = std::vector<uint32_t>( );
+				while( auto const entry = ::readdir( dir.dir ) ) {
+					auto const name = std::string_view( entry->d_name );
+					uint32_t pid = 0;
+					if( name.find_first_not_of( "0123456789" ) == std::string_view::npos &&
+					    parse_integer( name, pid ) ) {
+						result.push_back( pid );
+					}
+				}
+				return result;
+			}
+
+			// Reads the processes in process_ids, on several threads when there
+			// are many
+			std::vector<wmi_process> read_processes( std::vector<uint32_t> const &process_ids,
+			                                         column_set columns ) const {
+				// Below this the threads cost more than they save
+				static constexpr size_t min_chunk_size = 512;
+				auto result = std::vector<wmi_process>( process_ids.size( ) );
+				auto is_found = std::vector<char>( process_ids.size( ) );
+				parallel_for(
+				  process_ids.size( ),
+				  [&]( size_t first, size_t last ) {
+					  auto rdr = reader( *this );
+					  for( ; first < last; ++first ) {
+						  is_found[first] =
+						    read_process( rdr, process_ids[first], columns, result[first] );
+					  }
+				  },
+				  0, min_chunk_size );
+				size_t out = 0;
+				for( size_t n = 0; n < result.size( ); ++n ) {
+					if( is_found[n] ) {
+						if( out != n ) {
+							result[out] = std::move( result[n] );
+						}
+						++out;
+					}
+				}
+				result.resize( out );
+				return result;
+			}
+
+			static void check_host( std::wstring const &host ) {
+				if( !host.empty( ) && host != L"." && host != L"localhost" ) {
+					throw std::invalid_argument(
+					  "Processes can only be read from the local host" );
+				}
+			}
+
+		public:
+			explicit proc_process_source( std::string root )
+			  : m_root( std::move( root ) )
+			  , m_root_fd( ::open( m_root.c_str( ), O_RDONLY | O_DIRECTORY | O_CLOEXEC ) )
+			  , m_ticks_per_second( static_cast<uint64_t>( ::sysconf( _SC_CLK_TCK ) ) )
+			  , m_page_size( static_cast<uint64_t>( ::sysconf( _SC_PAGESIZE ) ) ) {
+
+				if( m_root_fd < 0 ) {
+					throw std::system_error( errno, std::generic_category( ),
+					                         "Could not open " + m_root );
+				}
+				// The stat of the system, not of a process
+				if( auto const file = file_handle( ::openat(
+				      m_root_fd, "stat", O_RDONLY | O_CLOEXEC ) );
+				    file.fd >= 0 ) {
+					auto buff = std::string( 64 * 1024, '\0' );
+					auto const count = ::pread( file.fd, buff.data( ), buff.size( ), 0 );
+					buff.resize( count > 0 ? static_cast<size_t>( count ) : 0 );
+					auto const pos = buff.find( "\nbtime " );
+					if( pos != std::string::npos ) {
+						auto const first = buff.data( ) + pos + 7;
+						std::from_chars( first, buff.data( ) + buff.size( ), m_boot_time_ms );
+						m_boot_time_ms *= 1000;
+					}
+				}
+			}
+
+			~proc_process_source( ) override {
+				::close( m_root_fd );
+			}
+
+			std::vector<wmi_process> get_processes( std::wstring const &host,
+			                                        column_set columns ) override {
+				check_host( host );
+				return read_processes( list_processes( ),
+				                       with_rate_sources( columns | required_columns( ) ) );
+			}
+
+			std::vector<wmi_process>
+			get_processes( std::wstring const &host, column_set columns,
+			               std::vector<uint32_t> const &process_ids ) override {
+				check_host( host );
+				return read_processes( process_ids,
+				                       with_rate_sources( columns | required_columns( ) ) );
+			}
+
+			void for_each_process(
+			  std::wstring const &host, column_set columns,
+			  std::function<void( wmi_process const & )> const &func ) override {
+				check_host( host );
+				columns = with_rate_sources( columns | required_columns( ) );
+				auto rdr = reader( *this );
+				// Reused, read_process writes every column
+				auto row = wmi_process( );
+				for( auto pid : list_processes( ) ) {
+					if( read_process( rdr, pid, columns, row ) ) {
+						func( row );
+					}
+				}
+			}
+
+			void terminate_process( std::wstring const &host, uint32_t pid ) override {
+				check_host( host );
+				if( ::kill( static_cast<pid_t>( pid ), SIGTERM ) != 0 ) {
+					throw std::system_error( errno, std::generic_category( ),
+					                         "Could not terminate process" );
+				}
+			}
+		};
+	} // namespace
+
+	std::shared_ptr<process_source> make_proc_process_source( std::string proc_root ) {
+		return std::make_shared<proc_process_source>( std::move( proc_root ) );
+	}
+} // namespace daw
@@ -0,0 +1,214 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "daw/process_history.h"
+#include "daw/process_store.h"
+
+namespace daw {
+	namespace {
+		// Samples a process may fall behind the window before its series are
+		// trimmed, so that bytes are not erased from the front every sample
+		constexpr uint64_t trim_batch = 32;
+
+		constexpr uint64_t zigzag( int64_t value ) noexcept {
+			return ( static_cast<uint64_t>( value ) << 1U ) ^
+			       static_cast<uint64_t>( value >> 63 );
+		}
+
+		constexpr int64_t unzigzag( uint64_t value ) noexcept {
+			return static_cast<int64_t>( value >> 1U ) ^
+			       -static_cast<int64_t>( value & 1U );
+		}
+
+		void write_varint( uint64_t value, std::vector<uint8_t> &out ) {
+			while( value >= 0x80U ) {
+				out.push_back( static_cast<uint8_t>( value | 0x80U ) );
+				value >>= 7U;
+			}
+			out.push_back( static_cast<uint8_t>( value ) );
+		}
+
+		uint64_t read_varint( uint8_t const *&first ) noexcept {
+			uint64_t result = 0;
+			unsigned shift = 0;
+			while( *first & 0x80U ) {
+				result |= static_cast<uint64_t>( *first++ & 0x7FU ) << shift;
+				shift += 7;
+			}
+			result |= static_cast<uint64_t>( *first++ ) << shift;
+			return result;
+		}
+
+		std::array<uint64_t, process_history::series_count>
+		sample_of( wmi_process const &row ) {
+			return {row.working_set_size.value, row.read_rate.value,
+			        row.write_rate.value};
+		}
+	} // namespace
+
+	void process_history::series_t::push_back( uint64_t value ) {
+		// Wraps around for decreases, which unzigzag undoes
+		write_varint( zigzag( static_cast<int64_t>( value - last ) ), deltas );
+		last = value;
+	}
+
+	void process_history::series_t::pop_front( size_t count ) {
+		auto pos = static_cast<uint8_t const *>( deltas.data( ) );
+		for( size_t n = 0; n < count; ++n ) {
+			first += static_cast<uint64_t>( unzigzag( read_varint( pos ) ) );
+		}
+		deltas.erase( deltas.begin( ), deltas.begin( ) + ( pos - deltas.data( ) ) );
+	}
+
+	void process_history::series_t::decode( std::vector<uint64_t> &values ) const {
+		auto value = first;
+		values.push_back( value );
+		auto pos = static_cast<uint8_t const *>( deltas.data( ) );
+		auto const last_pos = pos + deltas.size( );
+		while( pos != last_pos ) {
+			value += static_cast<uint64_t>( unzigzag( read_varint( pos ) ) );
+			values.push_back( value );
+		}
+	}
+
+	double
+	process_history::stats_t::bytes_per_1k_process_hours( ) const noexcept {
+		auto const hours =
+		  std::chrono::duration<double, std::ratio<3600>>( span ).count( );
+		if( process_count == 0 || hours <= 0.0 ) {
+			return 0.0;
+		}
+		return static_cast<double>( memory_used ) * 1000.0 /
+		       static_cast<double>( process_count ) / hours;
+	}
+
+	process_history::process_history( options_t const &options )
+	  : m_options( options ) {}
+
+	void process_history::trim( process_t &process ) const {
+		if( process.first_sample + trim_batch > m_first_sample ) {
+			return;
+		}
+		auto const count = m_first_sample - process.first_sample;
+		for( auto &s : process.series ) {
+			s.pop_front( count );
+		}
+		process.first_sample = m_first_sample;
+	}
+
+	void process_history::record( std::vector<wmi_process> const &rows,
+	                              clock::time_point now ) {
+		auto const sample = m_next_sample++;
+		m_sample_times.push_back( now );
+		while( m_sample_times.size( ) > std::max<size_t>( m_options.max_samples, 1 ) ||
+		       now - m_sample_times.front( ) > m_options.window ) {
+			m_sample_times.pop_front( );
+			++m_first_sample;
+		}
+		for( auto const &row : rows ) {
+			auto const key = key_of( row );
+			auto const values = sample_of( row );
+			auto [pos, is_new] = m_processes.try_emplace( key );
+			auto &process = pos->second;
+			if( is_new ) {
+				process.first_sample = sample;
+				for( size_t n = 0; n < series_count; ++n ) {
+					process.series[n].first = values[n];
+					process.series[n].last = values[n];
+				}
+			} else {
+				for( size_t n = 0; n < series_count; ++n ) {
+					auto &s = process.series[n];
+					// Missed samples repeat the last value
+					for( auto gap = process.last_sample + 1; gap < sample; ++gap ) {
+						s.push_back( s.last );
+					}
+					s.push_back( values[n] );
+				}
+			}
+			process.last_sample = sample;
+			trim( process );
+		}
+		// Gone for the whole window
+		for( auto it = m_processes.begin( ); it != m_processes.end( ); ) {
+			if( it->second.last_sample < m_first_sample ) {
+				it = m_processes.erase( it );
+			} else {
+				++it;
+			}
+		}
+	}
+
+	std::vector<uint64_t> process_history::series( row_key const &key,
+	                                               series_kinds kind ) const {
+		auto result = std::vector<uint64_t>( );
+		auto pos = m_processes.find( key );
+		if( pos == m_processes.end( ) ) {
+			return result;
+		}
+		auto const &process = pos->second;
+		result.reserve( process.last_sample - process.first_sample + 1 );
+		process.series[static_cast<size_t>( kind )].decode( result );
+		if( process.first_sample < m_first_sample ) {
+			// Not trimmed yet
+			result.erase( result.begin( ),
+			              result.begin( ) + static_cast<std::ptrdiff_t>(
+			                                  m_first_sample - process.first_sample ) );
+		}
+		return result;
+	}
+
+	process_history::stats_t process_history::stats( ) const {
+		auto result = stats_t{};
+		result.process_count = m_processes.size( );
+		result.memory_used = sizeof( *this ) +
+		                     m_sample_times.size( ) * sizeof( clock::time_point ) +
+		                     m_processes.bucket_count( ) * sizeof( void * );
+		for( auto const &[key, process] : m_processes ) {
+			// The node holds the key, the value and the next pointer
+			result.memory_used +=
+			  sizeof( key ) + sizeof( process ) + sizeof( void * );
+			for( auto const &s : process.series ) {
+				result.memory_used += s.deltas.capacity( );
+			}
+			result.sample_count += static_cast<size_t>(
+			  process.last_sample -
+			  std::max( process.first_sample, m_first_sample ) + 1 );
+		}
+		if( !m_sample_times.empty( ) ) {
+			result.span = m_sample_times.back( ) - m_sample_times.front( );
+		}
+		return result;
+	}
+
+	void process_history::clear( ) {
+		m_processes.clear( );
+		m_sample_times.clear( );
+		m_first_sample = m_next_sample;
+	}
+} // namespace daw
@@ -0,0 +1,131 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "daw/process_rates.h"
+#include "daw/process_store.h"
+
+namespace daw {
+	namespace {
+		// Change per second, 0 when the counter went backwards
+		template<typename T>
+		T per_second( uint64_t previous, uint64_t current, double seconds ) {
+			if( current <= previous ) {
+				return 0;
+			}
+			auto const rate = static_cast<double>( current - previous ) / seconds;
+			if( rate >= static_cast<double>( std::numeric_limits<T>::max( ) ) ) {
+				return std::numeric_limits<T>::max( );
+			}
+			return static_cast<T>( rate + 0.5 );
+		}
+
+		template<typename Sample>
+		Sample sample_of( wmi_process const &row ) {
+			return Sample{row.cpu_time, row.read_transfer_count.value,
+			              row.write_transfer_count.value, row.page_faults.value};
+		}
+
+		template<typename Sample>
+		uint64_t counter_of( Sample const &sample,
+		                     wmi_process::column_number rate_column ) {
+			using column_number = wmi_process::column_number;
+			switch( rate_column ) {
+			case column_number::CpuUsage:
+				return sample.cpu_time;
+			case column_number::ReadRate:
+				return sample.read_transfer_count;
+			case column_number::WriteRate:
+				return sample.write_transfer_count;
+			case column_number::PageFaultRate:
+				return sample.page_faults;
+			default:
+				return 0;
+			}
+		}
+	} // namespace
+
+	void process_rates::update( std::vector<wmi_process> &rows,
+	                            clock::time_point now ) {
+		auto const seconds =
+		  std::chrono::duration<double>( now - m_sample_time ).count( );
+		auto const has_previous = !m_samples.empty( ) && seconds > 0.0;
+		auto samples = std::move( m_kept );
+		m_kept = {};
+		samples.reserve( samples.size( ) + rows.size( ) );
+		for( auto &row : rows ) {
+			auto const key = key_of( row );
+			auto const sample = sample_of<sample_t>( row );
+			samples.insert_or_assign( key, sample );
+
+			auto const previous =
+			  has_previous ? m_samples.find( key ) : m_samples.end( );
+			if( previous == m_samples.end( ) ) {
+				row.cpu_usage = 0;
+				row.read_rate = 0;
+				row.write_rate = 0;
+				row.page_fault_rate = 0;
+				continue;
+			}
+			auto const &prev = previous->second;
+			// cpu_time is in 100ns units, 1000 of them a second is 0.01% of a core
+			row.cpu_usage =
+			  per_second<uint32_t>( prev.cpu_time, sample.cpu_time, seconds * 1e3 );
+			row.read_rate = per_second<uint64_t>(
+			  prev.read_transfer_count, sample.read_transfer_count, seconds );
+			row.write_rate = per_second<uint64_t>(
+			  prev.write_transfer_count, sample.write_transfer_count, seconds );
+			row.page_fault_rate =
+			  per_second<uint32_t>( prev.page_faults, sample.page_faults, seconds );
+		}
+		m_samples = std::move( samples );
+		m_sample_time = now;
+	}
+
+	void process_rates::keep( wmi_process const &row ) {
+		m_kept.insert_or_assign( key_of( row ), sample_of<sample_t>( row ) );
+	}
+
+	uint64_t
+	process_rates::counter_change( wmi_process const &row,
+	                               wmi_process::column_number rate_column ) const {
+		auto const current = counter_of( sample_of<sample_t>( row ), rate_column );
+		auto const previous = m_samples.find( key_of( row ) );
+		if( previous == m_samples.end( ) ) {
+			return current;
+		}
+		auto const prev = counter_of( previous->second, rate_column );
+		return current > prev ? current - prev : 0;
+	}
+
+	void process_rates::clear( ) {
+		m_samples.clear( );
+		m_kept.clear( );
+		m_sample_time = clock::time_point{};
+	}
+} // namespace daw
@@ -0,0 +1,188 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "daw/process_events.h"
+#include "daw/process_source.h"
+#include "daw/wmi_projection.h"
+
+namespace daw {
+	process_source::~process_source( ) = default;
+
+	top_processes process_source::get_top_processes(
+	  std::wstring const &host, column_set columns,
+	  wmi_process::column_number sort_column, bool is_ascending, size_t count,
+	  process_rates *rates ) {
+		columns |= sort_key_columns( sort_column );
+		auto selector = top_selector( sort_column, is_ascending, count, rates );
+		for_each_process( host, columns, [&]( wmi_process const &row ) {
+			selector.offer( row );
+		} );
+		return std::move( selector ).take( );
+	}
+
+	counter_sample process_source::get_counters( std::wstring const &host,
+	                                             column_set columns ) {
+		return counter_sample{get_processes( host, columns ), std::nullopt};
+	}
+
+	std::unique_ptr<process_subscription>
+	process_source::subscribe_events( std::wstring const &, column_set,
+	                                  std::shared_ptr<process_event_queue> ) {
+		return nullptr;
+	}
+
+	namespace {
+		bool is_rate( wmi_process::column_number column ) {
+			using column_number = wmi_process::column_number;
+			return column == column_number::CpuUsage ||
+			       column == column_number::ReadRate ||
+			       column == column_number::WriteRate ||
+			       column == column_number::PageFaultRate;
+		}
+	} // namespace
+
+	column_set sort_key_columns( wmi_process::column_number sort_column ) {
+		using column_number = wmi_process::column_number;
+		if( is_rate( sort_column ) ) {
+			// The key is also the sample process_rates keeps
+			return with_rate_sources( make_column_set(
+			  {column_number::CpuUsage, column_number::ReadRate,
+			   column_number::WriteRate, column_number::PageFaultRate,
+			   column_number::ProcessId, column_number::CreationDate} ) );
+		}
+		return make_column_set( {sort_column, column_number::ProcessId} );
+	}
+
+	top_selector::top_selector( wmi_process::column_number sort_column,
+	                            bool is_ascending, size_t count,
+	                            process_rates *rates )
+	  : m_sort_column( sort_column )
+	  , m_is_ascending( is_ascending )
+	  , m_count( count )
+	  , m_rates( rates ) {
+
+		m_heap.reserve( count + 1 );
+	}
+
+	bool top_selector::is_rate_column( ) const noexcept {
+		return is_rate( m_sort_column );
+	}
+
+	uint64_t top_selector::rank_of( wmi_process const &row ) const {
+		using column_number = wmi_process::column_number;
+		if( m_rates ) {
+			return m_rates->counter_change( row, m_sort_column );
+		}
+		switch( m_sort_column ) {
+		case column_number::CpuUsage:
+			return row.cpu_time;
+		case column_number::ReadRate:
+			return row.read_transfer_count.value;
+		case column_number::WriteRate:
+			return row.write_transfer_count.value;
+		case column_number::PageFaultRate:
+			return row.page_faults.value;
+		default:
+			return 0;
+		}
+	}
+
+	bool top_selector::comes_first( uint64_t lhs_rank, wmi_process const &lhs,
+	                                uint64_t rhs_rank,
+	                                wmi_process const &rhs ) const {
+		auto result = 0;
+		if( is_rate_column( ) ) {
+			result = lhs_rank < rhs_rank ? -1 : ( rhs_rank < lhs_rank ? 1 : 0 );
+		} else {
+			auto const col = static_cast<size_t>( m_sort_column );
+			result = lhs[col].compare( rhs[col] );
+		}
+		if( result != 0 ) {
+			return m_is_ascending ? result < 0 : result > 0;
+		}
+		return lhs.process_id.value < rhs.process_id.value;
+	}
+
+	bool top_selector::comes_first( entry_t const &lhs, entry_t const &rhs ) const {
+		return comes_first( lhs.rank, lhs.row, rhs.rank, rhs.row );
+	}
+
+	bool top_selector::is_kept( wmi_process const &key ) {
+		++m_total;
+		m_rank = 0;
+		if( is_rate_column( ) ) {
+			m_rank = rank_of( key );
+			if( m_rates ) {
+				m_rates->keep( key );
+			}
+		}
+		if( m_count == 0 ) {
+			return false;
+		}
+		// A max heap on comes_first, its front is the first to drop out
+		return m_heap.size( ) < m_count ||
+		       comes_first( m_rank, key, m_heap.front( ).rank, m_heap.front( ).row );
+	}
+
+	void top_selector::keep( wmi_process &&row ) {
+		auto const cmp = [this]( entry_t const &lhs, entry_t const &rhs ) {
+			return comes_first( lhs, rhs );
+		};
+		if( m_heap.size( ) == m_count ) {
+			std::pop_heap( m_heap.begin( ), m_heap.end( ), cmp );
+			m_heap.pop_back( );
+		}
+		m_heap.push_back( entry_t{m_rank, std::move( row )} );
+		std::push_heap( m_heap.begin( ), m_heap.end( ), cmp );
+	}
+
+	top_processes top_selector::take( ) && {
+		std::sort_heap( m_heap.begin( ), m_heap.end( ),
+		                [this]( entry_t const &lhs, entry_t const &rhs ) {
+			                return comes_first( lhs, rhs );
+		                } );
+		auto result = top_processes{};
+		result.processes.reserve( m_heap.size( ) );
+		for( auto &entry : m_heap ) {
+			result.processes.push_back( std::move( entry.row ) );
+		}
+		result.total = m_total;
+		return result;
+	}
+
+	std::shared_ptr<process_source> const &default_process_source( ) {
+#ifdef _WIN32
+		static auto const source = make_wmi_refresher_process_source( );
+#else
+		static auto const source = make_proc_process_source( );
+#endif
+		return source;
+	}
+} // namespace daw
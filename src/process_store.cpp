@@ -0,0 +1,539 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <wx/datetime.h>
+#include <wx/string.h>
+
+#include "daw/column_items.h"
+#include "daw/parallel.h"
+#include "daw/process_store.h"
+
+namespace daw {
+	namespace {
+		using column_number = wmi_process::column_number;
+
+		constexpr int64_t invalid_date = std::numeric_limits<int64_t>::min( );
+
+		std::wstring_view to_view( wxString const &str ) {
+			return std::wstring_view( str.wc_str( ), str.length( ) );
+		}
+
+		int64_t to_ticks( wxDateTime const &value ) {
+			if( !value.IsValid( ) ) {
+				return invalid_date;
+			}
+			return value.GetValue( ).GetValue( );
+		}
+
+		template<column_number col>
+		auto raw_value( wmi_process const &row ) {
+			if constexpr( col == column_number::Name ) {
+				return to_view( row.name.value );
+			} else if constexpr( col == column_number::ProcessId ) {
+				return row.process_id.value;
+			} else if constexpr( col == column_number::ParentProcessId ) {
+				return row.parent_process_id.value;
+			} else if constexpr( col == column_number::SessionId ) {
+				return row.session_id.value;
+			} else if constexpr( col == column_number::Handle ) {
+				return to_view( row.handle.value );
+			} else if constexpr( col == column_number::CreationDate ) {
+				return to_ticks( row.creation_date.value );
+			} else if constexpr( col == column_number::ThreadCount ) {
+				return row.thread_count.value;
+			} else if constexpr( col == column_number::PageFaults ) {
+				return row.page_faults.value;
+			} else if constexpr( col == column_number::WorkingSetSize ) {
+				return row.working_set_size.value;
+			} else if constexpr( col == column_number::PeakWorkingSetSize ) {
+				return row.peak_working_set_size.value;
+			} else if constexpr( col == column_number::PageFileUsage ) {
+				return row.page_file_usage.value;
+			} else if constexpr( col == column_number::PeakPageFileUsage ) {
+				return row.peak_page_file_usage.value;
+			} else if constexpr( col == column_number::ReadTransferCount ) {
+				return row.read_transfer_count.value;
+			} else if constexpr( col == column_number::WriteTransferCount ) {
+				return row.write_transfer_count.value;
+			} else if constexpr( col == column_number::CpuUsage ) {
+				return row.cpu_usage.value;
+			} else if constexpr( col == column_number::ReadRate ) {
+				return row.read_rate.value;
+			} else if constexpr( col == column_number::WriteRate ) {
+				return row.write_rate.value;
+			} else if constexpr( col == column_number::PageFaultRate ) {
+				return row.page_fault_rate.value;
+			} else {
+				static_assert( col == column_number::CommandLine, "Unknown column" );
+				return to_view( row.command_line.value );
+			}
+		}
+
+		// The orders below are total, equal values are ordered on their row
+		// id.  Descending is then exactly ascending read backwards
+		template<column_number col>
+		struct column_less {
+			decltype( std::declval<process_store const &>( ).view<col>( ) ) values;
+
+			bool operator( )( process_store::row_id lhs,
+			                  process_store::row_id rhs ) const noexcept {
+				if( values[lhs] != values[rhs] ) {
+					return values[lhs] < values[rhs];
+				}
+				return lhs < rhs;
+			}
+		};
+
+		struct rank_less {
+			std::vector<uint32_t> const &ranks;
+			column_view<process_store::string_id> values;
+
+			bool operator( )( process_store::row_id lhs,
+			                  process_store::row_id rhs ) const noexcept {
+				auto const l = ranks[values[lhs]];
+				auto const r = ranks[values[rhs]];
+				if( l != r ) {
+					return l < r;
+				}
+				return lhs < rhs;
+			}
+		};
+
+		// Without precomputed ranks, for when only a few rows are compared or
+		// the strings rarely repeat
+		struct string_less {
+			process_store const &store;
+			column_view<process_store::string_id> values;
+
+			bool operator( )( process_store::row_id lhs,
+			                  process_store::row_id rhs ) const noexcept {
+				auto const result = store.compare_strings( values[lhs], values[rhs] );
+				if( result != 0 ) {
+					return result < 0;
+				}
+				return lhs < rhs;
+			}
+		};
+
+		template<column_number col>
+		auto make_less( process_store const &store ) {
+			if constexpr( process_store::column_kind<col>( ) ==
+			              process_store::column_kinds::String ) {
+				return string_less{store, store.view<col>( )};
+			} else {
+				return column_less<col>{store.view<col>( )};
+			}
+		}
+	} // namespace
+
+	process_store::row_id process_store::add( wmi_process const &row ) {
+		auto id = row_id{};
+		if( !free_rows.empty( ) ) {
+			id = free_rows.back( );
+			free_rows.pop_back( );
+		} else {
+			id = static_cast<row_id>( capacity( ) );
+			for( size_t n = 0; n < wmi_process::column_count; ++n ) {
+				visit_column( static_cast<column_number>( n ), [&]( auto col ) {
+					( this->*member<decltype( col )::value>( ) ).emplace_back( );
+				} );
+			}
+		}
+		for( size_t n = 0; n < wmi_process::column_count; ++n ) {
+			assign( id, static_cast<column_number>( n ), row );
+		}
+		rows_by_key.try_emplace( key( id ), id );
+		return id;
+	}
+
+	wmi_process process_store::to_process( row_id id ) const {
+		auto result = wmi_process{};
+		for( size_t n = 0; n < wmi_process::column_count; ++n ) {
+			visit_column( static_cast<column_number>( n ), [&]( auto c ) {
+				constexpr auto cn = decltype( c )::value;
+				auto const value = view<cn>( )[id];
+				auto &field = result.column<cn>( );
+				if constexpr( column_kind<cn>( ) == column_kinds::String ) {
+					field = strings[value];
+				} else if constexpr( column_kind<cn>( ) == column_kinds::Date ) {
+					if( value != invalid_date ) {
+						field.value = wxDateTime( wxLongLong( value ) );
+					}
+				} else {
+					field.value = value;
+				}
+			} );
+		}
+		return result;
+	}
+
+	void process_store::remove( row_id id ) {
+		unindex( id );
+		for( size_t n = 0; n < wmi_process::column_count; ++n ) {
+			visit_column( static_cast<column_number>( n ), [&]( auto col ) {
+				( this->*member<decltype( col )::value>( ) )[id] = {};
+			} );
+		}
+		free_rows.push_back( id );
+	}
+
+	void process_store::clear( ) {
+		for( size_t n = 0; n < wmi_process::column_count; ++n ) {
+			visit_column( static_cast<column_number>( n ), [&]( auto col ) {
+				( this->*member<decltype( col )::value>( ) ).clear( );
+			} );
+		}
+		free_rows.clear( );
+		rows_by_key.clear( );
+		strings = string_arena{};
+		string_keys.assign( 1, 0 );
+	}
+
+	process_store::string_id process_store::intern( std::wstring_view str ) {
+		auto const id = strings.intern( str );
+		if( id >= string_keys.size( ) ) {
+			// New strings always get the next id
+			string_keys.push_back( folded_sort_key( strings[id] ) );
+		}
+		return id;
+	}
+
+	void process_store::unindex( row_id id ) {
+		auto pos = rows_by_key.find( key( id ) );
+		if( pos != rows_by_key.end( ) && pos->second == id ) {
+			rows_by_key.erase( pos );
+		}
+	}
+
+	void process_store::assign( row_id id, column_number col,
+	                            wmi_process const &row ) {
+		if( ( col == column_number::ProcessId ||
+		      col == column_number::CreationDate ) &&
+		    !is_equal( id, col, row ) ) {
+			// The key changes, rows_by_key follows it
+			unindex( id );
+			if( col == column_number::ProcessId ) {
+				process_id[id] = raw_value<column_number::ProcessId>( row );
+			} else {
+				creation_date[id] = raw_value<column_number::CreationDate>( row );
+			}
+			rows_by_key.try_emplace( key( id ), id );
+			return;
+		}
+		visit_column( col, [&]( auto c ) {
+			constexpr auto cn = decltype( c )::value;
+			auto &values = this->*member<cn>( );
+			if constexpr( column_kind<cn>( ) == column_kinds::String ) {
+				values[id] = intern( raw_value<cn>( row ) );
+			} else {
+				values[id] = raw_value<cn>( row );
+			}
+		} );
+	}
+
+	bool process_store::is_equal( row_id id, column_number col,
+	                              wmi_process const &row ) const {
+		return visit_column( col, [&]( auto c ) {
+			constexpr auto cn = decltype( c )::value;
+			auto const &values = this->*member<cn>( );
+			if constexpr( column_kind<cn>( ) == column_kinds::String ) {
+				return strings[values[id]] == raw_value<cn>( row );
+			} else {
+				return values[id] == raw_value<cn>( row );
+			}
+		} );
+	}
+
+	std::wstring_view process_store::string_value( row_id id,
+	                                               column_number col ) const {
+		switch( col ) {
+		case column_number::Name:
+			return strings[name[id]];
+		case column_number::Handle:
+			return strings[handle[id]];
+		case column_number::CommandLine:
+			return strings[command_line[id]];
+		default:
+			return {};
+		}
+	}
+
+	int process_store::compare( column_number col, row_id lhs,
+	                            row_id rhs ) const {
+		return visit_column( col, [&]( auto c ) {
+			constexpr auto cn = decltype( c )::value;
+			auto const values = view<cn>( );
+			if constexpr( column_kind<cn>( ) == column_kinds::String ) {
+				return compare_strings( values[lhs], values[rhs] );
+			} else {
+				if( values[lhs] < values[rhs] ) {
+					return -1;
+				}
+				if( values[lhs] > values[rhs] ) {
+					return 1;
+				}
+				return 0;
+			}
+		} );
+	}
+
+	int compare_rows( process_store const &lhs_store, process_store::row_id lhs,
+	                  process_store const &rhs_store, process_store::row_id rhs,
+	                  process_store::column_number col ) {
+		return process_store::visit_column( col, [&]( auto c ) {
+			constexpr auto cn = decltype( c )::value;
+			auto const l = lhs_store.view<cn>( )[lhs];
+			auto const r = rhs_store.view<cn>( )[rhs];
+			if constexpr( process_store::column_kind<cn>( ) ==
+			              process_store::column_kinds::String ) {
+				// String ids are per store, the sort keys are not
+				auto const lkey = lhs_store.string_keys[l];
+				auto const rkey = rhs_store.string_keys[r];
+				if( lkey != rkey ) {
+					return lkey < rkey ? -1 : 1;
+				}
+				return compare_nocase( lhs_store.strings[l], rhs_store.strings[r] );
+			} else {
+				return l < r ? -1 : ( r < l ? 1 : 0 );
+			}
+		} );
+	}
+
+	wxString process_store::to_string( row_id id, column_number col ) const {
+		return visit_column( col, [&]( auto c ) -> wxString {
+			constexpr auto cn = decltype( c )::value;
+			auto const value = view<cn>( )[id];
+			if constexpr( column_kind<cn>( ) == column_kinds::String ) {
+				auto const str = strings[value];
+				return wxString( str.data( ), str.size( ) );
+			} else if constexpr( column_kind<cn>( ) == column_kinds::Memory ) {
+				return memory_value_to_wstring( value );
+			} else if constexpr( column_kind<cn>( ) == column_kinds::Percent ) {
+				auto buff = format_buffer{};
+				auto const str = format_percent( value, buff );
+				return wxString( str.data( ), str.size( ) );
+			} else if constexpr( column_kind<cn>( ) == column_kinds::Date ) {
+				if( value == invalid_date ) {
+					return wxString{};
+				}
+				return to_date_string( Date::date_formats::Combined,
+				                       wxDateTime( wxLongLong( value ) ) );
+			} else {
+				auto buff = format_buffer{};
+				auto const str = format_integer( value, buff );
+				return wxString( str.data( ), str.size( ) );
+			}
+		} );
+	}
+
+	void process_store::compact_strings( ) {
+		static constexpr auto npos = std::numeric_limits<string_id>::max( );
+		auto result = string_arena{};
+		auto keys = std::vector<uint64_t>( 1, string_keys[0] );
+		auto remap = std::vector<string_id>( strings.size( ), npos );
+		auto const move_column = [&]( std::vector<string_id> &values ) {
+			for( auto &value : values ) {
+				if( remap[value] == npos ) {
+					remap[value] = result.intern( strings[value] );
+					if( remap[value] >= keys.size( ) ) {
+						keys.push_back( string_keys[value] );
+					}
+				}
+				value = remap[value];
+			}
+		};
+		move_column( name );
+		move_column( command_line );
+		move_column( handle );
+		strings = std::move( result );
+		string_keys = std::move( keys );
+	}
+
+	std::vector<uint32_t> process_store::string_ranks( ) const {
+		auto ids = std::vector<string_id>( strings.size( ) );
+		std::iota( ids.begin( ), ids.end( ), string_id{0} );
+		return string_ranks( std::move( ids ) );
+	}
+
+	std::vector<uint32_t>
+	process_store::string_ranks( std::vector<string_id> ids ) const {
+		std::sort( ids.begin( ), ids.end( ), [&]( string_id lhs, string_id rhs ) {
+			return compare_strings( lhs, rhs ) < 0;
+		} );
+		auto ranks = std::vector<uint32_t>( strings.size( ) );
+		uint32_t rank = 0;
+		for( size_t n = 0; n < ids.size( ); ++n ) {
+			if( n > 0 && compare_strings( ids[n - 1], ids[n] ) != 0 ) {
+				++rank;
+			}
+			ranks[ids[n]] = rank;
+		}
+		return ranks;
+	}
+
+	void sort_rows( process_store const &store,
+	                std::vector<process_store::row_id> &rows,
+	                process_store::column_number col, bool is_ascending ) {
+		process_store::visit_column( col, [&]( auto c ) {
+			constexpr auto cn = decltype( c )::value;
+			if constexpr( process_store::column_kind<cn>( ) ==
+			              process_store::column_kinds::String ) {
+				auto const values = store.view<cn>( );
+				// Only the strings these rows use, each once
+				auto is_used = std::vector<bool>( store.strings.size( ), false );
+				auto ids = std::vector<process_store::string_id>( );
+				for( auto id : rows ) {
+					auto const value = values[id];
+					if( !is_used[value] ) {
+						is_used[value] = true;
+						ids.push_back( value );
+					}
+				}
+				if( ids.size( ) * 2 > rows.size( ) ) {
+					// Mostly distinct, e.g. command lines.  Ranking them would sort
+					// the same strings twice
+					parallel_stable_sort( rows.begin( ), rows.end( ),
+					                      string_less{store, values} );
+				} else {
+					auto const ranks = store.string_ranks( std::move( ids ) );
+					parallel_stable_sort( rows.begin( ), rows.end( ),
+					                      rank_less{ranks, values} );
+				}
+			} else {
+				parallel_stable_sort( rows.begin( ), rows.end( ),
+				                      column_less<cn>{store.view<cn>( )} );
+			}
+		} );
+		if( !is_ascending ) {
+			std::reverse( rows.begin( ), rows.end( ) );
+		}
+	}
+
+	std::vector<process_store::row_id>
+	resort_rows( process_store const &store,
+	             std::vector<process_store::row_id> const &previous,
+	             std::vector<process_store::row_id> const &rows,
+	             process_store::column_number col ) {
+		using row_id = process_store::row_id;
+		auto result = std::vector<row_id>( );
+		process_store::visit_column( col, [&]( auto c ) {
+			auto const less = make_less<decltype( c )::value>( store );
+			// Rows that are still there and not yet taken from previous
+			auto is_pending = std::vector<bool>( store.capacity( ), false );
+			for( auto id : rows ) {
+				is_pending[id] = true;
+			}
+			auto kept = std::vector<row_id>( );
+			kept.reserve( rows.size( ) );
+			auto moved = std::vector<row_id>( );
+			for( auto id : previous ) {
+				if( id >= is_pending.size( ) || !is_pending[id] ) {
+					continue;
+				}
+				is_pending[id] = false;
+				if( kept.empty( ) || !less( id, kept.back( ) ) ) {
+					kept.push_back( id );
+				} else if( kept.size( ) < 2 || !less( id, kept[kept.size( ) - 2] ) ) {
+					// The last one kept is the one out of place, it grew
+					moved.push_back( kept.back( ) );
+					kept.back( ) = id;
+				} else {
+					moved.push_back( id );
+				}
+			}
+			for( auto id : rows ) {
+				if( is_pending[id] ) {
+					// New since previous was sorted
+					moved.push_back( id );
+				}
+			}
+			std::sort( moved.begin( ), moved.end( ), less );
+			result.resize( kept.size( ) + moved.size( ) );
+			std::merge( kept.begin( ), kept.end( ), moved.begin( ), moved.end( ),
+			            result.begin( ), less );
+		} );
+		return result;
+	}
+
+	sort_snapshot make_sort_snapshot( process_store const &store,
+	                                  std::vector<process_store::row_id> const &rows,
+	                                  process_store::column_number col,
+	                                  bool is_ascending ) {
+		auto result = sort_snapshot{};
+		result.is_ascending = is_ascending;
+		result.entries.reserve( rows.size( ) );
+		process_store::visit_column( col, [&]( auto c ) {
+			constexpr auto cn = decltype( c )::value;
+			auto const values = store.view<cn>( );
+			for( auto id : rows ) {
+				auto const value = values[id];
+				if constexpr( process_store::column_kind<cn>( ) ==
+				              process_store::column_kinds::String ) {
+					result.entries.push_back(
+					  {store.string_keys[value], store.strings[value], id} );
+				} else if constexpr( std::is_signed_v<decltype( value )> ) {
+					// Flip the sign bit so that unsigned order is signed order
+					result.entries.push_back(
+					  {static_cast<uint64_t>( value ) ^ ( uint64_t{1} << 63U ), {}, id} );
+				} else {
+					result.entries.push_back( {static_cast<uint64_t>( value ), {}, id} );
+				}
+			}
+		} );
+		return result;
+	}
+
+	std::vector<process_store::row_id> sort_snapshot::sort( size_t thread_count ) {
+		auto const less = []( entry_t const &lhs, entry_t const &rhs ) {
+			if( lhs.key != rhs.key ) {
+				return lhs.key < rhs.key;
+			}
+			auto const result = compare_nocase( lhs.text, rhs.text );
+			if( result != 0 ) {
+				return result < 0;
+			}
+			return lhs.id < rhs.id;
+		};
+		parallel_stable_sort( entries.begin( ), entries.end( ), less, thread_count );
+		if( !is_ascending ) {
+			std::reverse( entries.begin( ), entries.end( ) );
+		}
+		auto result = std::vector<process_store::row_id>( );
+		result.reserve( entries.size( ) );
+		for( auto const &e : entries ) {
+			result.push_back( e.id );
+		}
+		return result;
+	}
+
+	row_key key_of( wmi_process const &row ) {
+		return {row.process_id.value, to_ticks( row.creation_date.value )};
+	}
+} // namespace daw
@@ -0,0 +1,253 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include "daw/refresh_scheduler.h"
+
+namespace daw {
+	refresh_scheduler::refresh_scheduler( refresh_scheduler_options opts )
+	  : m_opts( std::move( opts ) )
+	  , m_rng( std::random_device{}( ) ) {
+
+		auto const count = std::max( m_opts.worker_count, size_t{1} );
+		m_workers.reserve( count );
+		for( size_t n = 0; n < count; ++n ) {
+			m_workers.emplace_back( [this]( ) { run_worker( ); } );
+		}
+	}
+
+	refresh_scheduler::~refresh_scheduler( ) {
+		{
+			std::lock_guard<std::mutex> lck( m_mutex );
+			m_is_stopping = true;
+		}
+		m_wake.notify_all( );
+		for( auto &worker : m_workers ) {
+			worker.join( );
+		}
+	}
+
+	refresh_scheduler::clock_t::duration
+	refresh_scheduler::next_interval( bool is_visible ) {
+		auto const interval =
+		  is_visible ? m_opts.visible_interval : m_opts.hidden_interval;
+		auto const jitter = std::clamp( m_opts.jitter, 0.0, 1.0 );
+		auto dist = std::uniform_real_distribution<double>( 1.0 - jitter, 1.0 + jitter );
+		return std::chrono::duration_cast<clock_t::duration>(
+		  interval * dist( m_rng ) );
+	}
+
+	refresh_scheduler::clock_t::duration
+	refresh_scheduler::backoff_interval( host_t const &host ) {
+		auto const max_factor = std::max( m_opts.max_backoff, uint32_t{1} );
+		auto factor = uint32_t{1};
+		for( uint32_t n = 0; n < host.missed_in_row && factor < max_factor; ++n ) {
+			factor *= 2;
+		}
+		return next_interval( host.is_visible ) * std::min( factor, max_factor );
+	}
+
+	void refresh_scheduler::request_refresh( host_t &host ) {
+		if( host.missed_in_row > 0 ) {
+			// Asking again does not make an overdue host any faster
+			return;
+		}
+		if( host.is_running ) {
+			host.is_requested = true;
+		} else {
+			host.due = std::min( host.due, clock_t::now( ) );
+		}
+	}
+
+	refresh_scheduler::host_t *
+	refresh_scheduler::next_due( clock_t::time_point now, host_id &id ) {
+		host_t *result = nullptr;
+		for( auto &[key, host] : m_hosts ) {
+			if( host.is_running || host.is_removed || host.due > now ) {
+				continue;
+			}
+			if( !result || ( host.is_visible && !result->is_visible ) ||
+			    ( host.is_visible == result->is_visible && host.due < result->due ) ) {
+				result = &host;
+				id = key;
+			}
+		}
+		return result;
+	}
+
+	void refresh_scheduler::run_worker( ) {
+		std::unique_lock<std::mutex> lck( m_mutex );
+		while( !m_is_stopping ) {
+			auto const now = clock_t::now( );
+			host_id id = 0;
+			auto host = next_due( now, id );
+			if( !host ) {
+				// Sleep until the next refresh is due, or something changes
+				auto wake_at = clock_t::time_point::max( );
+				for( auto const &item : m_hosts ) {
+					if( !item.second.is_running && !item.second.is_removed ) {
+						wake_at = std::min( wake_at, item.second.due );
+					}
+				}
+				if( wake_at == clock_t::time_point::max( ) ) {
+					m_wake.wait( lck );
+				} else {
+					m_wake.wait_until( lck, wake_at );
+				}
+				continue;
+			}
+			host->is_running = true;
+			auto const due = host->due;
+			auto const wait = now - due;
+			host->stats.total_wait += wait;
+			host->stats.max_wait = std::max( host->stats.max_wait, wait );
+			// Copies, add_host/remove_host may rehash m_hosts while unlocked
+			auto refresh = host->refresh;
+			auto on_done = host->on_done;
+
+			lck.unlock( );
+			auto error = std::exception_ptr( );
+			try {
+				refresh( );
+			} catch( ... ) { error = std::current_exception( ); }
+			auto const finished = clock_t::now( );
+			if( on_done ) {
+				try {
+					on_done( error );
+				} catch( ... ) {}
+			}
+			lck.lock( );
+
+			auto pos = m_hosts.find( id );
+			if( pos == m_hosts.end( ) ) {
+				continue;
+			}
+			auto &h = pos->second;
+			h.is_running = false;
+			h.stats.last_duration = finished - now;
+			++h.stats.refresh_count;
+			if( error ) {
+				++h.stats.error_count;
+			}
+			// Measured from the start of the refresh, waiting for a free worker
+			// is the pool's doing and not the host's
+			if( finished - now > m_opts.deadline ) {
+				++h.stats.missed_deadlines;
+				++h.missed_in_row;
+			} else {
+				h.missed_in_row = 0;
+			}
+			// Counted from the end of this refresh, a slow host does not pile up
+			// refreshes it cannot keep up with
+			if( h.missed_in_row > 0 ) {
+				h.due = finished + backoff_interval( h );
+			} else if( h.is_requested ) {
+				h.due = finished;
+			} else {
+				h.due = finished + next_interval( h.is_visible );
+			}
+			h.is_requested = false;
+			if( h.is_removed ) {
+				m_hosts.erase( pos );
+			}
+			m_finished.notify_all( );
+		}
+	}
+
+	refresh_scheduler::host_id
+	refresh_scheduler::add_host( refresh_function refresh, done_function on_done,
+	                             bool is_visible ) {
+		host_id id = 0;
+		{
+			std::lock_guard<std::mutex> lck( m_mutex );
+			id = m_next_id++;
+			auto &host = m_hosts[id];
+			host.refresh = std::move( refresh );
+			host.on_done = std::move( on_done );
+			host.is_visible = is_visible;
+			host.due = clock_t::now( );
+		}
+		m_wake.notify_one( );
+		return id;
+	}
+
+	void refresh_scheduler::remove_host( host_id id ) {
+		std::unique_lock<std::mutex> lck( m_mutex );
+		auto pos = m_hosts.find( id );
+		if( pos == m_hosts.end( ) ) {
+			return;
+		}
+		if( !pos->second.is_running ) {
+			m_hosts.erase( pos );
+			return;
+		}
+		pos->second.is_removed = true;
+		m_finished.wait( lck, [&]( ) { return m_hosts.count( id ) == 0; } );
+	}
+
+	void refresh_scheduler::set_visible( host_id id, bool is_visible ) {
+		{
+			std::lock_guard<std::mutex> lck( m_mutex );
+			auto pos = m_hosts.find( id );
+			if( pos == m_hosts.end( ) || pos->second.is_visible == is_visible ) {
+				return;
+			}
+			pos->second.is_visible = is_visible;
+			if( is_visible ) {
+				request_refresh( pos->second );
+			}
+		}
+		m_wake.notify_one( );
+	}
+
+	void refresh_scheduler::refresh_now( host_id id ) {
+		{
+			std::lock_guard<std::mutex> lck( m_mutex );
+			auto pos = m_hosts.find( id );
+			if( pos == m_hosts.end( ) ) {
+				return;
+			}
+			request_refresh( pos->second );
+		}
+		m_wake.notify_one( );
+	}
+
+	refresh_scheduler::host_stats refresh_scheduler::stats( host_id id ) const {
+		std::lock_guard<std::mutex> lck( m_mutex );
+		auto pos = m_hosts.find( id );
+		if( pos == m_hosts.end( ) ) {
+			return {};
+		}
+		return pos->second.stats;
+	}
+
+	size_t refresh_scheduler::host_count( ) const {
+		std::lock_guard<std::mutex> lck( m_mutex );
+		return m_hosts.size( );
+	}
+} // namespace daw
@@ -21,6 +21,10 @@
 // SOFTWARE.
 //
 
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
 #include <wx/app.h>
 #include <wx/cmdline.h>
 #include <wx/wx.h>
@@ -29,18 +33,48 @@
 
 #include "daw/remote_task_management.h"
 #include "daw/remote_task_management_frame.h"
+#ifdef _WIN32
+#include "daw/wmi_impl.h"
+#endif
 
 namespace daw {
 	bool remote_task_management_app::OnInit( ) {
 		if( !wxApp::OnInit( ) ) {
 			return false;
 		}
+		if( m_is_headless ) {
+			// OnRun does the work
+			return true;
+		}
 		auto frame = new remote_task_management_frame( m_remote_hosts,
 		                                               L"Remote Task Management" );
 		frame->Show( true );
 		return true;
 	}
 
+	int remote_task_management_app::OnRun( ) {
+		if( !m_is_headless ) {
+			return wxApp::OnRun( );
+		}
+		auto hosts = std::vector<std::wstring>( );
+		for( auto const &host : m_remote_hosts ) {
+			hosts.push_back( host.ToStdWstring( ) );
+		}
+		if( hosts.empty( ) ) {
+			hosts.emplace_back( L"." );
+		}
+		auto const failures =
+		  export_processes( hosts, m_export_options, std::cout, std::cerr );
+		return failures == 0 ? 0 : 1;
+	}
+
+	int remote_task_management_app::OnExit( ) {
+#ifdef _WIN32
+		close_wmi_connections( );
+#endif
+		return wxApp::OnExit( );
+	}
+
 	void remote_task_management_app::OnInitCmdLine( wxCmdLineParser &parser ) {
 		using T = wxCmdLineEntryDesc;
 		static auto const cmd_line_desc = daw::make_array<T>(
@@ -48,6 +82,22 @@ namespace daw {
 		    "displays help on the command line parameters\n", wxCMD_LINE_VAL_NONE,
 		    wxCMD_LINE_OPTION_HELP},
 
+		  T{wxCMD_LINE_SWITCH, nullptr, "headless",
+		    "write the process tables to stdout instead of showing them\n",
+		    wxCMD_LINE_VAL_NONE, 0},
+
+		  T{wxCMD_LINE_OPTION, nullptr, "format",
+		    "headless output, csv (default) or ndjson\n", wxCMD_LINE_VAL_STRING,
+		    0},
+
+		  T{wxCMD_LINE_OPTION, nullptr, "interval",
+		    "headless, collect again every this many seconds\n",
+		    wxCMD_LINE_VAL_NUMBER, 0},
+
+		  T{wxCMD_LINE_OPTION, nullptr, "concurrency",
+		    "headless, hosts queried at the same time (default 16)\n",
+		    wxCMD_LINE_VAL_NUMBER, 0},
+
 		  T{wxCMD_LINE_PARAM, nullptr, nullptr,
 		    "host(s) (. can be used for local machine)\n", wxCMD_LINE_VAL_STRING,
 		    wxCMD_LINE_PARAM_OPTIONAL | wxCMD_LINE_PARAM_MULTIPLE},
@@ -63,6 +113,25 @@ namespace daw {
 		for( size_t n = 0; n < parser.GetParamCount( ); ++n ) {
 			m_remote_hosts.push_back( parser.GetParam( n ) );
 		}
+		m_is_headless = parser.Found( "headless" );
+		wxString format;
+		if( parser.Found( "format", &format ) ) {
+			if( format.CmpNoCase( "csv" ) == 0 ) {
+				m_export_options.format = export_formats::Csv;
+			} else if( format.CmpNoCase( "ndjson" ) == 0 ) {
+				m_export_options.format = export_formats::Ndjson;
+			} else {
+				parser.Usage( );
+				return false;
+			}
+		}
+		long value = 0;
+		if( parser.Found( "interval", &value ) && value > 0 ) {
+			m_export_options.interval = std::chrono::seconds( value );
+		}
+		if( parser.Found( "concurrency", &value ) && value > 0 ) {
+			m_export_options.concurrency = static_cast<size_t>( value );
+		}
 		return true;
 	}
 } // namespace daw
@@ -20,63 +20,53 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 //
-#include <future>
+#include <algorithm>
+#include <chrono>
+#include <exception>
 #include <memory>
 #include <vector>
+#include <wx/filedlg.h>
+#include <wx/filename.h>
 #include <wx/menu.h>
 #include <wx/string.h>
 #include <wx/wx.h>
 
+#include "daw/column_items.h"
+#include "daw/fleet_table.h"
+#include "daw/process_source.h"
 #include "daw/remote_task_management_frame.h"
+#include "daw/snapshot_file.h"
+#include "daw/sparkline_renderer.h"
 #include "daw/wmi_process.h"
 #include "daw/wmi_process_table.h"
+#include "daw/wmi_projection.h"
 
 namespace daw {
 	namespace remote_task_management_frame_event_ids {
-		enum event_ids { id_open_remote = 1, id_close_by_pid, id_close_by_name };
+		enum event_ids {
+			id_open_remote = 1,
+			id_close_by_pid,
+			id_close_by_name,
+			id_show_fleet,
+			id_top_only,
+			id_open_recording,
+			id_record,
+			// One id per column, id_toggle_column + column_number
+			id_toggle_column = wxID_HIGHEST + 1
+		};
 	}
 
 	namespace {
-		template<typename R>
-		bool is_ready( std::future<R> const &f ) noexcept {
-			try {
-				return f.wait_for( std::chrono::seconds( 0 ) ) ==
-				       std::future_status::ready;
-			} catch( ... ) {
-				// Return true so that we stop waiting and any exceptions would be
-				// propegated
-				return true;
-			}
-		}
+		// Rows per host in top only mode
+		constexpr size_t top_row_limit = 50;
 
-		auto grid_update_timer( wxTimer *tmr, wmi_process_table *tbl,
-		                        wxGrid *dg ) noexcept {
-			return [tmr, tbl, dg, has_data = std::shared_ptr<std::future<void>>( )](
-			         wxTimerEvent & ) mutable {
-				if( !has_data ) {
-					// Timer has expired and we haven't tried to reteive any data yet
-					has_data = std::make_shared<std::future<void>>(
-					  std::async( [tbl = tbl]( ) { tbl->update_data( ); } ) );
-					tmr->StartOnce( 500 );
-				} else if( !is_ready( *has_data ) ) {
-					// We have requested data but it has not shown up yet
-					tmr->StartOnce( 250 );
-				} else {
-					// We have data, process it
-					try {
-						// Force any exceptions to throw by running get( ) on future
-						has_data->get( );
-						dg->ForceRefresh( );
-						tmr->StartOnce( 1700 );
-					} catch( ... ) {
-						// TODO put error message
-						dg->SetTable( nullptr );
-						tmr->Stop( );
-					}
-					has_data.reset( );
-				}
-			};
+		void set_sparkline( wxGrid *grid, wmi_process::column_number col,
+		                    process_history::series_kinds kind ) {
+			auto attr = new wxGridCellAttr( );
+			attr->SetRenderer( new sparkline_renderer( kind ) );
+			grid->SetColAttr( static_cast<int>( col ), attr );
 		}
+
 		uint32_t to_uint32( wxString const &str ) {
 			unsigned long result = 0xDEADBEEF;
 			(void)str.ToULong( &result );
@@ -87,81 +77,367 @@ namespace daw {
 	void remote_task_management_frame::add_page( wxString const &host ) {
 		try {
 			auto tbl = new wmi_process_table( host );
-			if( tbl ) {
-				tbl->sort_column( wmi_process::column_number::CreationDate );
-
-				auto dg = new wxGrid( m_notebook, wxID_ANY );
-				if( !dg ) {
-					throw std::runtime_error( "Could not create data grid" );
-				}
-				dg->SetTable( tbl, true );
-				dg->HideRowLabels( );
-				dg->EnableEditing( false );
-				dg->AutoSizeColumns( );
-				dg->Bind( wxEVT_GRID_COL_SORT, [tbl]( wxGridEvent &event ) {
-					tbl->sort_column( event.GetCol( ) );
-				} );
-
-				struct popup_data_t {
-					uint32_t pid;
-					wxString name;
-				};
-				dg->Bind( wxEVT_GRID_CELL_RIGHT_CLICK, [tbl, dg]( wxGridEvent &event ) {
-					constexpr auto const pid_col =
-					  static_cast<int>( wmi_process::column_number::ProcessId );
-					constexpr auto const name_col =
-					  static_cast<int>( wmi_process::column_number::Name );
-
-					auto const pid = tbl->GetValue( event.GetRow( ), pid_col );
-					auto const name = tbl->GetValue( event.GetRow( ), name_col );
-
-					auto const data =
-					  static_cast<void *>( new popup_data_t{to_uint32( pid ), name} );
-
-					auto menu = new wxMenu( );
-					menu->SetClientData( data );
-					auto mnu1 = menu->Append(
-					  remote_task_management_frame_event_ids::id_close_by_pid,
-					  L"Close pid " + pid );
-					mnu1->SetId( 0 );
-					auto mnu2 = menu->Append(
-					  remote_task_management_frame_event_ids::id_close_by_name,
-					  L"Close all " + name );
-					mnu2->SetId( 1 );
-
-					dg->PopupMenu( menu, event.GetPosition( ) );
-				} );
-
-				dg->Bind(
-				  wxEVT_COMMAND_MENU_SELECTED,
-				  [host]( wxCommandEvent const &event ) {
-					  auto const source_menu =
-					    dynamic_cast<wxMenu *>( event.GetEventObject( ) );
-					  auto const data = std::unique_ptr<popup_data_t>(
-					    static_cast<popup_data_t *>( source_menu->GetClientData( ) ) );
-					  wxString const msg = L"Right click from " +
-					                       std::to_wstring( data->pid ) + L' ' +
-					                       data->name;
-					  terminate_process_by_pid( host.ToStdWstring( ), data->pid );
-				  },
-				  remote_task_management_frame_event_ids::id_close_by_pid );
-
-				auto tmr = new wxTimer( this );
-				this->Bind( wxEVT_TIMER, grid_update_timer( tmr, tbl, dg ),
-				            tmr->GetId( ) );
-				tmr->StartOnce( 2500 );
-				if( host == L"." ) {
-					m_notebook->AddPage( dg, L"local machine", true );
-				} else {
-					m_notebook->AddPage( dg, host, true );
-				}
-			}
+			tbl->sort_column( wmi_process::column_number::CreationDate );
+			tbl->set_row_limit( m_row_limit );
+			// Subscribed by the first refresh, on a scheduler worker
+			tbl->subscribe_events( );
+			add_table_page( tbl, host == L"." ? wxString( L"local machine" ) : host );
 		} catch( ... ) {
 			wxMessageBox( L"Error connecting to " + host, L"Connection error" );
 		}
 	}
 
+	void remote_task_management_frame::add_recording_page( wxString const &path ) {
+		try {
+			auto reader = std::make_shared<snapshot_file::reader>( path.ToStdString( ) );
+			auto replay = std::make_shared<replay_source>( std::move( reader ) );
+			auto tbl = new wmi_process_table( path, [replay]( ) { return ( *replay )( ); } );
+			tbl->sort_column( wmi_process::column_number::CreationDate );
+			add_table_page( tbl, wxFileName( path ).GetFullName( ) );
+		} catch( std::exception const &ex ) {
+			wxMessageBox( L"Error opening " + path + L": " + wxString( ex.what( ) ),
+			              L"Recording error" );
+		}
+	}
+
+	void remote_task_management_frame::add_table_page( wmi_process_table *tbl,
+	                                                   wxString const &title ) {
+		auto dg = new wxGrid( m_notebook, wxID_ANY );
+		if( !dg ) {
+			throw std::runtime_error( "Could not create data grid" );
+		}
+		dg->SetTable( tbl, true );
+		dg->HideRowLabels( );
+		dg->EnableEditing( false );
+		dg->AutoSizeColumns( );
+		set_sparkline( dg, wmi_process::column_number::WorkingSetSize,
+		               process_history::series_kinds::WorkingSet );
+		set_sparkline( dg, wmi_process::column_number::ReadRate,
+		               process_history::series_kinds::ReadRate );
+		set_sparkline( dg, wmi_process::column_number::WriteRate,
+		               process_history::series_kinds::WriteRate );
+		dg->Bind( wxEVT_GRID_COL_SORT, [this, tbl, dg]( wxGridEvent &event ) {
+			tbl->sort_column( event.GetCol( ) );
+			auto page = find_page( dg );
+			if( page && tbl->row_limit( ) > 0 ) {
+				// The top rows of the new order are on the host, not in the table
+				m_scheduler->refresh_now( page->host_id );
+			}
+		} );
+
+		dg->Bind( wxEVT_GRID_LABEL_RIGHT_CLICK, [tbl, dg]( wxGridEvent &event ) {
+			if( event.GetRow( ) != -1 ) {
+				event.Skip( );
+				return;
+			}
+			// Column header, choose which columns are shown and fetched
+			using remote_task_management_frame_event_ids::id_toggle_column;
+			auto const required = required_columns( );
+			wxMenu menu;
+			for( size_t n = 0; n < wmi_process::column_names.size( ); ++n ) {
+				auto item = menu.AppendCheckItem(
+				  id_toggle_column + static_cast<int>( n ),
+				  wmi_process::column_names[n] );
+				item->Check( tbl->is_column_visible( static_cast<int>( n ) ) );
+				item->Enable( !required[n] );
+			}
+			auto const id =
+			  dg->GetPopupMenuSelectionFromUser( menu, event.GetPosition( ) );
+			if( id == wxID_NONE ) {
+				return;
+			}
+			auto const col = id - id_toggle_column;
+			auto const is_visible = !tbl->is_column_visible( col );
+			tbl->set_column_visible( col, is_visible );
+			if( is_visible ) {
+				dg->ShowCol( col );
+			} else {
+				dg->HideCol( col );
+			}
+		} );
+
+		struct popup_data_t {
+			uint32_t pid;
+			wxString name;
+		};
+		dg->Bind( wxEVT_GRID_CELL_RIGHT_CLICK, [tbl, dg]( wxGridEvent &event ) {
+			constexpr auto const pid_col =
+			  static_cast<int>( wmi_process::column_number::ProcessId );
+			constexpr auto const name_col =
+			  static_cast<int>( wmi_process::column_number::Name );
+
+			auto const pid = tbl->GetValue( event.GetRow( ), pid_col );
+			auto const name = tbl->GetValue( event.GetRow( ), name_col );
+
+			auto const data =
+			  static_cast<void *>( new popup_data_t{to_uint32( pid ), name} );
+
+			auto menu = new wxMenu( );
+			menu->SetClientData( data );
+			auto mnu1 = menu->Append(
+			  remote_task_management_frame_event_ids::id_close_by_pid,
+			  L"Close pid " + pid );
+			mnu1->SetId( 0 );
+			auto mnu2 = menu->Append(
+			  remote_task_management_frame_event_ids::id_close_by_name,
+			  L"Close all " + name );
+			mnu2->SetId( 1 );
+
+			dg->PopupMenu( menu, event.GetPosition( ) );
+		} );
+
+		dg->Bind(
+		  wxEVT_COMMAND_MENU_SELECTED,
+		  [host = tbl->host( ),
+		   processes = tbl->processes( )]( wxCommandEvent const &event ) {
+			  auto const source_menu =
+			    dynamic_cast<wxMenu *>( event.GetEventObject( ) );
+			  auto const data = std::unique_ptr<popup_data_t>(
+			    static_cast<popup_data_t *>( source_menu->GetClientData( ) ) );
+			  wxString const msg = L"Right click from " +
+			                       std::to_wstring( data->pid ) + L' ' +
+			                       data->name;
+			  try {
+				  processes->terminate_process( host.ToStdWstring( ), data->pid );
+			  } catch( ... ) {
+				  wxMessageBox( L"Error closing pid " +
+				                  std::to_wstring( data->pid ),
+				                L"Close process error" );
+			  }
+		  },
+		  remote_task_management_frame_event_ids::id_close_by_pid );
+
+		// The first load shows its rows as they arrive
+		tbl->set_stream_callback( [this, dg]( ) {
+			dg->CallAfter( [this, dg]( ) { on_streamed( dg ); } );
+		} );
+		// The refresh runs on a scheduler worker, the result is merged on
+		// the UI thread
+		auto const host_id = m_scheduler->add_host(
+		  [tbl]( ) { tbl->update_data( ); },
+		  [this, dg]( std::exception_ptr error ) {
+			  dg->CallAfter( [this, dg, error]( ) { on_refreshed( dg, error ); } );
+		  } );
+		m_pages.push_back( page_t{dg, tbl, host_id, wxString( )} );
+		if( m_fleet ) {
+			m_fleet->add_host( tbl );
+		}
+		m_notebook->AddPage( dg, title, true );
+	}
+
+	remote_task_management_frame::page_t *
+	remote_task_management_frame::find_page( wxWindow const *grid ) {
+		auto pos = std::find_if(
+		  m_pages.begin( ), m_pages.end( ),
+		  [grid]( page_t const &page ) { return page.grid == grid; } );
+		if( pos == m_pages.end( ) ) {
+			return nullptr;
+		}
+		return &*pos;
+	}
+
+	void remote_task_management_frame::on_refreshed( wxGrid *grid,
+	                                                 std::exception_ptr error ) {
+		auto page = find_page( grid );
+		if( !page ) {
+			return;
+		}
+		auto message = wxString( );
+		try {
+			if( error ) {
+				std::rethrow_exception( error );
+			}
+			auto const was_empty = page->table->rows( ).empty( );
+			page->table->apply_update( );
+			if( was_empty && !page->table->rows( ).empty( ) ) {
+				// Not streamed, e.g. when only the top processes are shown
+				grid->AutoSizeColumns( false );
+			}
+			if( m_fleet ) {
+				m_fleet->host_updated( page->table );
+			}
+			page->error.clear( );
+			update_status( );
+			return;
+		} catch( std::exception const &ex ) {
+			message = wxString( ex.what( ) );
+		} catch( ... ) {
+			message = L"Unknown error";
+		}
+		if( page->table->rows( ).empty( ) ) {
+			// The table no longer connects when it is created, a failed first
+			// load is a failed connection
+			auto const host = page->table->host( );
+			close_page( *page );
+			wxMessageBox( L"Error connecting to " + host + L": " + message,
+			              L"Connection error" );
+			return;
+		}
+		// The rows already shown stay, the scheduler retries on its next pass
+		page->error = message;
+		update_status( );
+	}
+
+	void remote_task_management_frame::close_page( page_t const &page ) {
+		auto const grid = page.grid;
+		if( m_fleet ) {
+			m_fleet->remove_host( page.table );
+		}
+		// Waits for a running refresh, nothing calls back into the grid after
+		m_scheduler->remove_host( page.host_id );
+		m_pages.erase( m_pages.begin( ) + ( &page - m_pages.data( ) ) );
+		// The grid owns the table and the handlers that use it. It can be
+		// running one of them now, so it is deleted once that has returned
+		CallAfter( [this, grid]( ) {
+			auto const pos = m_notebook->FindPage( grid );
+			if( pos != wxNOT_FOUND ) {
+				m_notebook->DeletePage( static_cast<size_t>( pos ) );
+			}
+		} );
+	}
+
+	void remote_task_management_frame::on_streamed( wxGrid *grid ) {
+		auto page = find_page( grid );
+		if( !page ) {
+			return;
+		}
+		auto const was_empty = page->table->rows( ).empty( );
+		if( page->table->apply_stream( ) == 0 ) {
+			return;
+		}
+		if( was_empty ) {
+			// Sized on the first rows, there was nothing to size on before
+			grid->AutoSizeColumns( false );
+		}
+		update_status( );
+	}
+
+	void remote_task_management_frame::on_page_changed( ) {
+		auto const current = m_notebook->GetCurrentPage( );
+		// The fleet page shows every host
+		auto const is_fleet = m_fleet_grid && current == m_fleet_grid;
+		for( auto const &page : m_pages ) {
+			m_scheduler->set_visible( page.host_id, is_fleet || page.grid == current );
+		}
+		auto const page = find_page( current );
+		GetMenuBar( )->Check( remote_task_management_frame_event_ids::id_record,
+		                      page && page->table->is_recording( ) );
+		update_status( );
+	}
+
+	void remote_task_management_frame::apply_events( ) {
+		auto const current = m_notebook->GetCurrentPage( );
+		auto const is_fleet = m_fleet_grid && current == m_fleet_grid;
+		for( auto const &page : m_pages ) {
+			if( !is_fleet && page.grid != current ) {
+				continue;
+			}
+			if( page.table->apply_events( ) > 0 && m_fleet ) {
+				m_fleet->host_updated( page.table );
+			}
+		}
+		update_status( );
+	}
+
+	void remote_task_management_frame::set_row_limit( size_t count ) {
+		m_row_limit = count;
+		if( m_fleet ) {
+			m_fleet->set_row_limit( count );
+		}
+		for( auto const &page : m_pages ) {
+			page.table->set_row_limit( count );
+			m_scheduler->refresh_now( page.host_id );
+		}
+	}
+
+	void remote_task_management_frame::update_status( ) {
+		if( !GetStatusBar( ) ) {
+			return;
+		}
+		auto const current = m_notebook->GetCurrentPage( );
+		size_t shown = 0;
+		size_t total = 0;
+		auto history = process_history::stats_t{};
+		for( auto const &page : m_pages ) {
+			if( current == m_fleet_grid || page.grid == current ) {
+				shown += page.table->rows( ).size( );
+				total += page.table->total_rows( );
+				auto const stats = page.table->history_stats( );
+				history.process_count += stats.process_count;
+				history.sample_count += stats.sample_count;
+				history.memory_used += stats.memory_used;
+				history.span = std::max( history.span, stats.span );
+			}
+		}
+		auto const per_hour = static_cast<uint64_t>( history.bytes_per_1k_process_hours( ) );
+		auto status = wxString::Format(
+		  L"Showing %zu of %zu processes, history %s (%s per 1k processes an hour)",
+		  shown, total, memory_value_to_wstring( history.memory_used ),
+		  memory_value_to_wstring( per_hour ) );
+		if( auto const page = find_page( current ) ) {
+			if( !page->error.empty( ) ) {
+				status += L", refresh failed: " + page->error;
+			}
+			using std::chrono::milliseconds;
+			auto const timing = page->table->last_load_timing( );
+			if( timing.first_row ) {
+				status += wxString::Format(
+				  L", first row after %lld ms",
+				  static_cast<long long>(
+				    std::chrono::duration_cast<milliseconds>( *timing.first_row )
+				      .count( ) ) );
+			}
+			if( timing.complete ) {
+				status += wxString::Format(
+				  L", all after %lld ms",
+				  static_cast<long long>(
+				    std::chrono::duration_cast<milliseconds>( *timing.complete )
+				      .count( ) ) );
+			}
+		}
+		SetStatusText( status );
+	}
+
+	void remote_task_management_frame::show_fleet( ) {
+		if( m_fleet_grid ) {
+			m_notebook->SetSelection(
+			  static_cast<size_t>( m_notebook->FindPage( m_fleet_grid ) ) );
+			return;
+		}
+		auto fleet = new fleet_table( );
+		fleet->set_row_limit( m_row_limit );
+		for( auto const &page : m_pages ) {
+			fleet->add_host( page.table );
+		}
+		auto dg = new wxGrid( m_notebook, wxID_ANY );
+		dg->SetTable( fleet, true );
+		dg->HideRowLabels( );
+		dg->EnableEditing( false );
+		dg->AutoSizeColumns( );
+		dg->Bind( wxEVT_GRID_COL_SORT, [fleet]( wxGridEvent &event ) {
+			fleet->sort_column( event.GetCol( ) );
+		} );
+		m_fleet = fleet;
+		m_fleet_grid = dg;
+		m_notebook->AddPage( dg, L"Fleet", true );
+	}
+
 	void remote_task_management_frame::setup_handlers( ) {
+		Bind( wxEVT_NOTEBOOK_PAGE_CHANGED,
+		      [&]( wxBookCtrlEvent &event ) {
+			      on_page_changed( );
+			      event.Skip( );
+		      } );
+
+		// Process start/stop events only need to reach the page that is shown
+		m_tmr = std::make_unique<wxTimer>( this );
+		Bind( wxEVT_TIMER,
+		      [&]( wxTimerEvent & ) {
+			      apply_events( );
+		      },
+		      m_tmr->GetId( ) );
+		m_tmr->Start( 500 );
+
 		Bind( wxEVT_COMMAND_MENU_SELECTED, [&]( wxCommandEvent & ) { Close( ); },
 		      wxID_EXIT );
 
@@ -183,12 +459,70 @@ namespace daw {
 			      }
 		      },
 		      remote_task_management_frame_event_ids::id_open_remote );
+
+		Bind( wxEVT_COMMAND_MENU_SELECTED, [&]( wxCommandEvent & ) { show_fleet( ); },
+		      remote_task_management_frame_event_ids::id_show_fleet );
+
+		Bind( wxEVT_COMMAND_MENU_SELECTED,
+		      [&]( wxCommandEvent &event ) {
+			      set_row_limit( event.IsChecked( ) ? top_row_limit : 0 );
+		      },
+		      remote_task_management_frame_event_ids::id_top_only );
+
+		Bind( wxEVT_COMMAND_MENU_SELECTED,
+		      [&]( wxCommandEvent & ) {
+			      wxFileDialog dlg( this, L"Open recording", wxEmptyString,
+			                        wxEmptyString, L"Recordings (*.dsnap)|*.dsnap",
+			                        wxFD_OPEN | wxFD_FILE_MUST_EXIST );
+			      if( dlg.ShowModal( ) == wxID_OK ) {
+				      add_recording_page( dlg.GetPath( ) );
+			      }
+		      },
+		      remote_task_management_frame_event_ids::id_open_recording );
+
+		Bind( wxEVT_COMMAND_MENU_SELECTED,
+		      [&]( wxCommandEvent &event ) {
+			      auto const page = find_page( m_notebook->GetCurrentPage( ) );
+			      if( !page ) {
+				      GetMenuBar( )->Check( event.GetId( ), false );
+				      return;
+			      }
+			      if( !event.IsChecked( ) ) {
+				      page->table->set_recorder( nullptr );
+				      return;
+			      }
+			      wxFileDialog dlg( this, L"Record to", wxEmptyString, wxEmptyString,
+			                        L"Recordings (*.dsnap)|*.dsnap",
+			                        wxFD_SAVE | wxFD_OVERWRITE_PROMPT );
+			      try {
+				      if( dlg.ShowModal( ) == wxID_OK ) {
+					      page->table->set_recorder( std::make_shared<snapshot_file::writer>(
+					        dlg.GetPath( ).ToStdString( ) ) );
+					      return;
+				      }
+			      } catch( std::exception const &ex ) {
+				      wxMessageBox( wxString( ex.what( ) ), L"Recording error" );
+			      }
+			      GetMenuBar( )->Check( event.GetId( ), false );
+		      },
+		      remote_task_management_frame_event_ids::id_record );
 	}
 
 	void remote_task_management_frame::setup_menus( ) {
 		auto menu_file = new wxMenu( );
 		menu_file->Append( remote_task_management_frame_event_ids::id_open_remote,
 		                   L"&Open Remote\tCtrl-O", L"Open task on remote system" );
+		menu_file->Append( remote_task_management_frame_event_ids::id_show_fleet,
+		                   L"&Fleet View\tCtrl-F", L"All hosts' processes in one table" );
+		menu_file->AppendCheckItem( remote_task_management_frame_event_ids::id_top_only,
+		                            L"&Top 50 Only\tCtrl-T",
+		                            L"Only fetch the first 50 processes in sort order" );
+		menu_file->AppendSeparator( );
+		menu_file->AppendCheckItem( remote_task_management_frame_event_ids::id_record,
+		                            L"&Record Current Host...\tCtrl-R",
+		                            L"Append every refresh of this host to a file" );
+		menu_file->Append( remote_task_management_frame_event_ids::id_open_recording,
+		                   L"Open Re&cording...", L"Replay a recorded host" );
 		menu_file->AppendSeparator( );
 		menu_file->Append( wxID_EXIT );
 
@@ -227,6 +561,7 @@ namespace daw {
 		setup_handlers( );
 		setup_menus( );
 		setup_notebook( );
+		CreateStatusBar( );
 
 		// Add hosts
 		if( connect_to.empty( ) ) {
@@ -235,5 +570,14 @@ namespace daw {
 		for( auto const &host : connect_to ) {
 			add_page( host );
 		}
+		on_page_changed( );
+	}
+
+	remote_task_management_frame::~remote_task_management_frame( ) {
+		if( m_tmr ) {
+			m_tmr->Stop( );
+		}
+		// Wait for the running refreshes while the tables still exist
+		m_scheduler.reset( );
 	}
 } // namespace daw
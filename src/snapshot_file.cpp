@@ -0,0 +1,507 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <wx/datetime.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "daw/process_store.h"
+#include "daw/snapshot_file.h"
+
+namespace daw {
+	namespace snapshot_file {
+		namespace {
+			using column_number = wmi_process::column_number;
+			using column_kinds = process_store::column_kinds;
+
+			constexpr char magic[8] = {'D', 'A', 'W', 'S', 'N', 'A', 'P', '1'};
+			// Kind, payload size and timestamp
+			constexpr size_t frame_header_size = 1 + 4 + 8;
+			constexpr int64_t invalid_date = std::numeric_limits<int64_t>::min( );
+
+			enum frame_kinds : uint8_t { strings_frame = 1, keyframe = 2, delta_frame = 3 };
+
+			constexpr uint64_t zigzag( int64_t value ) noexcept {
+				return ( static_cast<uint64_t>( value ) << 1U ) ^
+				       static_cast<uint64_t>( value >> 63 );
+			}
+
+			constexpr int64_t unzigzag( uint64_t value ) noexcept {
+				return static_cast<int64_t>( value >> 1U ) ^
+				       -static_cast<int64_t>( value & 1U );
+			}
+
+			void write_varint( uint64_t value, std::vector<uint8_t> &out ) {
+				while( value >= 0x80U ) {
+					out.push_back( static_cast<uint8_t>( value | 0x80U ) );
+					value >>= 7U;
+				}
+				out.push_back( static_cast<uint8_t>( value ) );
+			}
+
+			template<typename T>
+			void write_le( T value, uint8_t *out ) noexcept {
+				for( size_t n = 0; n < sizeof( T ); ++n ) {
+					out[n] = static_cast<uint8_t>( static_cast<uint64_t>( value ) >> ( 8U * n ) );
+				}
+			}
+
+			template<typename T>
+			T read_le( uint8_t const *first ) noexcept {
+				uint64_t result = 0;
+				for( size_t n = 0; n < sizeof( T ); ++n ) {
+					result |= static_cast<uint64_t>( first[n] ) << ( 8U * n );
+				}
+				return static_cast<T>( result );
+			}
+
+			// Reads the payload of one frame, throws when it runs past the end
+			struct payload_reader {
+				uint8_t const *first;
+				uint8_t const *last;
+
+				uint64_t varint( ) {
+					uint64_t result = 0;
+					for( unsigned shift = 0; shift < 64; shift += 7 ) {
+						if( first == last ) {
+							throw std::runtime_error( "Truncated snapshot frame" );
+						}
+						auto const b = *first++;
+						result |= static_cast<uint64_t>( b & 0x7FU ) << shift;
+						if( ( b & 0x80U ) == 0 ) {
+							return result;
+						}
+					}
+					throw std::runtime_error( "Invalid varint in snapshot frame" );
+				}
+			};
+
+			int64_t to_ticks( wxDateTime const &value ) {
+				if( !value.IsValid( ) ) {
+					return invalid_date;
+				}
+				return value.GetValue( ).GetValue( );
+			}
+
+			row_key key_of( writer::raw_row const &row ) {
+				return {row[static_cast<size_t>( column_number::ProcessId )],
+				        static_cast<int64_t>(
+				          row[static_cast<size_t>( column_number::CreationDate )] )};
+			}
+
+			wmi_process to_process( writer::raw_row const &raw,
+			                        std::vector<std::wstring> const &strings ) {
+				auto result = wmi_process{};
+				for( size_t n = 0; n < wmi_process::column_count; ++n ) {
+					process_store::visit_column( static_cast<column_number>( n ), [&]( auto c ) {
+						constexpr auto cn = decltype( c )::value;
+						auto &field = result.column<cn>( );
+						if constexpr( process_store::column_kind<cn>( ) == column_kinds::String ) {
+							if( raw[n] >= strings.size( ) ) {
+								throw std::runtime_error( "Invalid string id in snapshot file" );
+							}
+							field = std::wstring_view( strings[raw[n]] );
+						} else if constexpr( process_store::column_kind<cn>( ) ==
+						                     column_kinds::Date ) {
+							auto const ticks = static_cast<int64_t>( raw[n] );
+							if( ticks != invalid_date ) {
+								field.value = wxDateTime( wxLongLong( ticks ) );
+							}
+						} else {
+							field.value = static_cast<decltype( field.value )>( raw[n] );
+						}
+					} );
+				}
+				return result;
+			}
+
+			int64_t to_milliseconds( clock::time_point time ) {
+				return std::chrono::duration_cast<std::chrono::milliseconds>(
+				         time.time_since_epoch( ) )
+				  .count( );
+			}
+		} // namespace
+
+		void writer::file_closer::operator( )( std::FILE *f ) const noexcept {
+			std::fclose( f );
+		}
+
+		writer::writer( std::string const &path, writer_options_t const &options )
+		  : m_file( std::fopen( path.c_str( ), "wb" ) )
+		  , m_options( options ) {
+			if( !m_file ||
+			    std::fwrite( magic, 1, sizeof( magic ), m_file.get( ) ) != sizeof( magic ) ) {
+				throw std::runtime_error( "Could not create snapshot file " + path );
+			}
+			// Id 0 is the empty string
+			m_string_ids.emplace( std::wstring{}, 0 );
+		}
+
+		void writer::write_frame( uint8_t kind, clock::time_point time ) {
+			uint8_t header[frame_header_size];
+			header[0] = kind;
+			write_le( static_cast<uint32_t>( m_buffer.size( ) ), header + 1 );
+			write_le( to_milliseconds( time ), header + 5 );
+			if( std::fwrite( header, 1, sizeof( header ), m_file.get( ) ) !=
+			      sizeof( header ) ||
+			    std::fwrite( m_buffer.data( ), 1, m_buffer.size( ), m_file.get( ) ) !=
+			      m_buffer.size( ) ) {
+				throw std::runtime_error( "Error writing snapshot file" );
+			}
+			m_buffer.clear( );
+		}
+
+		void writer::append( std::vector<wmi_process> const &rows,
+		                     clock::time_point time ) {
+			append( rows, column_set{}.set( ), time );
+		}
+
+		void writer::append( std::vector<wmi_process> const &rows,
+		                     column_set columns, clock::time_point time ) {
+			static constexpr auto pid_col = static_cast<size_t>( column_number::ProcessId );
+			static constexpr auto date_col =
+			  static_cast<size_t>( column_number::CreationDate );
+			// New strings go out first, in a frame of their own
+			auto new_strings = std::vector<std::wstring_view>( );
+			auto current = std::vector<raw_row>( rows.size( ) );
+			auto const is_partial = !columns.all( );
+			for( size_t r = 0; r < rows.size( ); ++r ) {
+				raw_row const *carried = nullptr;
+				if( is_partial ) {
+					current[r][pid_col] = rows[r].process_id.value;
+					current[r][date_col] =
+					  static_cast<uint64_t>( to_ticks( rows[r].creation_date.value ) );
+					auto pos = m_previous_index.find( key_of( current[r] ) );
+					if( pos != m_previous_index.end( ) ) {
+						carried = &m_previous[pos->second];
+					}
+				}
+				for( size_t n = 0; n < wmi_process::column_count; ++n ) {
+					if( carried && !columns[n] ) {
+						current[r][n] = ( *carried )[n];
+						continue;
+					}
+					process_store::visit_column( static_cast<column_number>( n ), [&]( auto c ) {
+						constexpr auto cn = decltype( c )::value;
+						auto const &field = rows[r].column<cn>( );
+						if constexpr( process_store::column_kind<cn>( ) ==
+						              column_kinds::String ) {
+							auto [pos, is_new] = m_string_ids.try_emplace(
+							  field.value.ToStdWstring( ), m_string_ids.size( ) );
+							if( is_new ) {
+								new_strings.push_back( pos->first );
+							}
+							current[r][n] = pos->second;
+						} else if constexpr( process_store::column_kind<cn>( ) ==
+						                     column_kinds::Date ) {
+							current[r][n] = static_cast<uint64_t>( to_ticks( field.value ) );
+						} else {
+							current[r][n] = static_cast<uint64_t>( field.value );
+						}
+					} );
+				}
+			}
+			if( !new_strings.empty( ) ) {
+				write_varint( new_strings.size( ), m_buffer );
+				for( auto str : new_strings ) {
+					write_varint( str.size( ), m_buffer );
+					for( auto ch : str ) {
+						write_varint( static_cast<uint64_t>( ch ), m_buffer );
+					}
+				}
+				write_frame( strings_frame, time );
+			}
+
+			auto const is_keyframe = m_snapshot_count % m_options.keyframe_interval == 0;
+			auto const zero = raw_row{};
+			write_varint( current.size( ), m_buffer );
+			for( auto const &row : current ) {
+				auto const *previous = &zero;
+				size_t previous_pos = 0;
+				if( !is_keyframe ) {
+					auto pos = m_previous_index.find( key_of( row ) );
+					if( pos != m_previous_index.end( ) ) {
+						previous = &m_previous[pos->second];
+						previous_pos = pos->second + 1;
+					}
+				}
+				uint64_t changed = 0;
+				for( size_t n = 0; n < wmi_process::column_count; ++n ) {
+					if( row[n] != ( *previous )[n] ) {
+						changed |= uint64_t{1} << n;
+					}
+				}
+				write_varint( previous_pos, m_buffer );
+				write_varint( changed, m_buffer );
+				for( size_t n = 0; n < wmi_process::column_count; ++n ) {
+					if( changed & ( uint64_t{1} << n ) ) {
+						write_varint(
+						  zigzag( static_cast<int64_t>( row[n] - ( *previous )[n] ) ),
+						  m_buffer );
+					}
+				}
+			}
+			write_frame( is_keyframe ? keyframe : delta_frame, time );
+			// A crash loses at most the snapshot being written
+			std::fflush( m_file.get( ) );
+
+			m_previous_index.clear( );
+			for( size_t r = 0; r < current.size( ); ++r ) {
+				m_previous_index.emplace( key_of( current[r] ), r );
+			}
+			m_previous = std::move( current );
+			++m_snapshot_count;
+		}
+
+		// The whole file mapped read only
+		struct reader::mapping {
+			uint8_t const *data = nullptr;
+			size_t size = 0;
+#ifdef _WIN32
+			HANDLE file = INVALID_HANDLE_VALUE;
+			HANDLE map = nullptr;
+
+			explicit mapping( std::string const &path ) {
+				file = CreateFileA( path.c_str( ), GENERIC_READ, FILE_SHARE_READ, nullptr,
+				                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+				LARGE_INTEGER file_size{};
+				if( file == INVALID_HANDLE_VALUE || !GetFileSizeEx( file, &file_size ) ) {
+					close( );
+					throw std::runtime_error( "Could not open snapshot file " + path );
+				}
+				size = static_cast<size_t>( file_size.QuadPart );
+				if( size == 0 ) {
+					return;
+				}
+				map = CreateFileMappingW( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+				if( map ) {
+					data = static_cast<uint8_t const *>(
+					  MapViewOfFile( map, FILE_MAP_READ, 0, 0, 0 ) );
+				}
+				if( !data ) {
+					close( );
+					throw std::runtime_error( "Could not map snapshot file " + path );
+				}
+			}
+
+			void close( ) noexcept {
+				if( data ) {
+					UnmapViewOfFile( data );
+				}
+				if( map ) {
+					CloseHandle( map );
+				}
+				if( file != INVALID_HANDLE_VALUE ) {
+					CloseHandle( file );
+				}
+			}
+#else
+			int fd = -1;
+
+			explicit mapping( std::string const &path ) {
+				fd = open( path.c_str( ), O_RDONLY );
+				struct stat st {};
+				if( fd < 0 || fstat( fd, &st ) != 0 ) {
+					close( );
+					throw std::runtime_error( "Could not open snapshot file " + path );
+				}
+				size = static_cast<size_t>( st.st_size );
+				if( size == 0 ) {
+					return;
+				}
+				auto const ptr = mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+				if( ptr == MAP_FAILED ) {
+					close( );
+					throw std::runtime_error( "Could not map snapshot file " + path );
+				}
+				data = static_cast<uint8_t const *>( ptr );
+			}
+
+			void close( ) noexcept {
+				if( data ) {
+					munmap( const_cast<uint8_t *>( data ), size );
+				}
+				if( fd >= 0 ) {
+					::close( fd );
+				}
+			}
+#endif
+			~mapping( ) {
+				close( );
+			}
+
+			mapping( mapping const & ) = delete;
+			mapping &operator=( mapping const & ) = delete;
+		};
+
+		reader::reader( std::string const &path )
+		  : m_mapping( std::make_unique<mapping>( path ) ) {
+			auto const data = m_mapping->data;
+			auto const size = m_mapping->size;
+			if( size < sizeof( magic ) ||
+			    std::memcmp( data, magic, sizeof( magic ) ) != 0 ) {
+				throw std::runtime_error( path + " is not a snapshot file" );
+			}
+			// Id 0 is the empty string
+			m_strings.emplace_back( );
+			auto pos = sizeof( magic );
+			while( size - pos >= frame_header_size ) {
+				auto const kind = data[pos];
+				auto const payload_size = read_le<uint32_t>( data + pos + 1 );
+				auto const time = clock::time_point(
+				  std::chrono::milliseconds( read_le<int64_t>( data + pos + 5 ) ) );
+				auto const first = pos + frame_header_size;
+				if( size - first < payload_size ) {
+					// Cut short while being written
+					break;
+				}
+				if( kind == strings_frame ) {
+					auto in = payload_reader{data + first, data + first + payload_size};
+					auto count = in.varint( );
+					while( count-- > 0 ) {
+						auto str = std::wstring( static_cast<size_t>( in.varint( ) ), L'\0' );
+						for( auto &ch : str ) {
+							ch = static_cast<wchar_t>( in.varint( ) );
+						}
+						m_strings.push_back( std::move( str ) );
+					}
+				} else if( kind == keyframe || kind == delta_frame ) {
+					if( m_snapshots.empty( ) && kind != keyframe ) {
+						throw std::runtime_error( path + " does not start with a keyframe" );
+					}
+					m_snapshots.push_back( {time, first, payload_size, kind == keyframe} );
+				}
+				pos = first + payload_size;
+			}
+		}
+
+		reader::~reader( ) = default;
+		reader::reader( reader && ) noexcept = default;
+		reader &reader::operator=( reader && ) noexcept = default;
+
+		size_t reader::find( clock::time_point time ) const {
+			auto pos = std::upper_bound(
+			  m_snapshots.begin( ), m_snapshots.end( ), time,
+			  []( clock::time_point t, snapshot_t const &s ) { return t < s.time; } );
+			if( pos == m_snapshots.begin( ) ) {
+				return 0;
+			}
+			return static_cast<size_t>( pos - m_snapshots.begin( ) ) - 1;
+		}
+
+		void reader::decode( size_t n ) {
+			if( n == m_current_index ) {
+				return;
+			}
+			auto first = n;
+			while( !m_snapshots[first].is_keyframe ) {
+				--first;
+			}
+			if( m_current_index < n && m_current_index >= first ) {
+				// Carry on from the last one read
+				first = m_current_index + 1;
+			}
+			auto const zero = raw_row{};
+			for( auto index = first; index <= n; ++index ) {
+				auto const &snapshot = m_snapshots[index];
+				auto in = payload_reader{m_mapping->data + snapshot.offset,
+				                         m_mapping->data + snapshot.offset + snapshot.size};
+				auto rows = std::vector<raw_row>( static_cast<size_t>( in.varint( ) ) );
+				for( auto &row : rows ) {
+					auto const previous_pos = in.varint( );
+					if( previous_pos > m_current.size( ) ) {
+						throw std::runtime_error( "Invalid row in snapshot file" );
+					}
+					auto const &previous =
+					  previous_pos == 0 ? zero : m_current[previous_pos - 1];
+					auto const changed = in.varint( );
+					for( size_t c = 0; c < wmi_process::column_count; ++c ) {
+						row[c] = previous[c];
+						if( changed & ( uint64_t{1} << c ) ) {
+							row[c] += static_cast<uint64_t>( unzigzag( in.varint( ) ) );
+						}
+					}
+				}
+				m_current = std::move( rows );
+				m_current_index = index;
+			}
+		}
+
+		std::vector<wmi_process> reader::read( size_t n ) {
+			decode( n );
+			auto result = std::vector<wmi_process>( );
+			result.reserve( m_current.size( ) );
+			for( auto const &row : m_current ) {
+				result.push_back( to_process( row, m_strings ) );
+			}
+			return result;
+		}
+	} // namespace snapshot_file
+
+	replay_source::replay_source( std::shared_ptr<snapshot_file::reader> reader )
+	  : m_reader( std::move( reader ) ) {}
+
+	std::vector<wmi_process> replay_source::operator( )( ) {
+		std::lock_guard<std::mutex> lck( m_mutex );
+		if( m_reader->size( ) == 0 ) {
+			return {};
+		}
+		auto result = m_reader->read( m_position );
+		if( m_position + 1 < m_reader->size( ) ) {
+			++m_position;
+		}
+		return result;
+	}
+
+	void replay_source::seek( snapshot_file::clock::time_point time ) {
+		std::lock_guard<std::mutex> lck( m_mutex );
+		m_position = m_reader->find( time );
+	}
+
+	size_t replay_source::position( ) const {
+		std::lock_guard<std::mutex> lck( m_mutex );
+		return m_position;
+	}
+} // namespace daw
@@ -0,0 +1,78 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <wx/grid.h>
+
+#include "daw/process_history.h"
+#include "daw/sparkline_renderer.h"
+#include "daw/wmi_process_table.h"
+
+namespace daw {
+	sparkline_renderer::sparkline_renderer( process_history::series_kinds kind )
+	  : m_kind( kind ) {}
+
+	void sparkline_renderer::Draw( wxGrid &grid, wxGridCellAttr &attr, wxDC &dc,
+	                               wxRect const &rect, int row, int col,
+	                               bool is_selected ) {
+		wxGridCellStringRenderer::Draw( grid, attr, dc, rect, row, col,
+		                                is_selected );
+		auto table = dynamic_cast<wmi_process_table *>( grid.GetTable( ) );
+		if( !table || rect.width < 4 || rect.height < 4 ) {
+			return;
+		}
+		auto const values = table->history( row, m_kind );
+		if( values.size( ) < 2 ) {
+			return;
+		}
+		auto const [low, high] = std::minmax_element( values.begin( ), values.end( ) );
+		auto const range = static_cast<double>( *high - *low );
+		// At most one point per pixel, the newest samples at the right edge
+		auto const count =
+		  std::min( values.size( ), static_cast<size_t>( rect.width ) );
+		auto const first = values.end( ) - static_cast<std::ptrdiff_t>( count );
+		auto const x_step =
+		  static_cast<double>( rect.width - 1 ) / static_cast<double>( count - 1 );
+		auto const bottom = rect.y + rect.height - 2;
+		auto const height = rect.height - 3;
+		auto points = std::vector<wxPoint>( );
+		points.reserve( count );
+		for( size_t n = 0; n < count; ++n ) {
+			auto const level =
+			  range > 0.0 ? static_cast<double>( first[static_cast<std::ptrdiff_t>( n )] -
+			                                     *low ) /
+			                  range
+			              : 0.5;
+			points.emplace_back( rect.x + static_cast<int>( x_step * n ),
+			                     bottom - static_cast<int>( level * height ) );
+		}
+		wxDCClipper clip( dc, rect );
+		dc.SetPen( wxPen( wxColour( 0, 120, 215 ) ) );
+		dc.DrawLines( static_cast<int>( points.size( ) ), points.data( ) );
+	}
+
+	wxGridCellRenderer *sparkline_renderer::Clone( ) const {
+		return new sparkline_renderer( m_kind );
+	}
+} // namespace daw
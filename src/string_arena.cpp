@@ -0,0 +1,67 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <memory>
+#include <string_view>
+
+#include "daw/string_arena.h"
+
+namespace daw {
+	string_arena::string_arena( ) {
+		m_strings.emplace_back( );
+		m_index.emplace( std::wstring_view( ), 0 );
+	}
+
+	std::wstring_view string_arena::store( std::wstring_view str ) {
+		if( str.size( ) > block_size / 4 ) {
+			// Large strings get their own block so that they do not waste the
+			// remainder of the current one
+			auto block = std::make_unique<wchar_t[]>( str.size( ) );
+			std::copy( str.begin( ), str.end( ), block.get( ) );
+			auto result = std::wstring_view( block.get( ), str.size( ) );
+			m_blocks.insert( m_blocks.end( ) - ( m_blocks.empty( ) ? 0 : 1 ),
+			                 std::move( block ) );
+			return result;
+		}
+		if( block_size - m_block_used < str.size( ) ) {
+			m_blocks.push_back( std::make_unique<wchar_t[]>( block_size ) );
+			m_block_used = 0;
+		}
+		auto const first = m_blocks.back( ).get( ) + m_block_used;
+		std::copy( str.begin( ), str.end( ), first );
+		m_block_used += str.size( );
+		return std::wstring_view( first, str.size( ) );
+	}
+
+	string_arena::string_id string_arena::intern( std::wstring_view str ) {
+		if( auto pos = m_index.find( str ); pos != m_index.end( ) ) {
+			return pos->second;
+		}
+		auto const stored = store( str );
+		m_chars += stored.size( );
+		auto const id = static_cast<string_id>( m_strings.size( ) );
+		m_strings.push_back( stored );
+		m_index.emplace( stored, id );
+		return id;
+	}
+} // namespace daw
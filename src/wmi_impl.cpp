@@ -22,6 +22,10 @@
 //
 
 #include <combaseapi.h>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <thread>
 #include <utility>
 
 #include "daw/wmi_impl.h"
@@ -45,9 +49,7 @@ namespace daw {
 		}
 	}
 
-	wmi_state_t::wmi_state_t( DWORD co_init )
-	  : init( co_init ) {
-
+	wmi_state_t::wmi_state_t( ) {
 		static auto const sec_res = []( ) {
 			// Can only be called once per process
 			auto const hres = CoInitializeSecurity(
@@ -71,7 +73,6 @@ namespace daw {
 		                              reinterpret_cast<LPVOID *>( &locator ) );
 
 		if( FAILED( hres ) ) {
-			CoUninitialize( );
 			throw wmi_error_t{"Failed to create IWbemLocator object",
 			                  hres};
 		}
@@ -128,4 +129,121 @@ namespace daw {
 		}
 		return result;
 	}
+
+	bool is_connection_lost( long hr ) noexcept {
+		return hr == HRESULT_FROM_WIN32( RPC_S_SERVER_UNAVAILABLE ) ||
+		       hr == HRESULT_FROM_WIN32( RPC_S_CALL_FAILED ) ||
+		       hr == HRESULT_FROM_WIN32( RPC_S_CALL_FAILED_DNE ) ||
+		       hr == RPC_E_DISCONNECTED || hr == RPC_E_SERVER_DIED ||
+		       hr == RPC_E_SERVER_DIED_DNE || hr == WBEM_E_TRANSPORT_FAILURE;
+	}
+
+	namespace {
+		// COM tears down the multithreaded apartment, and every proxy in the
+		// pool with it, once the last thread leaves it.  This keeps a thread in
+		// it while connections are pooled.  CoIncrementMTAUsage does the same
+		// but needs Windows 8
+		class mta_pin {
+			std::mutex m_mutex;
+			std::condition_variable m_released;
+			bool m_is_pinned = false;
+			std::thread m_thread;
+
+		public:
+			mta_pin( ) = default;
+			mta_pin( mta_pin const & ) = delete;
+			mta_pin &operator=( mta_pin const & ) = delete;
+
+			~mta_pin( ) {
+				release( );
+			}
+
+			void acquire( ) {
+				std::lock_guard<std::mutex> lck( m_mutex );
+				if( m_is_pinned ) {
+					return;
+				}
+				m_is_pinned = true;
+				auto entered = std::promise<void>( );
+				auto has_entered = entered.get_future( );
+				m_thread = std::thread( [this, entered = std::move( entered )]( ) mutable {
+					try {
+						wmi_state_co const init( COINIT_MULTITHREADED );
+						entered.set_value( );
+						std::unique_lock<std::mutex> wait_lck( m_mutex );
+						m_released.wait( wait_lck, [this]( ) { return !m_is_pinned; } );
+					} catch( ... ) {
+						entered.set_exception( std::current_exception( ) );
+					}
+				} );
+				try {
+					has_entered.get( );
+				} catch( ... ) {
+					m_is_pinned = false;
+					m_thread.join( );
+					throw;
+				}
+			}
+
+			void release( ) {
+				{
+					std::lock_guard<std::mutex> lck( m_mutex );
+					if( !m_is_pinned ) {
+						return;
+					}
+					m_is_pinned = false;
+				}
+				m_released.notify_all( );
+				m_thread.join( );
+			}
+		};
+
+		mta_pin &pinned_mta( ) {
+			static mta_pin result;
+			return result;
+		}
+	} // namespace
+
+	std::shared_ptr<wmi_state_t>
+	wmi_connection_backend::connect( std::wstring const &host ) {
+		// Outlives the calling thread's stay in the apartment
+		pinned_mta( ).acquire( );
+		auto result = std::make_shared<wmi_state_t>( );
+		result->connect( L"ROOT\\CIMV2", host );
+		return result;
+	}
+
+	bool wmi_connection_backend::is_connection_lost(
+	  std::exception const &ex ) const {
+		auto const err = dynamic_cast<wmi_error_t const *>( &ex );
+		return err && daw::is_connection_lost( err->code );
+	}
+
+	connection_pool<wmi_state_t> &wmi_connections( ) {
+		static connection_pool<wmi_state_t> pool(
+		  std::make_unique<wmi_connection_backend>( ) );
+		return pool;
+	}
+
+	void close_wmi_connections( ) {
+		run_in_mta( []( ) { wmi_connections( ).clear( ); } );
+		pinned_mta( ).release( );
+	}
+
+	namespace impl {
+		bool enter_mta( ) {
+			auto const hres = CoInitializeEx( nullptr, COINIT_MULTITHREADED );
+			if( hres == RPC_E_CHANGED_MODE ) {
+				return false;
+			}
+			if( FAILED( hres ) ) {
+				throw wmi_error_t{"Failed to init COM library", hres};
+			}
+			return true;
+		}
+
+		co_uninitializer::~co_uninitializer( ) {
+			CoUninitialize( );
+		}
+	} // namespace impl
 } // namespace daw
@@ -20,52 +20,32 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 //
+#include <algorithm>
 #include <array>
 #include <atlcomcli.h>
 #include <chrono>
 #include <comdef.h>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 #include <wbemidl.h>
 #include <wx/datetime.h>
 #include <wx/string.h>
 
+#include "daw/parallel.h"
+#include "daw/process_source.h"
 #include "daw/variant_visit.h"
+#include "daw/wmi_enumerate.h"
 #include "daw/wmi_impl.h"
 #include "daw/wmi_process.h"
+#include "daw/wmi_projection.h"
+#include "daw/wmi_record_decoder.h"
 
 #pragma comment( lib, "wbemuuid.lib" )
 
 namespace daw {
-
-	std::array<wxString, 14> const wmi_process::column_names = []( ) {
-		std::array<wxString, 14> result;
-		result[static_cast<size_t>( column_number::Name )] = L"Name";
-		result[static_cast<size_t>( column_number::ProcessId )] = L"Process Id";
-		result[static_cast<size_t>( column_number::ParentProcessId )] =
-		  L"Parent Process Id";
-		result[static_cast<size_t>( column_number::SessionId )] = L"Session Id";
-		result[static_cast<size_t>( column_number::Handle )] = L"Handle";
-		result[static_cast<size_t>( column_number::CreationDate )] =
-		  L"Creation Date";
-		result[static_cast<size_t>( column_number::ThreadCount )] = L"Thread Count";
-		result[static_cast<size_t>( column_number::PageFaults )] = L"Page Faults";
-		result[static_cast<size_t>( column_number::PageFileUsage )] = L"Page File";
-		result[static_cast<size_t>( column_number::PeakPageFileUsage )] =
-		  L"Peak Page File";
-		result[static_cast<size_t>( column_number::WorkingSetSize )] =
-		  L"Working Set";
-		result[static_cast<size_t>( column_number::PeakWorkingSetSize )] =
-		  L"Peak Working Set";
-		result[static_cast<size_t>( column_number::ReadTransferCount )] =
-		  L"Read Transfer";
-		result[static_cast<size_t>( column_number::WriteTransferCount )] =
-		  L"Write Transfer";
-		result[static_cast<size_t>( column_number::CommandLine )] = L"CommandLine";
-		return result;
-	}( );
-
 	namespace {
 		template<size_t N>
 		std::wstring to_wstring( wchar_t const ( &str )[N] ) {
@@ -88,23 +68,35 @@ namespace daw {
 			return ( to_wstring( std::forward<Args>( args ) ) + ... );
 		}
 
+		// property points to a static name, no key is built per lookup
 		CComVariant get_property( CComPtr<IWbemClassObject> const &obj,
-		                          std::wstring const &property ) {
+		                          wchar_t const *property ) {
 
 			CComVariant v;
-			auto const hr = obj->Get( property.c_str( ), 0, &v, nullptr, nullptr );
+			auto const hr = obj->Get( property, 0, &v, nullptr, nullptr );
 			if( FAILED( hr ) ) {
 				throw wmi_error_t{"Error retrieving property", hr};
 			}
 			return v;
 		}
 
-		std::wstring get_wstring( CComPtr<IWbemClassObject> const &obj,
-		                          std::wstring const &property ) {
-			return daw::variant_visit<std::wstring>(
-			  get_property( obj, property ),
-			  []( BSTR str ) { return std::wstring( str ); },
-			  []( ) { return std::wstring{}; } );
+		// Only copies str when it differs from what dest already holds
+		void assign_string( String &dest, std::wstring_view str ) {
+			if( std::wstring_view( dest.value.wc_str( ), dest.value.length( ) ) !=
+			    str ) {
+				dest = str;
+			}
+		}
+
+		// Copies a string property straight from its BSTR into dest
+		void get_string( String &dest, CComPtr<IWbemClassObject> const &obj,
+		                 wchar_t const *property ) {
+			auto const v = get_property( obj, property );
+			auto str = std::wstring_view( );
+			if( v.vt == VT_BSTR && v.bstrVal != nullptr ) {
+				str = std::wstring_view( v.bstrVal, SysStringLen( v.bstrVal ) );
+			}
+			assign_string( dest, str );
 		}
 
 		constexpr bool is_number( wchar_t c ) noexcept {
@@ -153,7 +145,7 @@ namespace daw {
 
 		template<typename Integer>
 		Integer get_integer( CComPtr<IWbemClassObject> const &obj,
-		                     std::wstring const &property ) {
+		                     wchar_t const *property ) {
 			// Integer must be convertible from the value type stored in
 			// the VARIANT
 			return variant_visit<Integer>(
@@ -165,152 +157,336 @@ namespace daw {
 			);
 		}
 
+		// A CIM_DATETIME, yyyymmddHHMMSS.mmmmmmsUUU
+		// Invalid when str is empty or not a date, e.g. the System Idle
+		// Process has no CreationDate
+		wxDateTime parse_cim_datetime( wxString const &str ) {
+			wxDateTime result;
+			if( str.empty( ) || !result.ParseFormat( str, L"%Y%m%d%H%M%S%Z" ) ) {
+				return wxDateTime( );
+			}
+			return result;
+		}
+
 		wxDateTime get_datetime( CComPtr<IWbemClassObject> const &obj,
-		                         std::wstring const &property ) {
+		                         wchar_t const *property ) {
 			return variant_visit<wxDateTime>(
 			  get_property( obj, property ),
-			  []( BSTR str ) {
-				  wxDateTime result;
-				  if( !result.ParseFormat( str, L"%Y%m%d%H%M%S%Z" ) ) {
-					  return wxDateTime::Now( );
-				  }
-				  return result;
-			  },
-			  from_variant_date{} );
-		}
-
-		template<typename T>
-		constexpr T from_kilobytes( T kilobyte_value ) noexcept {
-			return kilobyte_value * static_cast<T>( 1024 );
+			  []( BSTR str ) { return parse_cim_datetime( str ); },
+			  from_variant_date{},
+			  []( ) { return wxDateTime( ); } /* null, do not fail */
+			);
 		}
 
-		struct make_wmi_process {
-			wmi_process operator( )( CComPtr<IWbemClassObject> &record ) const {
-				auto item = wmi_process{};
-				item.name = get_wstring( record, L"Name" );
-				item.command_line = get_wstring( record, L"CommandLine" );
-				item.process_id = get_integer<uint32_t>( record, L"ProcessId" );
+		// IWbemClassObject::Get, a name lookup on every read
+		struct name_access {
+			using record_t = CComPtr<IWbemClassObject>;
+			using handle_t = wchar_t const *;
 
-				item.parent_process_id =
-				  get_integer<uint32_t>( record, L"ParentProcessId" );
+			std::optional<handle_t> resolve( record_t &, wchar_t const *name,
+			                                 cim_kinds ) const {
+				return name;
+			}
 
-				item.session_id = get_integer<uint32_t>( record, L"SessionId" );
-				item.handle = get_wstring( record, L"Handle" );
-				item.creation_date = get_datetime( record, L"CreationDate" );
-				item.thread_count = get_integer<uint32_t>( record, L"ThreadCount" );
-				item.page_faults = get_integer<uint32_t>( record, L"PageFaults" );
+			uint32_t read_uint32( record_t &record, handle_t property ) const {
+				return get_integer<uint32_t>( record, property );
+			}
 
-				item.page_file_usage =
-				  from_kilobytes( get_integer<uint64_t>( record, L"PageFileUsage" ) );
+			uint64_t read_uint64( record_t &record, handle_t property ) const {
+				return get_integer<uint64_t>( record, property );
+			}
 
-				item.peak_page_file_usage = from_kilobytes(
-				  get_integer<uint64_t>( record, L"PeakPageFileUsage" ) );
+			void read_string( record_t &record, handle_t property,
+			                  String &dest ) const {
+				get_string( dest, record, property );
+			}
 
-				item.working_set_size =
-				  get_integer<uint32_t>( record, L"WorkingSetSize" );
+			wxDateTime read_datetime( record_t &record, handle_t property ) const {
+				return get_datetime( record, property );
+			}
+		};
 
-				item.peak_working_set_size = from_kilobytes(
-				  get_integer<uint64_t>( record, L"PeakWorkingSetSize" ) );
+		constexpr CIMTYPE to_cim_type( cim_kinds kind ) noexcept {
+			switch( kind ) {
+			case cim_kinds::String:
+				return CIM_STRING;
+			case cim_kinds::Uint32:
+				return CIM_UINT32;
+			case cim_kinds::Uint64:
+				return CIM_UINT64;
+			case cim_kinds::Datetime:
+			default:
+				return CIM_DATETIME;
+			}
+		}
 
-				item.read_transfer_count =
-				  get_integer<uint64_t>( record, L"ReadTransferCount" );
+		// IWbemObjectAccess, the properties are resolved to handles once and
+		// read without a name lookup or a VARIANT
+		struct handle_access {
+			using record_t = IWbemObjectAccess;
+			using handle_t = long;
+
+			std::optional<handle_t> resolve( record_t &record, wchar_t const *name,
+			                                 cim_kinds kind ) const {
+				CIMTYPE type = CIM_EMPTY;
+				long handle = 0;
+				if( FAILED( record.GetPropertyHandle( name, &type, &handle ) ) ||
+				    type != to_cim_type( kind ) ) {
+					return std::nullopt;
+				}
+				return handle;
+			}
 
-				item.write_transfer_count =
-				  get_integer<uint64_t>( record, L"WriteTransferCount" );
-				return item;
+			// A null property reads as 0, like get_integer
+			uint32_t read_uint32( record_t &record, handle_t handle ) const {
+				DWORD value = 0;
+				if( record.ReadDWORD( handle, &value ) != WBEM_S_NO_ERROR ) {
+					return 0;
+				}
+				return value;
 			}
-		};
 
-		template<typename Enumerator, typename OutputIterator, typename Function>
-		void transform( Enumerator &&enumerator, OutputIterator iter,
-		                Function &&func ) {
-			static_assert(
-			  std::is_invocable_v<Function, CComPtr<IWbemClassObject>>,
-			  "Function must be callable with CComPtr<IWbemClassObject>" );
-
-			while( enumerator ) {
-				CComPtr<IWbemClassObject> current_record;
-				unsigned long record_count = 0;
-				auto const hr =
-				  enumerator->Next( WBEM_INFINITE, 1, &current_record, &record_count );
-				if( record_count == 0 || FAILED( hr ) ) {
-					// We have an error or no more records left
-					break;
+			uint64_t read_uint64( record_t &record, handle_t handle ) const {
+				unsigned __int64 value = 0;
+				if( record.ReadQWORD( handle, &value ) != WBEM_S_NO_ERROR ) {
+					return 0;
 				}
-				*iter++ = func( current_record );
+				return value;
 			}
-		}
 
-		template<typename Enumerator, typename Function>
-		void for_each( Enumerator &&enumerator, Function &&func ) {
-			static_assert(
-			  std::is_invocable_v<Function, CComPtr<IWbemClassObject>>,
-			  "Function must be callable with CComPtr<IWbemClassObject>" );
-
-			while( enumerator ) {
-				CComPtr<IWbemClassObject> current_record;
-				unsigned long record_count = 0;
-				auto const hr =
-				  enumerator->Next( WBEM_INFINITE, 1, &current_record, &record_count );
-				if( record_count == 0 || FAILED( hr ) ) {
-					// We have an error or no more records left
-					break;
+			// A string or datetime property, only valid until the next read on
+			// this thread
+			static std::wstring_view read_text( record_t &record, handle_t handle ) {
+				thread_local auto buffer = std::vector<wchar_t>( 256 );
+				while( true ) {
+					long bytes = 0;
+					auto const hr = record.ReadPropertyValue(
+					  handle, static_cast<long>( buffer.size( ) * sizeof( wchar_t ) ),
+					  &bytes, reinterpret_cast<byte *>( buffer.data( ) ) );
+					if( hr == WBEM_E_BUFFER_TOO_SMALL ) {
+						buffer.resize( std::max( buffer.size( ) * 2,
+						                         static_cast<size_t>( bytes ) /
+						                             sizeof( wchar_t ) + 1 ) );
+						continue;
+					}
+					if( hr != WBEM_S_NO_ERROR ||
+					    bytes < static_cast<long>( sizeof( wchar_t ) ) ) {
+						return {};
+					}
+					// bytes counts the terminating null
+					return std::wstring_view(
+					  buffer.data( ), static_cast<size_t>( bytes ) / sizeof( wchar_t ) - 1 );
 				}
-				func( current_record );
 			}
+
+			void read_string( record_t &record, handle_t handle,
+			                  String &dest ) const {
+				assign_string( dest, read_text( record, handle ) );
+			}
+
+			wxDateTime read_datetime( record_t &record, handle_t handle ) const {
+				auto const str = read_text( record, handle );
+				return parse_cim_datetime( wxString( str.data( ), str.size( ) ) );
+			}
+		};
+
+		// Decodes by property handle when the records expose
+		// IWbemObjectAccess, resolving the handles from the first record.
+		// Otherwise, or when a property cannot be resolved, by name
+		class make_wmi_process {
+			fallback_decoder<handle_access, name_access> m_decode;
+
+		public:
+			explicit make_wmi_process( column_set columns = all_columns( ) )
+			  : m_decode( handle_access{}, name_access{}, columns ) {}
+
+			// Decodes in place, the strings already in item are kept when the
+			// record holds the same value
+			void operator( )( CComPtr<IWbemClassObject> &record,
+			                  wmi_process &item ) const {
+				auto access = CComQIPtr<IWbemObjectAccess>( record );
+				m_decode( record, static_cast<IWbemObjectAccess *>( access ), item );
+			}
+
+			wmi_process operator( )( CComPtr<IWbemClassObject> &record ) const {
+				auto item = wmi_process{};
+				( *this )( record, item );
+				return item;
+			}
+		};
+
+		// Reads every record, then decodes them on up to
+		// opts.decode_threads threads.  Large process lists spend most of their
+		// time converting properties, not waiting on the host
+		template<typename Enumerator>
+		void decode_records( Enumerator &&enumerator,
+		                     wmi_enumerate_options const &opts,
+		                     make_wmi_process const &decode,
+		                     std::vector<wmi_process> &result ) {
+			// Fewer records than this per thread are not worth a thread
+			static constexpr size_t min_records_per_thread = 512;
+
+			auto records = std::vector<CComPtr<IWbemClassObject>>( );
+			for_each_wmi_record( std::forward<Enumerator>( enumerator ), opts,
+			                     [&]( CComPtr<IWbemClassObject> &record ) {
+				                     records.push_back( record );
+			                     } );
+			auto const offset = result.size( );
+			result.resize( offset + records.size( ) );
+			parallel_for(
+			  records.size( ),
+			  [&]( size_t first, size_t last ) {
+				  run_in_mta( [&]( ) {
+					  for( auto n = first; n < last; ++n ) {
+						  decode( records[n], result[offset + n] );
+					  }
+				  } );
+			  },
+			  opts.decode_threads, min_records_per_thread );
 		}
 	} // namespace
 
+	wmi_process decode_wmi_process( CComPtr<IWbemClassObject> &record,
+	                                column_set columns ) {
+		return make_wmi_process{
+		  with_rate_sources( columns | required_columns( ) )}( record );
+	}
+
 	std::vector<wmi_process>
 	get_wmi_win32_process( std::wstring const &machine ) {
-		wmi_state_t wmi_state( COINIT_APARTMENTTHREADED );
-		wmi_state.connect( L"ROOT\\CIMV2", machine );
+		return get_wmi_win32_process( machine, all_columns( ) );
+	}
+
+	std::vector<wmi_process>
+	get_wmi_win32_process( std::wstring const &machine, column_set columns,
+	                       wmi_enumerate_options const &opts ) {
+		columns = with_rate_sources( columns | required_columns( ) );
+		auto const query = make_projected_query( columns, L"Win32_Process" );
+		return with_wmi_service( machine, [&]( wmi_state_t &wmi_state ) {
+			auto result = std::vector<wmi_process>( );
+			decode_records( wmi_state.query( query ), opts, make_wmi_process{columns},
+			                result );
+			return result;
+		} );
+	}
+
+	std::vector<wmi_process>
+	query_wmi_win32_process( wmi_state_t &wmi_state, column_set columns,
+	                         std::vector<uint32_t> const &process_ids,
+	                         wmi_enumerate_options const &opts ) {
+		// Keep the WHERE clauses to a reasonable length
+		static constexpr size_t max_ids_per_query = 100;
 
+		columns = with_rate_sources( columns | required_columns( ) );
 		auto result = std::vector<wmi_process>( );
-		transform( wmi_state.query( L"SELECT * FROM Win32_Process" ),
-		           std::back_inserter( result ), make_wmi_process{} );
+		for( size_t first = 0; first < process_ids.size( );
+		     first += max_ids_per_query ) {
+			auto const last =
+			  std::min( process_ids.size( ), first + max_ids_per_query );
+			auto where_clause = std::wstring( );
+			for( auto n = first; n < last; ++n ) {
+				if( n != first ) {
+					where_clause += L" OR ";
+				}
+				where_clause += L"ProcessId = " + std::to_wstring( process_ids[n] );
+			}
+			decode_records( wmi_state.query( make_projected_query(
+			                  columns, L"Win32_Process", where_clause ) ),
+			                opts, make_wmi_process{columns}, result );
+		}
 		return result;
 	}
 
+	std::vector<wmi_process>
+	get_wmi_win32_process( std::wstring const &machine, column_set columns,
+	                       std::vector<uint32_t> const &process_ids,
+	                       wmi_enumerate_options const &opts ) {
+		return with_wmi_service( machine, [&]( wmi_state_t &wmi_state ) {
+			return query_wmi_win32_process( wmi_state, columns, process_ids, opts );
+		} );
+	}
+
+	void for_each_wmi_win32_process(
+	  std::wstring const &machine, column_set columns,
+	  std::function<void( wmi_process const & )> const &func,
+	  wmi_enumerate_options const &opts ) {
+		columns = with_rate_sources( columns | required_columns( ) );
+		auto const query = make_projected_query( columns, L"Win32_Process" );
+		auto const decode = make_wmi_process{columns};
+		with_wmi_service( machine, [&]( wmi_state_t &wmi_state ) {
+			// Reused for every record, its strings keep their buffers
+			auto row = wmi_process{};
+			for_each_wmi_record( wmi_state.query( query ), opts,
+			                     [&]( CComPtr<IWbemClassObject> &record ) {
+				                     decode( record, row );
+				                     func( row );
+			                     } );
+		} );
+	}
+
+	top_processes get_wmi_win32_process_top( std::wstring const &machine,
+	                                         column_set columns,
+	                                         wmi_process::column_number sort_column,
+	                                         bool is_ascending, size_t count,
+	                                         process_rates *rates,
+	                                         wmi_enumerate_options const &opts ) {
+		columns = with_rate_sources( columns | required_columns( ) |
+		                             sort_key_columns( sort_column ) );
+		auto const query = make_projected_query( columns, L"Win32_Process" );
+		auto const read_key = make_wmi_process{sort_key_columns( sort_column )};
+		auto const decode = make_wmi_process{columns};
+
+		return with_wmi_service( machine, [&]( wmi_state_t &wmi_state ) {
+			auto selector = top_selector( sort_column, is_ascending, count, rates );
+			auto key = wmi_process{};
+			for_each_wmi_record( wmi_state.query( query ), opts,
+			                     [&]( CComPtr<IWbemClassObject> &record ) {
+				                     read_key( record, key );
+				                     if( selector.is_kept( key ) ) {
+					                     selector.keep( decode( record ) );
+				                     }
+			                     } );
+			return std::move( selector ).take( );
+		} );
+	}
+
 	void terminate_process_by_where( std::wstring const &machine,
 	                                 std::wstring const &where_clause ) {
-		wmi_state_t wmi_state( COINIT_APARTMENTTHREADED );
-		wmi_state.connect( L"ROOT\\CIMV2", machine );
-
-		CComPtr<IWbemClassObject> class_object;
-		auto result = wmi_state.service->GetObjectW(
-		  CComBSTR( L"Win32_Process" ), 0, nullptr, &class_object, nullptr );
-		if( FAILED( result ) ) {
-			// TODO
-			return;
-		}
-		CComPtr<IWbemClassObject> in_param_def;
-		CComPtr<IWbemClassObject> out_method;
-		result =
-		  class_object->GetMethod( L"Terminate", 0, &in_param_def, &out_method );
-
-		if( FAILED( result ) ) {
-			// TODO: could not get method
-			return;
-		}
-		CComPtr<IWbemClassObject> class_instance;
-		result = in_param_def->SpawnInstance( 0, &class_instance );
-		if( FAILED( result ) ) {
-			// TODO:
-		}
+		with_wmi_service( machine, [&]( wmi_state_t &wmi_state ) {
+			CComPtr<IWbemClassObject> class_object;
+			auto result = wmi_state.service->GetObjectW(
+			  CComBSTR( L"Win32_Process" ), 0, nullptr, &class_object, nullptr );
+			if( FAILED( result ) ) {
+				throw wmi_error_t{"Could not get Win32_Process class", result};
+			}
+			CComPtr<IWbemClassObject> in_param_def;
+			CComPtr<IWbemClassObject> out_method;
+			result =
+			  class_object->GetMethod( L"Terminate", 0, &in_param_def, &out_method );
 
-		auto var_pid = CComVariant( static_cast<unsigned long>( 1 ) );
-		result = class_instance->Put( L"Reason", 0, &var_pid, 0 );
-		if( FAILED( result ) ) {
-			// TODO:
-		}
+			if( FAILED( result ) ) {
+				throw wmi_error_t{"Could not get Terminate method", result};
+			}
+			CComPtr<IWbemClassObject> class_instance;
+			result = in_param_def->SpawnInstance( 0, &class_instance );
+			if( FAILED( result ) ) {
+				throw wmi_error_t{"Could not create Terminate parameters", result};
+			}
 
-		result = wmi_state.service->ExecMethod(
-		  CComBSTR( where_clause.size( ), where_clause.c_str( ) ),
-		  CComBSTR( L"Terminate" ), 0, nullptr, class_instance, nullptr, nullptr );
-		if( FAILED( result ) ) {
-			// TODO:
-		}
+			auto var_pid = CComVariant( static_cast<unsigned long>( 1 ) );
+			result = class_instance->Put( L"Reason", 0, &var_pid, 0 );
+			if( FAILED( result ) ) {
+				throw wmi_error_t{"Could not set Terminate reason", result};
+			}
+
+			result = wmi_state.service->ExecMethod(
+			  CComBSTR( where_clause.size( ), where_clause.c_str( ) ),
+			  CComBSTR( L"Terminate" ), 0, nullptr, class_instance, nullptr,
+			  nullptr );
+			if( FAILED( result ) ) {
+				throw wmi_error_t{"Could not terminate process", result};
+			}
+		} );
 	}
 
 	void terminate_process_by_pid( std::wstring const &machine, uint32_t pid ) {
@@ -0,0 +1,201 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <atlcomcli.h>
+#include <atomic>
+#include <comdef.h>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <wbemidl.h>
+
+#include "daw/process_events.h"
+#include "daw/wmi_impl.h"
+#include "daw/wmi_process.h"
+
+namespace daw {
+	namespace {
+		// Receives __InstanceCreationEvent/__InstanceDeletionEvent objects on the
+		// WMI callback threads and queues their Win32_Process TargetInstance
+		class process_event_sink : public IWbemObjectSink {
+			std::atomic<ULONG> m_ref_count{0};
+			process_event::kinds m_kind;
+			column_set m_columns;
+			std::shared_ptr<process_event_queue> m_queue;
+
+		public:
+			process_event_sink( process_event::kinds kind, column_set columns,
+			                    std::shared_ptr<process_event_queue> queue )
+			  : m_kind( kind )
+			  , m_columns( columns )
+			  , m_queue( std::move( queue ) ) {}
+
+			virtual ~process_event_sink( ) = default;
+
+			ULONG STDMETHODCALLTYPE AddRef( ) override {
+				return ++m_ref_count;
+			}
+
+			ULONG STDMETHODCALLTYPE Release( ) override {
+				auto const result = --m_ref_count;
+				if( result == 0 ) {
+					delete this;
+				}
+				return result;
+			}
+
+			HRESULT STDMETHODCALLTYPE QueryInterface( REFIID riid,
+			                                          void **ppv ) override {
+				if( riid == IID_IUnknown || riid == IID_IWbemObjectSink ) {
+					*ppv = static_cast<IWbemObjectSink *>( this );
+					AddRef( );
+					return WBEM_S_NO_ERROR;
+				}
+				*ppv = nullptr;
+				return E_NOINTERFACE;
+			}
+
+			HRESULT STDMETHODCALLTYPE Indicate( LONG object_count,
+			                                    IWbemClassObject **objects ) override {
+				for( LONG n = 0; n < object_count; ++n ) {
+					try {
+						CComVariant target;
+						auto const hr =
+						  objects[n]->Get( L"TargetInstance", 0, &target, nullptr, nullptr );
+						if( FAILED( hr ) || target.vt != VT_UNKNOWN ) {
+							continue;
+						}
+						CComQIPtr<IWbemClassObject> instance( target.punkVal );
+						if( !instance ) {
+							continue;
+						}
+						CComPtr<IWbemClassObject> record( instance );
+						m_queue->push(
+						  process_event{m_kind, decode_wmi_process( record, m_columns )} );
+					} catch( ... ) {
+						// The table cannot be kept in sync without this event, have it
+						// rebuilt from a full snapshot
+						m_queue->has_overflowed = true;
+					}
+				}
+				return WBEM_S_NO_ERROR;
+			}
+
+			HRESULT STDMETHODCALLTYPE SetStatus( LONG flags, HRESULT result, BSTR,
+			                                     IWbemClassObject * ) override {
+				if( flags == WBEM_STATUS_COMPLETE ) {
+					// The subscription was cancelled or the connection went away
+					m_queue->is_closed = true;
+				}
+				(void)result;
+				return WBEM_S_NO_ERROR;
+			}
+		};
+
+		void check_hresult( HRESULT hr, char const *msg ) {
+			if( FAILED( hr ) ) {
+				throw wmi_error_t{msg, hr};
+			}
+		}
+
+		class wmi_process_subscription : public process_subscription {
+			std::shared_ptr<wmi_state_t> m_connection;
+			std::vector<CComPtr<IWbemObjectSink>> m_stubs;
+
+			void cancel( ) noexcept {
+				for( auto &stub : m_stubs ) {
+					m_connection->service->CancelAsyncCall( stub );
+				}
+				m_stubs.clear( );
+			}
+
+			void subscribe( process_event::kinds kind, wchar_t const *event_class,
+			                column_set columns,
+			                std::shared_ptr<process_event_queue> queue ) {
+				// The sink is called back from the remote host, the unsecured
+				// apartment lets those calls in without the host being able to
+				// authenticate as us
+				CComPtr<IUnsecuredApartment> unsecured_apartment;
+				check_hresult(
+				  CoCreateInstance( CLSID_UnsecuredApartment, nullptr,
+				                    CLSCTX_LOCAL_SERVER, IID_IUnsecuredApartment,
+				                    reinterpret_cast<void **>( &unsecured_apartment ) ),
+				  "Could not create unsecured apartment" );
+
+				CComPtr<IWbemObjectSink> sink(
+				  new process_event_sink( kind, columns, std::move( queue ) ) );
+				CComPtr<IUnknown> stub_unknown;
+				check_hresult(
+				  unsecured_apartment->CreateObjectStub( sink, &stub_unknown ),
+				  "Could not create event sink stub" );
+				CComPtr<IWbemObjectSink> stub;
+				check_hresult( stub_unknown->QueryInterface(
+				                 IID_IWbemObjectSink, reinterpret_cast<void **>( &stub ) ),
+				               "Could not get event sink" );
+
+				auto const query = std::wstring( L"SELECT * FROM " ) + event_class +
+				                   L" WITHIN 1 WHERE TargetInstance ISA 'Win32_Process'";
+				check_hresult( m_connection->service->ExecNotificationQueryAsync(
+				                 CComBSTR( L"WQL" ), CComBSTR( query.c_str( ) ),
+				                 WBEM_FLAG_SEND_STATUS, nullptr, stub ),
+				               "Could not subscribe to process events" );
+				m_stubs.push_back( std::move( stub ) );
+			}
+
+		public:
+			wmi_process_subscription( std::wstring const &machine, column_set columns,
+			                          std::shared_ptr<process_event_queue> queue ) {
+				run_in_mta( [&]( ) {
+					m_connection = wmi_connections( ).acquire( machine );
+					try {
+						subscribe( process_event::kinds::Started,
+						           L"__InstanceCreationEvent", columns, queue );
+						subscribe( process_event::kinds::Stopped,
+						           L"__InstanceDeletionEvent", columns, queue );
+					} catch( ... ) {
+						cancel( );
+						m_connection.reset( );
+						throw;
+					}
+				} );
+			}
+
+			~wmi_process_subscription( ) override {
+				try {
+					run_in_mta( [&]( ) {
+						cancel( );
+						m_connection.reset( );
+					} );
+				} catch( ... ) {}
+			}
+		};
+	} // namespace
+
+	std::unique_ptr<process_subscription>
+	subscribe_wmi_process_events( std::wstring const &machine,
+	                              column_set columns,
+	                              std::shared_ptr<process_event_queue> queue ) {
+		return std::make_unique<wmi_process_subscription>( machine, columns,
+		                                                   std::move( queue ) );
+	}
+} // namespace daw
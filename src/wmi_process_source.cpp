@@ -0,0 +1,78 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "daw/process_events.h"
+#include "daw/process_source.h"
+#include "daw/wmi_process.h"
+
+namespace daw {
+	namespace {
+		struct wmi_process_source final : process_source {
+			std::vector<wmi_process> get_processes( std::wstring const &host,
+			                                        column_set columns ) override {
+				return get_wmi_win32_process( host, columns );
+			}
+
+			std::vector<wmi_process>
+			get_processes( std::wstring const &host, column_set columns,
+			               std::vector<uint32_t> const &process_ids ) override {
+				return get_wmi_win32_process( host, columns, process_ids );
+			}
+
+			void for_each_process(
+			  std::wstring const &host, column_set columns,
+			  std::function<void( wmi_process const & )> const &func ) override {
+				for_each_wmi_win32_process( host, columns, func );
+			}
+
+			// Only decodes the records that make the cut
+			top_processes get_top_processes( std::wstring const &host,
+			                                 column_set columns,
+			                                 wmi_process::column_number sort_column,
+			                                 bool is_ascending, size_t count,
+			                                 process_rates *rates ) override {
+				return get_wmi_win32_process_top( host, columns, sort_column,
+				                                  is_ascending, count, rates );
+			}
+
+			std::unique_ptr<process_subscription>
+			subscribe_events( std::wstring const &host, column_set columns,
+			                  std::shared_ptr<process_event_queue> queue ) override {
+				return subscribe_wmi_process_events( host, columns, std::move( queue ) );
+			}
+
+			void terminate_process( std::wstring const &host, uint32_t pid ) override {
+				terminate_process_by_pid( host, pid );
+			}
+		};
+	} // namespace
+
+	std::shared_ptr<process_source> make_wmi_process_source( ) {
+		return std::make_shared<wmi_process_source>( );
+	}
+} // namespace daw
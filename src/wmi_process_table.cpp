@@ -24,77 +24,97 @@
 #include <array>
 #include <wx/string.h>
 
+#include "daw/column_items.h"
+#include "daw/process_events.h"
+#include "daw/process_source.h"
+#include "daw/process_store.h"
 #include "daw/wmi_process.h"
 #include "daw/wmi_process_table.h"
+#include "daw/wmi_projection.h"
 
 namespace daw {
-	wmi_process_table::wmi_process_table( wxString remote_host )
+	namespace {
+		using row_id = process_store::row_id;
+
+		void load_rows( process_store &store, std::vector<row_id> &rows,
+		                wmi_process_table::table_data_t const &data ) {
+			rows.reserve( data.size( ) );
+			for( auto const &row : data ) {
+				rows.push_back( store.add( row ) );
+			}
+		}
+	} // namespace
+
+	wmi_process_table::wmi_process_table(
+	  wxString remote_host, std::shared_ptr<process_source> processes )
 	  : m_remote_host( std::move( remote_host ) )
-	  , m_data( std::make_shared<table_data_t>(
-	      get_wmi_win32_process( m_remote_host.ToStdWstring( ) ) ) ) {}
+	  , m_processes( std::move( processes ) )
+	  , m_request{m_remote_host.ToStdWstring( ), {}} {}
 
-	wmi_process_table::wmi_process_table( std::shared_ptr<table_data_t> data )
-	  : m_data( std::move( data ) ) {}
+	wmi_process_table::wmi_process_table(
+	  std::shared_ptr<table_data_t> const &data ) {
+		if( data ) {
+			load_rows( m_store, m_rows, *data );
+		}
+	}
 
-	wmi_process_table::wmi_process_table( table_data_t const &data )
-	  : m_data( std::make_shared<table_data_t>( data ) ) {}
+	wmi_process_table::wmi_process_table( table_data_t const &data ) {
+		load_rows( m_store, m_rows, data );
+	}
 
-	wmi_process_table::wmi_process_table( table_data_t &&data )
-	  : m_data( std::make_shared<table_data_t>( std::move( data ) ) ) {}
+	wmi_process_table::wmi_process_table( table_data_t &&data ) {
+		load_rows( m_store, m_rows, data );
+	}
 
-	int wmi_process_table::GetNumberRows( ) {
-		auto const tmp_data = m_data;
-		if( !tmp_data ) {
-			return 0;
+	wmi_process_table::wmi_process_table( wxString name, source_t source )
+	  : m_remote_host( std::move( name ) )
+	  , m_source( std::move( source ) )
+	  , m_request{m_remote_host.ToStdWstring( ), {}} {
+
+		load_rows( m_store, m_rows, m_source( ) );
+	}
+
+	wmi_process_table::~wmi_process_table( ) {
+		if( m_sort_task.valid( ) ) {
+			m_sort_task.wait( );
 		}
-		return tmp_data->size( );
+	}
+
+	int wmi_process_table::GetNumberRows( ) {
+		return static_cast<int>( m_rows.size( ) );
 	}
 
 	int wmi_process_table::GetNumberCols( ) {
-		auto const tmp_data = m_data;
-		if( !tmp_data ) {
-			return 0;
-		}
-		using tbl_t = std::decay_t<decltype( tmp_data->front( ) )>;
-		return tbl_t::column_names.size( );
+		return static_cast<int>( wmi_process::column_names.size( ) );
 	}
 
 	wxString wmi_process_table::GetValue( int row, int col ) {
-		auto const tmp_data = m_data;
-		if( row < tmp_data->size( ) ) {
-			auto const &record = ( *tmp_data )[row];
-			return record[col].to_string( );
+		if( row < 0 || static_cast<size_t>( row ) >= m_rows.size( ) ) {
+			return wxString{};
+		}
+		auto const id = m_rows[static_cast<size_t>( row )];
+		auto const cn = static_cast<wmi_process::column_number>( col );
+		if( process_store::column_kind( cn ) == process_store::column_kinds::String ) {
+			// Nothing to format, the text is copied out of the string arena
+			return m_store.to_string( id, cn );
 		}
-		return wxString{};
+		// Only formatted when shown, and again only once the value changes
+		return m_render_cache.get(
+		  m_store.key( id ), static_cast<size_t>( col ),
+		  m_store.numeric_value( id, cn ),
+		  [&]( ) { return m_store.to_string( id, cn ); } );
 	}
 
 	wxString wmi_process_table::GetColLabelValue( int col ) {
-		using tbl_t = std::decay_t<decltype( m_data->front( ) )>;
-		return tbl_t::column_names[col];
+		return wmi_process::column_names[col];
 	}
 
-	namespace {
-		void sort_table_on_column( wmi_process_table::table_data_t &tbl, int col,
-		                           wmi_process_table::SortOrder sort_order ) {
-			if( sort_order == wmi_process_table::SortOrder::Ascending ) {
-				std::stable_sort(
-				  tbl.begin( ), tbl.end( ),
-				  [col]( auto &&lhs, auto &&rhs ) { return lhs[col] < rhs[col]; } );
-			} else { // Descending
-				std::stable_sort(
-				  tbl.begin( ), tbl.end( ),
-				  [col]( auto &&lhs, auto &&rhs ) { return lhs[col] > rhs[col]; } );
-			}
-		}
-	} // namespace
-
 	void wmi_process_table::sort_column( int col, SortOrder sort_order ) {
-		auto const tmp_data = m_data;
-		if( !tmp_data ) {
-			return;
-		}
+		// Below this sorting is quick enough for the UI thread
+		static constexpr size_t background_sort_rows = 5000;
+
 		if( sort_order == wmi_process_table::SortOrder::Next ) {
-			switch( sorted.sort_order ) {
+			switch( m_requested_sort.sort_order ) {
 			case wmi_process_table::SortOrder::Ascending:
 				sort_order = wmi_process_table::SortOrder::Descending;
 				break;
@@ -102,21 +122,677 @@ namespace daw {
 				sort_order = wmi_process_table::SortOrder::Ascending;
 				break;
 			}
-			sort_table_on_column( *tmp_data, col, sort_order );
-			sorted.column = col;
-			sorted.sort_order = sort_order;
 		}
+		m_requested_sort.column = col;
+		m_requested_sort.sort_order = sort_order;
+		{
+			std::lock_guard<std::mutex> lck( m_request_mutex );
+			m_request.sort = m_requested_sort;
+		}
+		if( m_is_streaming ) {
+			// apply_update sorts once every row is in
+			m_stream_sort = m_requested_sort;
+			return;
+		}
+		auto const cn = static_cast<wmi_process::column_number>( col );
+		auto const is_ascending =
+		  sort_order == wmi_process_table::SortOrder::Ascending;
+		if( is_sorting( ) ) {
+			// finish_sort starts the latest request
+			m_is_sort_queued = true;
+			return;
+		}
+		if( col == sorted.column ) {
+			// The rows are kept sorted, only the direction can change
+			if( sort_order != sorted.sort_order ) {
+				auto rows = m_rows;
+				std::reverse( rows.begin( ), rows.end( ) );
+				set_rows( std::move( rows ), m_requested_sort );
+			}
+			return;
+		}
+		auto &previous = m_sorted_rows[static_cast<size_t>( col )];
+		if( !previous.empty( ) ) {
+			// Mostly still in order, only the rows that changed are sorted
+			auto rows = resort_rows( m_store, previous, m_rows, cn );
+			if( !is_ascending ) {
+				std::reverse( rows.begin( ), rows.end( ) );
+			}
+			set_rows( std::move( rows ), m_requested_sort );
+			return;
+		}
+		if( !GetView( ) || m_rows.size( ) < background_sort_rows ) {
+			auto rows = m_rows;
+			sort_rows( m_store, rows, cn, is_ascending );
+			set_rows( std::move( rows ), m_requested_sort );
+			return;
+		}
+		start_sort( );
+	}
+
+	void wmi_process_table::set_rows( std::vector<process_store::row_id> &&rows,
+	                                  sorted_t sort_order ) {
+		if( sorted.column >= 0 ) {
+			// Remember the current order for when this column is sorted again
+			auto &previous = m_sorted_rows[static_cast<size_t>( sorted.column )];
+			previous = m_rows;
+			if( sorted.sort_order != wmi_process_table::SortOrder::Ascending ) {
+				std::reverse( previous.begin( ), previous.end( ) );
+			}
+		}
+		m_rows = std::move( rows );
+		sorted = sort_order;
+		++m_rows_version;
+		if( auto grid = GetView( ) ) {
+			// Every row may have moved
+			grid->ForceRefresh( );
+		}
+	}
+
+	bool wmi_process_table::is_sorting( ) const {
+		return m_sort_task.valid( ) &&
+		       m_sort_task.wait_for( std::chrono::seconds( 0 ) ) !=
+		         std::future_status::ready;
+	}
+
+	void wmi_process_table::start_sort( ) {
+		auto const request = m_requested_sort;
+		auto snapshot = make_sort_snapshot(
+		  m_store, m_rows, static_cast<wmi_process::column_number>( request.column ),
+		  request.sort_order == wmi_process_table::SortOrder::Ascending );
+		m_sort_task = std::async(
+		  std::launch::async,
+		  [this, grid = GetView( ), is_alive = std::weak_ptr<bool>( m_is_alive ),
+		   request, rows_version = m_rows_version,
+		   snapshot = std::move( snapshot )]( ) mutable {
+			  auto rows = snapshot.sort( );
+			  {
+				  std::lock_guard<std::mutex> lck( m_sort_mutex );
+				  m_sort_result = sort_result_t{request, rows_version, std::move( rows )};
+			  }
+			  grid->CallAfter( [this, is_alive]( ) {
+				  if( is_alive.lock( ) ) {
+					  finish_sort( );
+				  }
+			  } );
+		  } );
+	}
+
+	void wmi_process_table::finish_sort( ) {
+		auto result = std::optional<sort_result_t>( );
+		{
+			std::lock_guard<std::mutex> lck( m_sort_mutex );
+			result = std::move( m_sort_result );
+			m_sort_result.reset( );
+		}
+		if( !result ) {
+			return;
+		}
+		m_sort_task.wait( );
+		auto rows = std::move( result->rows );
+		if( result->rows_version != m_rows_version ) {
+			// Rows changed while sorting, the result is still mostly in order
+			auto const is_ascending =
+			  result->request.sort_order == wmi_process_table::SortOrder::Ascending;
+			if( !is_ascending ) {
+				std::reverse( rows.begin( ), rows.end( ) );
+			}
+			rows = resort_rows(
+			  m_store, rows, m_rows,
+			  static_cast<wmi_process::column_number>( result->request.column ) );
+			if( !is_ascending ) {
+				std::reverse( rows.begin( ), rows.end( ) );
+			}
+		}
+		set_rows( std::move( rows ), result->request );
+		if( m_is_sort_queued ) {
+			m_is_sort_queued = false;
+			sort_column( m_requested_sort.column, m_requested_sort.sort_order );
+		}
+	}
+
+	bool wmi_process_table::is_column_visible( int col ) const {
+		return m_visible_columns.load( )[static_cast<size_t>( col )];
+	}
+
+	void wmi_process_table::set_column_visible( int col, bool is_visible ) {
+		auto columns = m_visible_columns.load( );
+		columns.set( static_cast<size_t>( col ), is_visible );
+		m_visible_columns = columns;
+		if( is_visible ) {
+			// The existing rows do not have this column yet
+			m_needs_full_refresh = true;
+		}
+	}
+
+	void wmi_process_table::set_row_limit( size_t count ) {
+		if( m_row_limit.exchange( count ) != count ) {
+			// The rows shown no longer match the limit
+			m_needs_full_refresh = true;
+		}
+	}
+
+	size_t wmi_process_table::total_rows( ) const noexcept {
+		if( m_row_limit == 0 ) {
+			return m_rows.size( );
+		}
+		return m_total_rows;
+	}
+
+	std::vector<uint64_t>
+	wmi_process_table::history( int row,
+	                            process_history::series_kinds kind ) const {
+		if( row < 0 || static_cast<size_t>( row ) >= m_rows.size( ) ) {
+			return {};
+		}
+		auto const key = m_store.key( m_rows[static_cast<size_t>( row )] );
+		std::lock_guard<std::mutex> lck( m_history_mutex );
+		return m_history.series( key, kind );
+	}
+
+	process_history::stats_t wmi_process_table::history_stats( ) const {
+		std::lock_guard<std::mutex> lck( m_history_mutex );
+		return m_history.stats( );
+	}
+
+	void wmi_process_table::set_recorder(
+	  std::shared_ptr<snapshot_file::writer> recorder ) {
+		if( recorder ) {
+			// Only a full snapshot can start the recording
+			m_needs_full_refresh = true;
+		}
+		std::lock_guard<std::mutex> lck( m_recorder_mutex );
+		m_recorder = std::move( recorder );
+	}
+
+	bool wmi_process_table::is_recording( ) const {
+		std::lock_guard<std::mutex> lck( m_recorder_mutex );
+		return static_cast<bool>( m_recorder );
+	}
+
+	void wmi_process_table::record( table_data_t const &rows, column_set columns ) {
+		auto recorder = std::shared_ptr<snapshot_file::writer>( );
+		{
+			std::lock_guard<std::mutex> lck( m_recorder_mutex );
+			recorder = m_recorder;
+		}
+		if( !recorder ||
+		    ( recorder->snapshot_count( ) == 0 && columns != all_columns( ) ) ) {
+			return;
+		}
+		try {
+			recorder->append( rows, columns, snapshot_file::clock::now( ) );
+		} catch( std::exception const & ) {
+			std::lock_guard<std::mutex> lck( m_recorder_mutex );
+			if( m_recorder == recorder ) {
+				m_recorder.reset( );
+			}
+		}
+	}
+
+	// The differences between the host's sample times are kept, they do not
+	// include the time spent getting the samples here.  A host clock that
+	// jumps is anchored again
+	process_rates::clock::time_point wmi_process_table::rate_time(
+	  std::optional<process_rates::clock::time_point> sampled ) {
+		auto const now = process_rates::clock::now( );
+		if( !sampled ) {
+			return now;
+		}
+		auto const max_drift = std::chrono::seconds( 1 );
+		if( !m_host_clock_offset ||
+		    *sampled + *m_host_clock_offset > now + max_drift ||
+		    *sampled + *m_host_clock_offset < now - max_drift ) {
+			m_host_clock_offset = now - *sampled;
+		}
+		return *sampled + *m_host_clock_offset;
 	}
 
 	void wmi_process_table::update_data( ) {
-		auto ptr = std::make_shared<table_data_t>(
-		  get_wmi_win32_process( m_remote_host.ToStdWstring( ) ) );
-		sort_table_on_column( *ptr, sorted.column, sorted.sort_order );
-		m_data = std::move( ptr );
+		if( m_source ) {
+			// Already complete, rates included
+			auto pending = pending_t{};
+			pending.data = std::make_unique<table_data_t>( m_source( ) );
+			pending.columns = all_columns( );
+			{
+				std::lock_guard<std::mutex> lck( m_history_mutex );
+				m_history.record( *pending.data, process_history::clock::now( ) );
+			}
+			record( *pending.data, pending.columns );
+			std::lock_guard<std::mutex> lck( m_pending_mutex );
+			m_pending = std::move( pending );
+			return;
+		}
+		auto const request = fetch_request( );
+		auto const &host = request.host;
+		auto const &sort = request.sort;
+		auto const is_first_load = !m_is_loaded.exchange( true );
+		if( m_wants_events.exchange( false ) ) {
+			start_subscription( host );
+		} else if( m_is_event_driven && m_events->is_closed ) {
+			// Back to polling alone
+			m_is_event_driven = false;
+			m_subscription.reset( );
+		}
+		auto columns = m_visible_columns.load( ) | required_columns( );
+		if( sort.column >= 0 ) {
+			// Keep the sort order meaningful when the sort column is hidden
+			columns.set( static_cast<size_t>( sort.column ) );
+		}
+		columns = with_rate_sources( columns );
+		if( auto const limit = m_row_limit.load( ); limit > 0 ) {
+			// Every refresh ranks the whole host again, rows that drop out of
+			// the top are removed by the merge
+			m_needs_full_refresh = false;
+			auto const sort_column =
+			  sort.column >= 0
+			    ? static_cast<wmi_process::column_number>( sort.column )
+			    : wmi_process::column_number::WorkingSetSize;
+			auto top = m_processes->get_top_processes(
+			  host, columns, sort_column,
+			  sort.sort_order == wmi_process_table::SortOrder::Ascending, limit,
+			  &m_rates );
+			m_total_rows = top.total;
+			// The next unlimited refresh has to fetch the fixed columns again
+			m_known_rows.clear( );
+			m_rates.update( top.processes, process_rates::clock::now( ) );
+			{
+				std::lock_guard<std::mutex> lck( m_history_mutex );
+				m_history.record( top.processes, process_history::clock::now( ) );
+			}
+			auto pending = pending_t{};
+			pending.data = std::make_unique<table_data_t>( std::move( top.processes ) );
+			pending.columns = all_columns( );
+			record( *pending.data, pending.columns );
+			std::lock_guard<std::mutex> lck( m_pending_mutex );
+			m_pending = std::move( pending );
+			return;
+		}
+		auto const counters = ( columns & counter_columns( ) ) | required_columns( );
+		auto const is_full_refresh =
+		  m_needs_full_refresh.exchange( false ) ||
+		  ( m_is_event_driven && m_events->has_overflowed.exchange( false ) ) ||
+		  is_first_load;
+
+		auto pending = pending_t{};
+		pending.columns = counters;
+		auto sampled = std::optional<process_rates::clock::time_point>( );
+		if( !is_full_refresh ) {
+			// Fetch the counters for everyone and the fixed columns only for the
+			// processes we have not seen yet.  Also when event driven, the
+			// events are not ordered against this snapshot and only show
+			// starts and stops sooner
+			auto sample = m_processes->get_counters( host, counters );
+			sampled = sample.time;
+			pending.data =
+			  std::make_unique<table_data_t>( std::move( sample.processes ) );
+			auto new_ids = std::vector<uint32_t>( );
+			for( auto const &row : *pending.data ) {
+				if( m_known_rows.count( key_of( row ) ) == 0 ) {
+					new_ids.push_back( row.process_id.value );
+				}
+			}
+			if( new_ids.size( ) * 2 > pending.data->size( ) ) {
+				// Cheaper to fetch everything in one query
+				pending.data.reset( );
+				sampled.reset( );
+			} else if( !new_ids.empty( ) ) {
+				auto fixed = m_processes->get_processes( host, columns, new_ids );
+				auto fixed_index =
+				  std::unordered_map<row_key, size_t, row_key_hash>( fixed.size( ) );
+				for( size_t n = 0; n < fixed.size( ); ++n ) {
+					fixed_index.try_emplace( key_of( fixed[n] ), n );
+				}
+				auto &rows = *pending.data;
+				auto out = rows.begin( );
+				for( auto &row : rows ) {
+					auto const key = key_of( row );
+					if( m_known_rows.count( key ) == 0 ) {
+						auto pos = fixed_index.find( key );
+						if( pos == fixed_index.end( ) ) {
+							// Ended between the two queries
+							continue;
+						}
+						row = std::move( fixed[pos->second] );
+					}
+					if( &*out != &row ) {
+						*out = std::move( row );
+					}
+					++out;
+				}
+				rows.erase( out, rows.end( ) );
+			}
+		}
+		if( !pending.data && is_first_load && m_on_stream ) {
+			// Nothing is shown yet, show the rows as they arrive
+			pending.data =
+			  std::make_unique<table_data_t>( stream_processes( host, columns ) );
+			pending.columns = all_columns( );
+			pending.is_streamed = true;
+		} else if( !pending.data ) {
+			pending.data = std::make_unique<table_data_t>(
+			  m_processes->get_processes( host, columns ) );
+			pending.columns = all_columns( );
+		}
+		m_rates.update( *pending.data, rate_time( sampled ) );
+		{
+			std::lock_guard<std::mutex> lck( m_history_mutex );
+			m_history.record( *pending.data, process_history::clock::now( ) );
+		}
+		m_known_rows.clear( );
+		for( auto const &row : *pending.data ) {
+			m_known_rows.insert( key_of( row ) );
+		}
+		record( *pending.data, pending.columns );
+		std::lock_guard<std::mutex> lck( m_pending_mutex );
+		m_pending = std::move( pending );
+	}
+
+	wmi_process_table::table_data_t
+	wmi_process_table::stream_processes( std::wstring const &host,
+	                                     column_set columns ) {
+		// Small enough that the first rows show quickly, large enough that the
+		// UI thread is not woken for every row
+		static constexpr size_t batch_rows = 256;
+		static constexpr auto batch_interval = std::chrono::milliseconds( 100 );
+		using clock = std::chrono::steady_clock;
+
+		auto const start = clock::now( );
+		{
+			std::lock_guard<std::mutex> lck( m_timing_mutex );
+			m_load_start = start;
+			m_load_timing = load_timing{};
+		}
+		auto result = table_data_t( );
+		auto batch = table_data_t( );
+		auto last_push = start;
+		auto const push = [&]( ) {
+			if( batch.empty( ) || !m_stream.try_push( std::move( batch ) ) ) {
+				// When the UI thread is behind the rows go with the next batch
+				return;
+			}
+			batch = table_data_t( );
+			last_push = clock::now( );
+			m_on_stream( );
+		};
+		m_processes->for_each_process(
+		  host, columns, [&]( wmi_process const &row ) {
+			  if( result.empty( ) ) {
+				  std::lock_guard<std::mutex> lck( m_timing_mutex );
+				  m_load_timing.first_row = clock::now( ) - start;
+			  }
+			  result.push_back( row );
+			  batch.push_back( row );
+			  if( batch.size( ) >= batch_rows ||
+			      clock::now( ) - last_push >= batch_interval ) {
+				  push( );
+			  }
+		  } );
+		push( );
+		return result;
+	}
+
+	namespace {
+		struct grid_notifier {
+			wxGridTableBase *table;
+			wxGrid *grid;
+
+			void send( int id, size_t pos, size_t count ) const {
+				if( !grid ) {
+					return;
+				}
+				wxGridTableMessage msg( table, id, static_cast<int>( pos ),
+				                        static_cast<int>( count ) );
+				grid->ProcessTableMessage( msg );
+			}
+
+			void on_rows_deleted( size_t pos, size_t count ) const {
+				send( wxGRIDTABLE_NOTIFY_ROWS_DELETED, pos, count );
+			}
+
+			void on_rows_inserted( size_t pos, size_t count ) const {
+				send( wxGRIDTABLE_NOTIFY_ROWS_INSERTED, pos, count );
+			}
+
+			void on_cell_changed( size_t row, size_t col ) const {
+				if( !grid || !grid->IsColShown( static_cast<int>( col ) ) ) {
+					return;
+				}
+				auto rect =
+				  grid->CellToRect( static_cast<int>( row ), static_cast<int>( col ) );
+				grid->CalcScrolledPosition( rect.x, rect.y, &rect.x, &rect.y );
+				grid->GetGridWindow( )->RefreshRect( rect );
+			}
+		};
+
+		// Gives the snapshot merge access to the rows in a process_store
+		struct store_rows {
+			process_store &store;
+			wmi_process::column_number sort_column;
+			wmi_process_table::SortOrder sort_order;
+
+			row_key key( row_id id ) const noexcept {
+				return store.key( id );
+			}
+
+			row_key key( wmi_process const &row ) const {
+				return key_of( row );
+			}
+
+			bool is_equal( row_id id, wmi_process const &row, size_t col ) const {
+				return store.is_equal( id, static_cast<wmi_process::column_number>( col ),
+				                       row );
+			}
+
+			void assign( row_id id, wmi_process const &row, uint64_t column_mask ) {
+				for( size_t n = 0; n < wmi_process::column_count; ++n ) {
+					if( column_mask & ( uint64_t{1} << n ) ) {
+						store.assign( id, static_cast<wmi_process::column_number>( n ),
+						              row );
+					}
+				}
+			}
+
+			row_id add( wmi_process const &row ) {
+				return store.add( row );
+			}
+
+			void remove( row_id id ) {
+				store.remove( id );
+			}
+
+			// The same order as sort_rows, equal values are ordered on row id
+			bool less( row_id lhs, row_id rhs ) const {
+				auto result = store.compare( sort_column, lhs, rhs );
+				if( result == 0 ) {
+					result = lhs < rhs ? -1 : ( rhs < lhs ? 1 : 0 );
+				}
+				if( sort_order == wmi_process_table::SortOrder::Ascending ) {
+					return result < 0;
+				}
+				return result > 0;
+			}
+		};
+
+		store_rows make_store_rows( process_store &store, int sort_column,
+		                            wmi_process_table::SortOrder sort_order ) {
+			return {store,
+			        static_cast<wmi_process::column_number>( std::max( sort_column, 0 ) ),
+			        sort_order};
+		}
+
+		// Interned strings of ended processes stay in the arena until it is
+		// rebuilt
+		void compact_if_needed( process_store &store ) {
+			static constexpr size_t strings_per_row = 3;
+			if( store.strings.size( ) > 2 * strings_per_row * store.capacity( ) + 1024 ) {
+				store.compact_strings( );
+			}
+		}
+	} // namespace
+
+	merge_stats wmi_process_table::apply_update( ) {
+		auto pending = pending_t{};
+		{
+			std::lock_guard<std::mutex> lck( m_pending_mutex );
+			pending = std::move( m_pending );
+		}
+		if( !pending.data ) {
+			return {};
+		}
+		// Already in pending.data
+		while( m_stream.try_pop( ) ) {}
+		auto const was_streaming = m_is_streaming;
+		m_is_streaming = false;
+		auto rows = make_store_rows( m_store, sorted.column, sorted.sort_order );
+		auto notifier = grid_notifier{this, GetView( )};
+		auto result = merge_stats{};
+		if( pending.columns == all_columns( ) ) {
+			result = merge_snapshot( m_rows, std::move( *pending.data ),
+			                         wmi_process::column_count, sorted.column, rows,
+			                         notifier );
+		} else {
+			// Existing rows only take the counters, new rows arrive complete
+			auto opts = merge_options{};
+			opts.allow_reset = false;
+			result = merge_rows( m_rows, std::move( *pending.data ),
+			                     pending.columns.to_ullong( ), sorted.column, opts,
+			                     rows, notifier );
+		}
+		if( result.rows_added + result.rows_removed + result.rows_moved > 0 ||
+		    result.is_reset ) {
+			++m_rows_version;
+		}
+		if( was_streaming && m_stream_sort.column >= 0 ) {
+			// The streamed rows were appended as they arrived
+			sort_column( m_stream_sort.column, m_stream_sort.sort_order );
+		}
+		if( pending.is_streamed ) {
+			std::lock_guard<std::mutex> lck( m_timing_mutex );
+			m_load_timing.complete =
+			  std::chrono::steady_clock::now( ) - m_load_start;
+			m_load_timing.rows = m_rows.size( );
+		}
+		if( !is_sorting( ) ) {
+			// A running sort still points into the string arena
+			compact_if_needed( m_store );
+		}
+		return result;
+	}
+
+	void wmi_process_table::set_stream_callback( std::function<void( )> on_stream ) {
+		m_on_stream = std::move( on_stream );
+	}
+
+	size_t wmi_process_table::apply_stream( ) {
+		size_t count = 0;
+		while( auto batch = m_stream.try_pop( ) ) {
+			if( !m_is_streaming ) {
+				// Sorting every batch as it arrives would move the rows around
+				// under the user, the sort is done once the load is complete
+				m_is_streaming = true;
+				m_stream_sort = sorted;
+				sorted.column = -1;
+			}
+			auto const old_size = m_rows.size( );
+			auto opts = merge_options{};
+			opts.remove_missing = false;
+			opts.allow_reset = false;
+			// Without a sort column the new rows are all appended, one
+			// notification covers them
+			auto const result =
+			  merge_rows( m_rows, std::move( *batch ), all_columns( ).to_ullong( ), -1,
+			              opts, make_store_rows( m_store, -1, sorted.sort_order ),
+			              grid_notifier{this, nullptr} );
+			auto const grid = GetView( );
+			if( grid && result.rows_added > 0 ) {
+				grid_notifier{this, grid}.on_rows_inserted( old_size,
+				                                            result.rows_added );
+			}
+			if( grid && result.cells_changed > 0 ) {
+				grid->ForceRefresh( );
+			}
+			count += result.rows_added;
+		}
+		if( count > 0 ) {
+			++m_rows_version;
+			std::lock_guard<std::mutex> lck( m_timing_mutex );
+			if( !m_load_timing.first_paint ) {
+				m_load_timing.first_paint =
+				  std::chrono::steady_clock::now( ) - m_load_start;
+			}
+		}
+		return count;
+	}
+
+	wmi_process_table::load_timing wmi_process_table::last_load_timing( ) const {
+		std::lock_guard<std::mutex> lck( m_timing_mutex );
+		return m_load_timing;
+	}
+
+	void wmi_process_table::subscribe_events( ) {
+		if( !m_events ) {
+			m_events = std::make_shared<process_event_queue>( );
+		}
+		m_wants_events = true;
+	}
+
+	void wmi_process_table::start_subscription( std::wstring const &host ) {
+		try {
+			// Events are rare, fetch everything so that columns can be shown later
+			m_subscription =
+			  m_processes->subscribe_events( host, all_columns( ), m_events );
+		} catch( ... ) {
+			m_subscription.reset( );
+		}
+		m_is_event_driven = static_cast<bool>( m_subscription );
+	}
+
+	size_t wmi_process_table::apply_events( ) {
+		if( !m_events ) {
+			return 0;
+		}
+		auto rows = make_store_rows( m_store, sorted.column, sorted.sort_order );
+		auto notifier = grid_notifier{this, GetView( )};
+		size_t count = 0;
+		while( auto ev = m_events->events.try_pop( ) ) {
+			++count;
+			auto const key = key_of( ev->process );
+			auto const is_known = m_store.find( key ).has_value( );
+			if( ev->kind == process_event::kinds::Stopped ) {
+				if( is_known && erase_row( m_rows, key, rows, notifier ) ) {
+					++m_rows_version;
+				}
+				if( m_total_rows > 0 ) {
+					--m_total_rows;
+				}
+				continue;
+			}
+			++m_total_rows;
+			if( m_row_limit > 0 ) {
+				// Whether it ranks in the top is known on the next refresh
+				continue;
+			}
+			if( !is_known ) {
+				insert_row( m_rows, ev->process, sorted.column, rows, notifier );
+				++m_rows_version;
+			}
+		}
+		return count;
+	}
+
+	wmi_process_table::fetch_request_t wmi_process_table::fetch_request( ) const {
+		std::lock_guard<std::mutex> lck( m_request_mutex );
+		return m_request;
 	}
 
 	void wmi_process_table::change_host( wxString const &remote_host ) {
 		m_remote_host = remote_host;
+		{
+			std::lock_guard<std::mutex> lck( m_request_mutex );
+			m_request.host = m_remote_host.ToStdWstring( );
+		}
 		update_data( );
+		apply_update( );
 	}
 } // namespace daw
@@ -0,0 +1,179 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <wx/string.h>
+
+#include "daw/wmi_process.h"
+#include "daw/wmi_projection.h"
+
+namespace daw {
+	std::array<wxString, wmi_process::column_count> const
+	  wmi_process::column_names = []( ) {
+		std::array<wxString, wmi_process::column_count> result;
+		result[static_cast<size_t>( column_number::Name )] = L"Name";
+		result[static_cast<size_t>( column_number::ProcessId )] = L"Process Id";
+		result[static_cast<size_t>( column_number::ParentProcessId )] =
+		  L"Parent Process Id";
+		result[static_cast<size_t>( column_number::SessionId )] = L"Session Id";
+		result[static_cast<size_t>( column_number::Handle )] = L"Handle";
+		result[static_cast<size_t>( column_number::CreationDate )] =
+		  L"Creation Date";
+		result[static_cast<size_t>( column_number::ThreadCount )] = L"Thread Count";
+		result[static_cast<size_t>( column_number::PageFaults )] = L"Page Faults";
+		result[static_cast<size_t>( column_number::PageFileUsage )] = L"Page File";
+		result[static_cast<size_t>( column_number::PeakPageFileUsage )] =
+		  L"Peak Page File";
+		result[static_cast<size_t>( column_number::WorkingSetSize )] =
+		  L"Working Set";
+		result[static_cast<size_t>( column_number::PeakWorkingSetSize )] =
+		  L"Peak Working Set";
+		result[static_cast<size_t>( column_number::ReadTransferCount )] =
+		  L"Read Transfer";
+		result[static_cast<size_t>( column_number::WriteTransferCount )] =
+		  L"Write Transfer";
+		result[static_cast<size_t>( column_number::CommandLine )] = L"CommandLine";
+		result[static_cast<size_t>( column_number::CpuUsage )] = L"CPU";
+		result[static_cast<size_t>( column_number::ReadRate )] = L"Read/s";
+		result[static_cast<size_t>( column_number::WriteRate )] = L"Write/s";
+		result[static_cast<size_t>( column_number::PageFaultRate )] =
+		  L"Page Faults/s";
+		return result;
+	}( );
+
+	namespace {
+		std::array<wchar_t const *, wmi_process::column_count> const
+		  property_names = []( ) {
+			  using column_number = wmi_process::column_number;
+			  std::array<wchar_t const *, wmi_process::column_count> result{};
+			  result[static_cast<size_t>( column_number::Name )] = L"Name";
+			  result[static_cast<size_t>( column_number::ProcessId )] =
+			    L"ProcessId";
+			  result[static_cast<size_t>( column_number::ParentProcessId )] =
+			    L"ParentProcessId";
+			  result[static_cast<size_t>( column_number::SessionId )] =
+			    L"SessionId";
+			  result[static_cast<size_t>( column_number::Handle )] = L"Handle";
+			  result[static_cast<size_t>( column_number::CreationDate )] =
+			    L"CreationDate";
+			  result[static_cast<size_t>( column_number::ThreadCount )] =
+			    L"ThreadCount";
+			  result[static_cast<size_t>( column_number::PageFaults )] =
+			    L"PageFaults";
+			  result[static_cast<size_t>( column_number::WorkingSetSize )] =
+			    L"WorkingSetSize";
+			  result[static_cast<size_t>( column_number::PeakWorkingSetSize )] =
+			    L"PeakWorkingSetSize";
+			  result[static_cast<size_t>( column_number::PageFileUsage )] =
+			    L"PageFileUsage";
+			  result[static_cast<size_t>( column_number::PeakPageFileUsage )] =
+			    L"PeakPageFileUsage";
+			  result[static_cast<size_t>( column_number::ReadTransferCount )] =
+			    L"ReadTransferCount";
+			  result[static_cast<size_t>( column_number::WriteTransferCount )] =
+			    L"WriteTransferCount";
+			  result[static_cast<size_t>( column_number::CommandLine )] =
+			    L"CommandLine";
+			  // The rate columns are computed from other properties
+			  return result;
+		  }( );
+	} // namespace
+
+	column_set all_columns( ) {
+		return column_set{}.set( );
+	}
+
+	column_set required_columns( ) {
+		// The process id is needed to terminate a process from the grid, and
+		// with the creation date it identifies a row across refreshes
+		return make_column_set( {wmi_process::column_number::ProcessId,
+		                         wmi_process::column_number::CreationDate} );
+	}
+
+	column_set counter_columns( ) {
+		using column_number = wmi_process::column_number;
+		return make_column_set(
+		  {column_number::ThreadCount, column_number::PageFaults,
+		   column_number::WorkingSetSize, column_number::PeakWorkingSetSize,
+		   column_number::PageFileUsage, column_number::PeakPageFileUsage,
+		   column_number::ReadTransferCount, column_number::WriteTransferCount,
+		   column_number::CpuUsage, column_number::ReadRate,
+		   column_number::WriteRate, column_number::PageFaultRate} );
+	}
+
+	column_set with_rate_sources( column_set columns ) {
+		using column_number = wmi_process::column_number;
+		auto const add_source = [&]( column_number rate, column_number source ) {
+			if( columns[static_cast<size_t>( rate )] ) {
+				columns.set( static_cast<size_t>( source ) );
+			}
+		};
+		add_source( column_number::ReadRate, column_number::ReadTransferCount );
+		add_source( column_number::WriteRate, column_number::WriteTransferCount );
+		add_source( column_number::PageFaultRate, column_number::PageFaults );
+		return columns;
+	}
+
+	wchar_t const *property_name( wmi_process::column_number col ) {
+		return property_names[static_cast<size_t>( col )];
+	}
+
+	std::vector<wchar_t const *> projected_properties( column_set columns ) {
+		columns = with_rate_sources( columns | required_columns( ) );
+		auto result = std::vector<wchar_t const *>( );
+		result.reserve( columns.count( ) + 1 );
+		for( size_t n = 0; n < columns.size( ); ++n ) {
+			if( columns[n] && property_names[n] ) {
+				result.push_back( property_names[n] );
+			}
+		}
+		if( columns[static_cast<size_t>( wmi_process::column_number::CpuUsage )] ) {
+			result.push_back( L"KernelModeTime" );
+			result.push_back( L"UserModeTime" );
+		}
+		return result;
+	}
+
+	std::wstring make_projected_query( column_set columns,
+	                                   std::wstring_view class_name,
+	                                   std::wstring_view where_clause ) {
+		auto result = std::wstring( L"SELECT " );
+		bool is_first = true;
+		for( auto prop : projected_properties( columns ) ) {
+			if( !is_first ) {
+				result += L", ";
+			}
+			is_first = false;
+			result += prop;
+		}
+		result += L" FROM ";
+		result += class_name;
+		if( !where_clause.empty( ) ) {
+			result += L" WHERE ";
+			result += where_clause;
+		}
+		return result;
+	}
+} // namespace daw
@@ -0,0 +1,309 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <atlcomcli.h>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <Wbemidl.h>
+
+#include "daw/perf_counters.h"
+#include "daw/process_events.h"
+#include "daw/process_source.h"
+#include "daw/wmi_impl.h"
+#include "daw/wmi_process.h"
+#include "daw/wmi_projection.h"
+#include "daw/wmi_refresher.h"
+
+namespace daw {
+	namespace {
+		// Releases the objects GetObjects handed out
+		struct object_releaser {
+			std::vector<IWbemObjectAccess *> &objects;
+			unsigned long count;
+
+			~object_releaser( ) {
+				for( unsigned long n = 0; n < count; ++n ) {
+					objects[n]->Release( );
+					objects[n] = nullptr;
+				}
+			}
+		};
+
+		// A null or unreadable counter reads as 0
+		template<typename Property>
+		uint64_t read_counter( IWbemObjectAccess &object, Property const &prop ) {
+			if( prop.type == CIM_UINT32 ) {
+				DWORD value = 0;
+				if( object.ReadDWORD( prop.handle, &value ) != WBEM_S_NO_ERROR ) {
+					return 0;
+				}
+				return value;
+			}
+			unsigned __int64 value = 0;
+			if( object.ReadQWORD( prop.handle, &value ) != WBEM_S_NO_ERROR ) {
+				return 0;
+			}
+			return value;
+		}
+
+		// The _Total instance sums every process
+		template<typename Property>
+		bool is_total( IWbemObjectAccess &object, Property const &name ) {
+			static constexpr auto total = std::wstring_view( L"_Total" );
+			wchar_t buff[16]{};
+			long bytes = 0;
+			if( object.ReadPropertyValue( name.handle, sizeof( buff ), &bytes,
+			                              reinterpret_cast<byte *>( buff ) ) !=
+			      WBEM_S_NO_ERROR ||
+			    bytes < static_cast<long>( sizeof( wchar_t ) ) ) {
+				return false;
+			}
+			// bytes counts the terminating null
+			return std::wstring_view( buff, static_cast<size_t>( bytes ) /
+			                                    sizeof( wchar_t ) - 1 ) == total;
+		}
+	} // namespace
+
+	process_refresher::~process_refresher( ) = default;
+
+	bool process_refresher::start( IWbemServices *service ) {
+		if( FAILED( m_refresher.CoCreateInstance( CLSID_WbemRefresher, nullptr,
+		                                          CLSCTX_INPROC_SERVER ) ) ) {
+			return false;
+		}
+		auto config = CComQIPtr<IWbemConfigureRefresher>( m_refresher );
+		long id = 0;
+		return config &&
+		       SUCCEEDED( config->AddEnum( service,
+		                                   L"Win32_PerfRawData_PerfProc_Process",
+		                                   0, nullptr, &m_enum, &id ) );
+	}
+
+	std::optional<raw_counter_sample> process_refresher::sample( ) {
+		auto hr = m_refresher->Refresh( 0L );
+		if( FAILED( hr ) ) {
+			throw wmi_error_t{"Could not refresh the process counters", hr};
+		}
+		unsigned long count = 0;
+		hr = m_enum->GetObjects( 0L, static_cast<unsigned long>( m_objects.size( ) ),
+		                         m_objects.data( ), &count );
+		if( hr == WBEM_E_BUFFER_TOO_SMALL ) {
+			// Leave room for a few more processes, so the next sample fits
+			m_objects.resize( count + count / 8 );
+			hr = m_enum->GetObjects( 0L,
+			                         static_cast<unsigned long>( m_objects.size( ) ),
+			                         m_objects.data( ), &count );
+		}
+		if( FAILED( hr ) ) {
+			throw wmi_error_t{"Could not read the process counters", hr};
+		}
+		auto const releaser = object_releaser{m_objects, count};
+		auto result = raw_counter_sample{};
+		if( count == 0 ) {
+			return result;
+		}
+		if( !m_handles ) {
+			// The same for every instance of the class
+			auto &object = *m_objects[0];
+			auto handles = handles_t{};
+			auto const resolve = [&]( wchar_t const *name, property_t &prop ) {
+				return SUCCEEDED(
+				  object.GetPropertyHandle( name, &prop.type, &prop.handle ) );
+			};
+			auto const is_resolved =
+			  resolve( L"Name", handles.name ) &&
+			  resolve( L"IDProcess", handles.process_id ) &&
+			  resolve( L"ElapsedTime", handles.start_time ) &&
+			  resolve( L"PercentProcessorTime", handles.processor_time ) &&
+			  resolve( L"IOReadBytesPerSec", handles.io_read_bytes ) &&
+			  resolve( L"IOWriteBytesPerSec", handles.io_write_bytes ) &&
+			  resolve( L"PageFaultsPerSec", handles.page_faults ) &&
+			  resolve( L"ThreadCount", handles.thread_count ) &&
+			  resolve( L"WorkingSet", handles.working_set ) &&
+			  resolve( L"WorkingSetPeak", handles.working_set_peak ) &&
+			  resolve( L"PrivateBytes", handles.private_bytes ) &&
+			  resolve( L"PageFileBytesPeak", handles.page_file_bytes_peak ) &&
+			  resolve( L"Timestamp_Sys100NS", handles.timestamp );
+			if( !is_resolved ) {
+				return std::nullopt;
+			}
+			m_handles = handles;
+		}
+		auto const &h = *m_handles;
+		result.timestamp = read_counter( *m_objects[0], h.timestamp );
+		result.processes.reserve( count );
+		for( unsigned long n = 0; n < count; ++n ) {
+			auto &object = *m_objects[n];
+			if( is_total( object, h.name ) ) {
+				continue;
+			}
+			auto &raw = result.processes.emplace_back( );
+			raw.process_id =
+			  static_cast<uint32_t>( read_counter( object, h.process_id ) );
+			raw.start_time = read_counter( object, h.start_time );
+			raw.processor_time = read_counter( object, h.processor_time );
+			raw.io_read_bytes = read_counter( object, h.io_read_bytes );
+			raw.io_write_bytes = read_counter( object, h.io_write_bytes );
+			raw.page_faults =
+			  static_cast<uint32_t>( read_counter( object, h.page_faults ) );
+			raw.thread_count =
+			  static_cast<uint32_t>( read_counter( object, h.thread_count ) );
+			raw.working_set = read_counter( object, h.working_set );
+			raw.working_set_peak = read_counter( object, h.working_set_peak );
+			raw.private_bytes = read_counter( object, h.private_bytes );
+			raw.page_file_bytes_peak = read_counter( object, h.page_file_bytes_peak );
+		}
+		return result;
+	}
+
+	std::optional<counter_sample>
+	process_refresher::refresh( wmi_state_t &wmi_state ) {
+		std::lock_guard<std::mutex> lck( m_mutex );
+		if( m_state == states::New ) {
+			m_state = start( wmi_state.service ) ? states::Ready : states::Unavailable;
+		}
+		if( m_state == states::Unavailable ) {
+			return std::nullopt;
+		}
+		auto const sampled = sample( );
+		if( !sampled ) {
+			// Not the counters expected, e.g. an older host
+			m_state = states::Unavailable;
+			return std::nullopt;
+		}
+		auto const &raw = *sampled;
+
+		// New processes, and reused process ids, take their identity from
+		// Win32_Process
+		auto start_times = std::unordered_map<uint32_t, uint64_t>( );
+		for( auto const &process : raw.processes ) {
+			auto pos = m_identities.find( process.process_id );
+			if( pos == m_identities.end( ) ||
+			    pos->second.start_time != process.start_time ) {
+				start_times[process.process_id] = process.start_time;
+			}
+		}
+		if( !start_times.empty( ) ) {
+			auto ids = std::vector<uint32_t>( );
+			ids.reserve( start_times.size( ) );
+			for( auto const &item : start_times ) {
+				ids.push_back( item.first );
+			}
+			for( auto const &row :
+			     query_wmi_win32_process( wmi_state, required_columns( ), ids ) ) {
+				auto const id = row.process_id.value;
+				m_identities[id] = identity_t{start_times[id], row.creation_date.value};
+			}
+		}
+
+		auto identities = std::unordered_map<uint32_t, identity_t>( );
+		identities.reserve( raw.processes.size( ) );
+		auto result = std::vector<wmi_process>( );
+		result.reserve( raw.processes.size( ) );
+		for( auto const &process : raw.processes ) {
+			auto pos = m_identities.find( process.process_id );
+			if( pos == m_identities.end( ) ||
+			    pos->second.start_time != process.start_time ) {
+				// Ended before Win32_Process was asked about it
+				continue;
+			}
+			auto &row = result.emplace_back( );
+			apply_raw_counters( process, row );
+			row.creation_date = pos->second.creation_date;
+			identities.insert( *pos );
+		}
+		// Forget the processes that ended
+		m_identities = std::move( identities );
+		return counter_sample{std::move( result ), sample_time( raw )};
+	}
+
+	namespace {
+		// Win32_Process, except for refreshes of only the counter columns.
+		// Those come from the process_refresher of the host's connection
+		struct wmi_refresher_process_source final : process_source {
+			std::shared_ptr<process_source> m_wmi = make_wmi_process_source( );
+
+			std::vector<wmi_process> get_processes( std::wstring const &host,
+			                                        column_set columns ) override {
+				return get_counters( host, columns ).processes;
+			}
+
+			counter_sample get_counters( std::wstring const &host,
+			                             column_set columns ) override {
+				if( ( columns & ~( raw_counter_columns( ) | required_columns( ) ) )
+				      .none( ) ) {
+					auto sample =
+					  with_wmi_service( host, [&]( wmi_state_t &wmi_state ) {
+						  return wmi_state.process_counters->refresh( wmi_state );
+					  } );
+					if( sample ) {
+						return std::move( *sample );
+					}
+				}
+				return counter_sample{m_wmi->get_processes( host, columns ),
+				                      std::nullopt};
+			}
+
+			std::vector<wmi_process>
+			get_processes( std::wstring const &host, column_set columns,
+			               std::vector<uint32_t> const &process_ids ) override {
+				return m_wmi->get_processes( host, columns, process_ids );
+			}
+
+			void for_each_process(
+			  std::wstring const &host, column_set columns,
+			  std::function<void( wmi_process const & )> const &func ) override {
+				m_wmi->for_each_process( host, columns, func );
+			}
+
+			top_processes get_top_processes( std::wstring const &host,
+			                                 column_set columns,
+			                                 wmi_process::column_number sort_column,
+			                                 bool is_ascending, size_t count,
+			                                 process_rates *rates ) override {
+				return m_wmi->get_top_processes( host, columns, sort_column,
+				                                 is_ascending, count, rates );
+			}
+
+			std::unique_ptr<process_subscription>
+			subscribe_events( std::wstring const &host, column_set columns,
+			                  std::shared_ptr<process_event_queue> queue ) override {
+				return m_wmi->subscribe_events( host, columns, std::move( queue ) );
+			}
+
+			void terminate_process( std::wstring const &host, uint32_t pid ) override {
+				m_wmi->terminate_process( host, pid );
+			}
+		};
+	} // namespace
+
+	std::shared_ptr<process_source> make_wmi_refresher_process_source( ) {
+		return std::make_shared<wmi_refresher_process_source>( );
+	}
+} // namespace daw
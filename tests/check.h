@@ -0,0 +1,54 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+
+namespace daw {
+	namespace test {
+		inline int &failure_count( ) {
+			static int count = 0;
+			return count;
+		}
+
+		inline void check( bool is_ok, char const *expression, char const *file,
+		                   int line ) {
+			if( !is_ok ) {
+				++failure_count( );
+				std::cerr << file << ':' << line << ": check failed: " << expression
+				          << '\n';
+			}
+		}
+
+		// The exit code of a test, fails when a check did
+		inline int result( ) {
+			return failure_count( ) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	} // namespace test
+} // namespace daw
+
+// Reports a false expression and carries on with the test
+#define DAW_CHECK( ... )                                                        \
+	::daw::test::check( static_cast<bool>( __VA_ARGS__ ), #__VA_ARGS__,           \
+	                    __FILE__, __LINE__ )
@@ -0,0 +1,195 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <wx/datetime.h>
+#include <wx/string.h>
+
+#include "check.h"
+#include "daw/column_items.h"
+
+namespace {
+	// The formatters format_memory and format_integer replaced, their output
+	// is the reference
+	std::wstring old_2digit_dec( double value ) {
+		std::wstringstream ss;
+		ss << std::fixed << std::setprecision( 2 ) << value;
+		auto result = ss.str( );
+		if( result.find_first_of( L'.' ) != std::wstring::npos ) {
+			while( result.back( ) == L'0' ) {
+				result.resize( result.size( ) - 1 );
+			}
+		}
+		if( result.back( ) == L'.' ) {
+			result.resize( result.size( ) - 1 );
+		}
+		return result;
+	}
+
+	std::wstring old_memory( uint64_t value ) {
+		if( value < 1024ULL ) {
+			return std::to_wstring( value ) + L"B";
+		}
+		auto val = static_cast<double>( value ) / 1024.0;
+		if( val < 1024.0 ) {
+			return std::to_wstring( lround( val ) ) + L"KB";
+		}
+		for( auto unit : {L"MB", L"GB", L"TB", L"PB"} ) {
+			val /= 1024.0;
+			if( val < 1024.0 ) {
+				return old_2digit_dec( val ) + unit;
+			}
+		}
+		val /= 1024.0;
+		return old_2digit_dec( val ) + L"EB";
+	}
+
+	std::wstring format_memory( uint64_t value ) {
+		auto buff = daw::format_buffer{};
+		return std::wstring( daw::format_memory( value, buff ) );
+	}
+
+	std::wstring format_integer( uint64_t value ) {
+		auto buff = daw::format_buffer{};
+		return std::wstring( daw::format_integer( value, buff ) );
+	}
+
+	std::wstring format_percent( uint64_t value ) {
+		auto buff = daw::format_buffer{};
+		return std::wstring( daw::format_percent( value, buff ) );
+	}
+
+	// Below, at and above each unit, and the values that round up to the
+	// next one
+	std::vector<uint64_t> boundaries( ) {
+		auto result = std::vector<uint64_t>{0, 1, 9, 10, 999, 1'000, 1'023, 1'024, 1'025};
+		for( unsigned shift = 10; shift < 64; shift += 10 ) {
+			auto const unit = uint64_t{1} << shift;
+			for( auto value : {unit - 1, unit, unit + 1, unit + unit / 200,
+			                   unit + unit / 200 + 1} ) {
+				result.push_back( value );
+			}
+			if( shift + 10 < 64 ) {
+				for( auto value : {unit * 1'023, unit * 1'024 - 1} ) {
+					result.push_back( value );
+				}
+			}
+		}
+		// Where doubles stop being exact
+		for( auto value : {uint64_t{1} << 53U, ( uint64_t{1} << 53U ) + 1} ) {
+			result.push_back( value );
+		}
+		result.push_back( std::numeric_limits<uint64_t>::max( ) - 1 );
+		result.push_back( std::numeric_limits<uint64_t>::max( ) );
+		return result;
+	}
+
+	// Every magnitude, from a fixed seed
+	std::vector<uint64_t> random_values( ) {
+		auto rng = std::mt19937_64( 9 );
+		auto result = std::vector<uint64_t>( );
+		for( unsigned shift = 0; shift < 64; ++shift ) {
+			for( size_t n = 0; n < 2'000; ++n ) {
+				result.push_back( rng( ) >> shift );
+			}
+		}
+		return result;
+	}
+
+	void formats_memory_like_before( ) {
+		for( auto value : boundaries( ) ) {
+			DAW_CHECK( format_memory( value ) == old_memory( value ) );
+		}
+		for( auto value : random_values( ) ) {
+			DAW_CHECK( format_memory( value ) == old_memory( value ) );
+		}
+		for( uint64_t value = 0; value < 1U << 16U; ++value ) {
+			DAW_CHECK( format_memory( value ) == old_memory( value ) );
+		}
+		DAW_CHECK( format_memory( 1'023 ) == L"1023B" );
+		DAW_CHECK( format_memory( 1'024 ) == L"1KB" );
+		DAW_CHECK( format_memory( 1'536 * 1'024 ) == L"1.5MB" );
+		DAW_CHECK( format_memory( std::numeric_limits<uint64_t>::max( ) ) == L"16EB" );
+		DAW_CHECK( daw::memory_value_to_wstring( 1'024 ).ToStdWstring( ) == L"1KB" );
+	}
+
+	void formats_integers_like_before( ) {
+		for( auto value : boundaries( ) ) {
+			DAW_CHECK( format_integer( value ) == std::to_wstring( value ) );
+		}
+		for( auto value : random_values( ) ) {
+			DAW_CHECK( format_integer( value ) == std::to_wstring( value ) );
+		}
+		auto const column = daw::Integer<uint32_t>( 4'294'967'295U );
+		DAW_CHECK( column.to_string( ).ToStdWstring( ) == L"4294967295" );
+	}
+
+	void formats_percents( ) {
+		DAW_CHECK( format_percent( 0 ) == L"0.00%" );
+		DAW_CHECK( format_percent( 5 ) == L"0.05%" );
+		DAW_CHECK( format_percent( 1'234 ) == L"12.34%" );
+		DAW_CHECK( format_percent( 20'000 ) == L"200.00%" );
+		DAW_CHECK( format_percent( std::numeric_limits<uint64_t>::max( ) ) ==
+		           L"184467440737095516.15%" );
+	}
+
+	// The fast path writes what wxDateTime::Format does
+	void formats_dates_like_wx( ) {
+		using date_formats = daw::Date::date_formats;
+		auto rng = std::mt19937_64( 11 );
+		// 1970 to 2100, in ms
+		auto dist = std::uniform_int_distribution<long long>( 0, 4'102'444'800'000LL );
+		for( size_t n = 0; n < 2'000; ++n ) {
+			auto const value = wxDateTime( wxLongLong( dist( rng ) ) );
+			auto buff = daw::format_buffer{};
+			DAW_CHECK( std::wstring( daw::format_date( date_formats::Combined, value,
+			                                           buff ) ) ==
+			           value.Format( L"%Y-%m-%d %H:%M" ).ToStdWstring( ) );
+			DAW_CHECK( std::wstring( daw::format_date( date_formats::DateOnly, value,
+			                                           buff ) ) ==
+			           value.FormatISODate( ).ToStdWstring( ) );
+			DAW_CHECK( daw::to_date_string( date_formats::Combined, value ) ==
+			           value.Format( L"%Y-%m-%d %H:%M" ) );
+		}
+		// Left to wxDateTime
+		auto buff = daw::format_buffer{};
+		auto const now = wxDateTime( wxLongLong( 1'600'000'000'000LL ) );
+		DAW_CHECK( daw::format_date( date_formats::TimeOnly, now, buff ).empty( ) );
+		DAW_CHECK( daw::format_date( date_formats::Combined, wxDateTime( ), buff )
+		             .empty( ) );
+	}
+} // namespace
+
+int main( ) {
+	formats_memory_like_before( );
+	formats_integers_like_before( );
+	formats_percents( );
+	formats_dates_like_wx( );
+	return daw::test::result( );
+}
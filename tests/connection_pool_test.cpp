@@ -0,0 +1,121 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "check.h"
+#include "daw/connection_pool.h"
+
+namespace {
+	struct fake_connection {
+		int id = 0;
+	};
+
+	struct connection_lost : std::runtime_error {
+		connection_lost( )
+		  : std::runtime_error( "connection lost" ) {}
+	};
+
+	// Numbers the connections it makes
+	struct fake_backend : daw::connection_backend<fake_connection> {
+		int *m_connect_count;
+
+		explicit fake_backend( int *connect_count )
+		  : m_connect_count( connect_count ) {}
+
+		std::shared_ptr<fake_connection> connect( std::wstring const & ) override {
+			return std::make_shared<fake_connection>( fake_connection{++*m_connect_count} );
+		}
+
+		bool is_connection_lost( std::exception const &ex ) const override {
+			return dynamic_cast<connection_lost const *>( &ex ) != nullptr;
+		}
+	};
+
+	int connection_id( fake_connection &conn ) {
+		return conn.id;
+	}
+
+	void reuses_connection( ) {
+		auto connect_count = 0;
+		auto pool = daw::connection_pool<fake_connection>(
+		  std::make_unique<fake_backend>( &connect_count ) );
+		DAW_CHECK( pool.with_connection( L"a", connection_id ) == 1 );
+		DAW_CHECK( pool.with_connection( L"a", connection_id ) == 1 );
+		DAW_CHECK( pool.with_connection( L"b", connection_id ) == 2 );
+		DAW_CHECK( pool.size( ) == 2 );
+		DAW_CHECK( connect_count == 2 );
+	}
+
+	void reconnects_once_when_lost( ) {
+		auto connect_count = 0;
+		auto pool = daw::connection_pool<fake_connection>(
+		  std::make_unique<fake_backend>( &connect_count ) );
+		pool.with_connection( L"a", connection_id );
+		auto call_count = 0;
+		auto const id = pool.with_connection( L"a", [&]( fake_connection &conn ) {
+			if( ++call_count == 1 ) {
+				throw connection_lost( );
+			}
+			return conn.id;
+		} );
+		DAW_CHECK( id == 2 );
+		DAW_CHECK( call_count == 2 );
+		// The new connection is the one kept
+		DAW_CHECK( pool.with_connection( L"a", connection_id ) == 2 );
+
+		// Lost again on the retry, the error reaches the caller
+		auto is_thrown = false;
+		try {
+			pool.with_connection( L"a", []( fake_connection & ) -> int {
+				throw connection_lost( );
+			} );
+		} catch( connection_lost const & ) { is_thrown = true; }
+		DAW_CHECK( is_thrown );
+		DAW_CHECK( connect_count == 3 );
+	}
+
+	void keeps_connection_on_other_errors( ) {
+		auto connect_count = 0;
+		auto pool = daw::connection_pool<fake_connection>(
+		  std::make_unique<fake_backend>( &connect_count ) );
+		auto is_thrown = false;
+		try {
+			pool.with_connection( L"a", []( fake_connection & ) -> int {
+				throw std::logic_error( "query error" );
+			} );
+		} catch( std::logic_error const & ) { is_thrown = true; }
+		DAW_CHECK( is_thrown );
+		DAW_CHECK( pool.with_connection( L"a", connection_id ) == 1 );
+		DAW_CHECK( connect_count == 1 );
+	}
+} // namespace
+
+int main( ) {
+	reuses_connection( );
+	reconnects_once_when_lost( );
+	keeps_connection_on_other_errors( );
+	return daw::test::result( );
+}
@@ -0,0 +1,197 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "daw/process_events.h"
+#include "daw/process_source.h"
+#include "daw/wmi_process.h"
+
+namespace daw {
+	namespace test {
+		// A process_source that serves the same processes for every host.  A
+		// host's calls take its latency and can be made to fail, and the calls
+		// running at once are counted.  Subscribing to events hands out a queue
+		// the test pushes its own events to
+		class fake_process_source final : public process_source {
+			struct host_t {
+				std::chrono::milliseconds latency{0};
+				bool is_failing = false;
+				size_t call_count = 0;
+				size_t counter_call_count = 0;
+				size_t running = 0;
+				size_t max_running = 0;
+			};
+
+			mutable std::mutex m_mutex;
+			std::vector<wmi_process> m_processes;
+			std::unordered_map<std::wstring, host_t> m_hosts;
+			size_t m_running = 0;
+			size_t m_max_running = 0;
+			std::shared_ptr<process_event_queue> m_events;
+
+			// Counts the call for as long as it takes
+			std::vector<wmi_process> call( std::wstring const &host ) {
+				auto latency = std::chrono::milliseconds( 0 );
+				auto is_failing = false;
+				{
+					std::lock_guard<std::mutex> lck( m_mutex );
+					auto &h = m_hosts[host];
+					++h.call_count;
+					h.max_running = std::max( h.max_running, ++h.running );
+					m_max_running = std::max( m_max_running, ++m_running );
+					latency = h.latency;
+					is_failing = h.is_failing;
+				}
+				std::this_thread::sleep_for( latency );
+				std::lock_guard<std::mutex> lck( m_mutex );
+				--m_hosts[host].running;
+				--m_running;
+				if( is_failing ) {
+					throw std::runtime_error( "host is not reachable" );
+				}
+				return m_processes;
+			}
+
+		public:
+			explicit fake_process_source( std::vector<wmi_process> processes = {} )
+			  : m_processes( std::move( processes ) ) {}
+
+			void set_processes( std::vector<wmi_process> processes ) {
+				std::lock_guard<std::mutex> lck( m_mutex );
+				m_processes = std::move( processes );
+			}
+
+			void set_latency( std::wstring const &host,
+			                  std::chrono::milliseconds latency ) {
+				std::lock_guard<std::mutex> lck( m_mutex );
+				m_hosts[host].latency = latency;
+			}
+
+			void set_failing( std::wstring const &host, bool is_failing ) {
+				std::lock_guard<std::mutex> lck( m_mutex );
+				m_hosts[host].is_failing = is_failing;
+			}
+
+			size_t call_count( std::wstring const &host ) const {
+				std::lock_guard<std::mutex> lck( m_mutex );
+				auto pos = m_hosts.find( host );
+				return pos == m_hosts.end( ) ? 0 : pos->second.call_count;
+			}
+
+			// The calls for host that only asked for the counter columns
+			size_t counter_call_count( std::wstring const &host ) const {
+				std::lock_guard<std::mutex> lck( m_mutex );
+				auto pos = m_hosts.find( host );
+				return pos == m_hosts.end( ) ? 0 : pos->second.counter_call_count;
+			}
+
+			// The queue of the last subscription, null before the first one
+			std::shared_ptr<process_event_queue> events( ) const {
+				std::lock_guard<std::mutex> lck( m_mutex );
+				return m_events;
+			}
+
+			// The most calls for host that ran at the same time
+			size_t max_running( std::wstring const &host ) const {
+				std::lock_guard<std::mutex> lck( m_mutex );
+				auto pos = m_hosts.find( host );
+				return pos == m_hosts.end( ) ? 0 : pos->second.max_running;
+			}
+
+			// The most calls, across every host, that ran at the same time
+			size_t max_running( ) const {
+				std::lock_guard<std::mutex> lck( m_mutex );
+				return m_max_running;
+			}
+
+			std::vector<wmi_process> get_processes( std::wstring const &host,
+			                                        column_set ) override {
+				return call( host );
+			}
+
+			std::vector<wmi_process>
+			get_processes( std::wstring const &host, column_set,
+			               std::vector<uint32_t> const &process_ids ) override {
+				auto result = call( host );
+				result.erase(
+				  std::remove_if( result.begin( ), result.end( ),
+				                  [&]( wmi_process const &row ) {
+					                  return std::find( process_ids.begin( ),
+					                                    process_ids.end( ),
+					                                    row.process_id.value ) ==
+					                         process_ids.end( );
+				                  } ),
+				  result.end( ) );
+				return result;
+			}
+
+			counter_sample get_counters( std::wstring const &host,
+			                             column_set ) override {
+				{
+					std::lock_guard<std::mutex> lck( m_mutex );
+					++m_hosts[host].counter_call_count;
+				}
+				return counter_sample{call( host ), std::nullopt};
+			}
+
+			void for_each_process(
+			  std::wstring const &host, column_set,
+			  std::function<void( wmi_process const & )> const &func ) override {
+				for( auto const &row : call( host ) ) {
+					func( row );
+				}
+			}
+
+			std::unique_ptr<process_subscription>
+			subscribe_events( std::wstring const &, column_set,
+			                  std::shared_ptr<process_event_queue> queue ) override {
+				std::lock_guard<std::mutex> lck( m_mutex );
+				m_events = std::move( queue );
+				return std::make_unique<process_subscription>( );
+			}
+
+			void terminate_process( std::wstring const &, uint32_t pid ) override {
+				std::lock_guard<std::mutex> lck( m_mutex );
+				m_processes.erase(
+				  std::remove_if( m_processes.begin( ), m_processes.end( ),
+				                  [pid]( wmi_process const &row ) {
+					                  return row.process_id.value == pid;
+				                  } ),
+				  m_processes.end( ) );
+			}
+		};
+	} // namespace test
+} // namespace daw
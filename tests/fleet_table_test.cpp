@@ -0,0 +1,246 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <wx/datetime.h>
+
+#include "check.h"
+#include "daw/fleet_table.h"
+#include "daw/wmi_process.h"
+#include "daw/wmi_process_table.h"
+#include "fake_process_source.h"
+
+namespace {
+	using column_number = daw::wmi_process::column_number;
+	using SortOrder = daw::fleet_table::SortOrder;
+
+	auto const working_set_column =
+	  1 + static_cast<int>( column_number::WorkingSetSize );
+
+	daw::wmi_process make_process( uint32_t pid, uint64_t working_set ) {
+		auto result = daw::wmi_process{};
+		result.process_id = pid;
+		result.creation_date = wxDateTime( wxLongLong( 1'000 + pid ) );
+		result.working_set_size = working_set;
+		return result;
+	}
+
+	// A host with a source of its own
+	struct host_t {
+		std::shared_ptr<daw::test::fake_process_source> source =
+		  std::make_shared<daw::test::fake_process_source>( );
+		std::unique_ptr<daw::wmi_process_table> table;
+
+		explicit host_t( std::wstring const &name )
+		  : table( std::make_unique<daw::wmi_process_table>( name, source ) ) {}
+
+		void load( std::vector<daw::wmi_process> processes ) {
+			source->set_processes( std::move( processes ) );
+			table->update_data( );
+			table->apply_update( );
+		}
+	};
+
+	// Host and process id of each row shown
+	std::vector<std::wstring> shown( daw::fleet_table &fleet ) {
+		auto const pid_column = 1 + static_cast<int>( column_number::ProcessId );
+		auto result = std::vector<std::wstring>( );
+		for( int row = 0; row < fleet.GetNumberRows( ); ++row ) {
+			result.push_back( fleet.GetValue( row, daw::fleet_table::host_column ) +
+			                  L":" + fleet.GetValue( row, pid_column ) );
+		}
+		return result;
+	}
+
+	// The fleet order of hosts on the working set, sorted as a whole
+	std::vector<std::wstring> expected( std::vector<host_t const *> const &hosts,
+	                                    SortOrder sort_order, size_t limit = 0 ) {
+		struct row_t {
+			size_t host;
+			daw::process_store::row_id id;
+			uint64_t working_set;
+			std::wstring value;
+		};
+		auto rows = std::vector<row_t>( );
+		for( size_t n = 0; n < hosts.size( ); ++n ) {
+			auto const &table = *hosts[n]->table;
+			for( auto id : table.rows( ) ) {
+				rows.push_back(
+				  row_t{n, id, table.store( ).working_set_size[id],
+				        table.host( ) + L":" +
+				          std::to_wstring( table.store( ).process_id[id] )} );
+			}
+		}
+		std::sort( rows.begin( ), rows.end( ), []( row_t const &l, row_t const &r ) {
+			if( l.working_set != r.working_set ) {
+				return l.working_set < r.working_set;
+			}
+			if( l.host != r.host ) {
+				return l.host < r.host;
+			}
+			return l.id < r.id;
+		} );
+		if( sort_order == SortOrder::Descending ) {
+			std::reverse( rows.begin( ), rows.end( ) );
+		}
+		if( limit > 0 && rows.size( ) > limit ) {
+			rows.resize( limit );
+		}
+		auto result = std::vector<std::wstring>( );
+		for( auto const &row : rows ) {
+			result.push_back( row.value );
+		}
+		return result;
+	}
+
+	void merges_in_both_orders( ) {
+		auto a = host_t( L"a" );
+		auto b = host_t( L"b" );
+		auto c = host_t( L"c" );
+		// Ties within and across hosts
+		a.load( {make_process( 1, 50 ), make_process( 2, 10 ), make_process( 3, 30 )} );
+		b.load( {make_process( 4, 30 ), make_process( 5, 50 ), make_process( 6, 5 )} );
+		c.load( {make_process( 7, 30 ), make_process( 8, 30 )} );
+		auto fleet = daw::fleet_table( );
+		fleet.add_host( a.table.get( ) );
+		fleet.add_host( b.table.get( ) );
+		fleet.add_host( c.table.get( ) );
+		auto const hosts = std::vector<host_t const *>{&a, &b, &c};
+
+		DAW_CHECK( shown( fleet ) == expected( hosts, SortOrder::Descending ) );
+		DAW_CHECK( fleet.total_rows( ) == 8 );
+		fleet.sort_column( working_set_column, SortOrder::Ascending );
+		DAW_CHECK( shown( fleet ) ==
+		           ( std::vector<std::wstring>{L"b:6", L"a:2", L"a:3", L"b:4", L"c:7",
+		                                       L"c:8", L"a:1", L"b:5"} ) );
+		DAW_CHECK( shown( fleet ) == expected( hosts, SortOrder::Ascending ) );
+	}
+
+	void merges_an_updated_host_back( ) {
+		auto rng = std::mt19937( 3 );
+		auto const random_processes = [&]( uint32_t first_pid ) {
+			auto result = std::vector<daw::wmi_process>( );
+			auto const count = rng( ) % 30;
+			for( uint32_t n = 0; n < count; ++n ) {
+				result.push_back( make_process( first_pid + n, rng( ) % 40 ) );
+			}
+			return result;
+		};
+		auto hosts = std::vector<std::unique_ptr<host_t>>( );
+		auto fleet = daw::fleet_table( );
+		for( auto const name : {L"a", L"b", L"c", L"d"} ) {
+			hosts.push_back( std::make_unique<host_t>( name ) );
+			hosts.back( )->load( random_processes( 1 ) );
+			fleet.add_host( hosts.back( )->table.get( ) );
+		}
+		auto const all = [&] {
+			auto result = std::vector<host_t const *>( );
+			for( auto const &host : hosts ) {
+				result.push_back( host.get( ) );
+			}
+			return result;
+		};
+		for( auto const sort_order : {SortOrder::Ascending, SortOrder::Descending} ) {
+			fleet.sort_column( working_set_column, sort_order );
+			for( auto const limit : {size_t{0}, size_t{10}} ) {
+				fleet.set_row_limit( limit );
+				for( int n = 0; n < 50; ++n ) {
+					auto &host = *hosts[rng( ) % hosts.size( )];
+					host.load( random_processes( rng( ) % 20 ) );
+					fleet.host_updated( host.table.get( ) );
+					DAW_CHECK( shown( fleet ) == expected( all( ), sort_order, limit ) );
+				}
+			}
+		}
+	}
+
+	void drops_removed_hosts( ) {
+		auto a = host_t( L"a" );
+		auto b = host_t( L"b" );
+		auto c = host_t( L"c" );
+		a.load( {make_process( 1, 90 ), make_process( 2, 80 )} );
+		b.load( {make_process( 3, 85 ), make_process( 4, 10 )} );
+		c.load( {make_process( 5, 70 ), make_process( 6, 60 )} );
+		auto fleet = daw::fleet_table( );
+		fleet.add_host( a.table.get( ) );
+		fleet.add_host( b.table.get( ) );
+		fleet.add_host( c.table.get( ) );
+		fleet.set_row_limit( 3 );
+		DAW_CHECK( shown( fleet ) ==
+		           ( std::vector<std::wstring>{L"a:1", L"b:3", L"a:2"} ) );
+
+		// The rows after the limit fill in, and c is still found after the
+		// hosts before it moved down
+		fleet.remove_host( a.table.get( ) );
+		DAW_CHECK( shown( fleet ) ==
+		           ( std::vector<std::wstring>{L"b:3", L"c:5", L"c:6"} ) );
+		c.load( {make_process( 5, 95 )} );
+		fleet.host_updated( c.table.get( ) );
+		DAW_CHECK( shown( fleet ) ==
+		           ( std::vector<std::wstring>{L"c:5", L"b:3", L"b:4"} ) );
+		fleet.remove_host( a.table.get( ) );
+		DAW_CHECK( fleet.GetNumberRows( ) == 3 );
+	}
+
+	void limits_the_rows( ) {
+		auto a = host_t( L"a" );
+		auto b = host_t( L"." );
+		a.load( {make_process( 1, 5 ), make_process( 2, 4 ), make_process( 3, 3 )} );
+		b.load( {make_process( 4, 6 ), make_process( 5, 2 )} );
+		auto fleet = daw::fleet_table( );
+		fleet.set_row_limit( 2 );
+		fleet.add_host( a.table.get( ) );
+		fleet.add_host( b.table.get( ) );
+		DAW_CHECK( shown( fleet ) ==
+		           ( std::vector<std::wstring>{L"local machine:4", L"a:1"} ) );
+		DAW_CHECK( fleet.total_rows( ) == 5 );
+		fleet.set_row_limit( 4 );
+		DAW_CHECK( shown( fleet ) ==
+		           ( std::vector<std::wstring>{L"local machine:4", L"a:1", L"a:2",
+		                                       L"a:3"} ) );
+		fleet.set_row_limit( 1 );
+		DAW_CHECK( shown( fleet ) ==
+		           ( std::vector<std::wstring>{L"local machine:4"} ) );
+		fleet.set_row_limit( 0 );
+		DAW_CHECK( fleet.GetNumberRows( ) == 5 );
+
+		// On the host label, which sorts the local machine after a
+		fleet.sort_column( daw::fleet_table::host_column, SortOrder::Ascending );
+		DAW_CHECK( shown( fleet ) ==
+		           ( std::vector<std::wstring>{L"a:1", L"a:2", L"a:3",
+		                                       L"local machine:4",
+		                                       L"local machine:5"} ) );
+	}
+} // namespace
+
+int main( ) {
+	merges_in_both_orders( );
+	merges_an_updated_host_back( );
+	drops_removed_hosts( );
+	limits_the_rows( );
+	return daw::test::result( );
+}
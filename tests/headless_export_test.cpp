@@ -0,0 +1,217 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <wx/datetime.h>
+
+#include "check.h"
+#include "daw/headless_export.h"
+#include "daw/wmi_process.h"
+#include "daw/wmi_projection.h"
+#include "fake_process_source.h"
+
+namespace {
+	using column_number = daw::wmi_process::column_number;
+
+	daw::wmi_process make_process( uint32_t pid, std::wstring_view name ) {
+		auto result = daw::wmi_process{};
+		result.process_id = pid;
+		result.name = name;
+		// 2001-09-09T01:46:40Z
+		result.creation_date = wxDateTime( wxLongLong( 1'000'000'000'000 ) );
+		result.working_set_size = uint64_t{5} << 40U;
+		result.cpu_usage = 1'205;
+		return result;
+	}
+
+	std::vector<std::string> lines_of( std::string const &text ) {
+		auto result = std::vector<std::string>( );
+		auto in = std::istringstream( text );
+		for( auto line = std::string( ); std::getline( in, line ); ) {
+			result.push_back( line );
+		}
+		return result;
+	}
+
+	// Host and time, the time is the same on every row of a collection
+	std::string prefix( std::string const &line, size_t fields ) {
+		auto pos = std::string::npos;
+		for( size_t n = 0; n < fields; ++n ) {
+			pos = line.find( ',', pos + 1 );
+		}
+		return line.substr( 0, pos );
+	}
+
+	bool is_iso_time( std::string const &time ) {
+		return time.size( ) == 20 && time[4] == '-' && time[7] == '-' &&
+		       time[10] == 'T' && time[13] == ':' && time[16] == ':' &&
+		       time[19] == 'Z';
+	}
+
+	daw::export_options options( std::shared_ptr<daw::process_source> source ) {
+		auto opts = daw::export_options{};
+		opts.processes = std::move( source );
+		opts.columns =
+		  daw::make_column_set( {column_number::Name, column_number::ProcessId,
+		                         column_number::CreationDate,
+		                         column_number::WorkingSetSize, column_number::CpuUsage} );
+		return opts;
+	}
+
+	void writes_the_columns_asked_for( ) {
+		auto source = std::make_shared<daw::test::fake_process_source>(
+		  std::vector<daw::wmi_process>{make_process( 4, L"plain.exe" ),
+		                                make_process( 8, L"a, \"b\".exe" )} );
+		auto out = std::ostringstream( );
+		auto err = std::ostringstream( );
+		DAW_CHECK( daw::export_processes( {L"host"}, options( source ), out, err ) == 0 );
+		DAW_CHECK( err.str( ).empty( ) );
+
+		auto const lines = lines_of( out.str( ) );
+		DAW_CHECK( lines.size( ) == 3 );
+		if( lines.size( ) != 3 ) {
+			return;
+		}
+		DAW_CHECK( lines[0] ==
+		           "Host,Time,Name,Process Id,Creation Date,Working Set,CPU" );
+		auto const time = prefix( lines[1], 2 ).substr( 5 );
+		DAW_CHECK( is_iso_time( time ) );
+		DAW_CHECK( prefix( lines[2], 2 ) == "host," + time );
+		// Raw numbers, quotes only where CSV needs them
+		DAW_CHECK( lines[1].substr( 26 ) ==
+		           "plain.exe,4,2001-09-09T01:46:40Z,5497558138880,12.05" );
+		DAW_CHECK( lines[2].substr( 26 ) ==
+		           "\"a, \"\"b\"\".exe\",8,2001-09-09T01:46:40Z,5497558138880,12.05" );
+	}
+
+	void writes_ndjson( ) {
+		auto row = make_process( 1, L"tab\there \\ \"é\".exe" );
+		row.creation_date = wxDateTime( );
+		auto source = std::make_shared<daw::test::fake_process_source>(
+		  std::vector<daw::wmi_process>{row} );
+		auto opts = options( source );
+		opts.format = daw::export_formats::Ndjson;
+		opts.columns = daw::make_column_set(
+		  {column_number::Name, column_number::ProcessId, column_number::CreationDate} );
+		auto out = std::ostringstream( );
+		auto err = std::ostringstream( );
+		DAW_CHECK( daw::export_processes( {L"h\"1"}, opts, out, err ) == 0 );
+
+		auto const lines = lines_of( out.str( ) );
+		DAW_CHECK( lines.size( ) == 1 );
+		if( lines.size( ) != 1 ) {
+			return;
+		}
+		auto const &line = lines[0];
+		DAW_CHECK( line.rfind( "{\"Host\":\"h\\\"1\",\"Time\":\"", 0 ) == 0 );
+		// UTF-8, escaped, and a date that is not set is null
+		auto const rest = std::string(
+		  ",\"Name\":\"tab\\there \\\\ \\\"\xC3\xA9\\\".exe\",\"Process "
+		  "Id\":1,\"Creation Date\":null}" );
+		DAW_CHECK( line.size( ) > rest.size( ) &&
+		           line.compare( line.size( ) - rest.size( ), rest.size( ), rest ) == 0 );
+	}
+
+	// Hands out count processes, then loses the host
+	struct failing_source final : daw::process_source {
+		size_t count;
+
+		explicit failing_source( size_t n )
+		  : count( n ) {}
+
+		std::vector<daw::wmi_process> get_processes( std::wstring const &,
+		                                             daw::column_set ) override {
+			return {};
+		}
+
+		std::vector<daw::wmi_process>
+		get_processes( std::wstring const &, daw::column_set,
+		               std::vector<uint32_t> const & ) override {
+			return {};
+		}
+
+		void for_each_process(
+		  std::wstring const &host, daw::column_set,
+		  std::function<void( daw::wmi_process const & )> const &func ) override {
+			if( host == L"good" ) {
+				func( make_process( 1, L"good.exe" ) );
+				return;
+			}
+			for( uint32_t pid = 0; pid < count; ++pid ) {
+				func( make_process( pid, L"lost.exe" ) );
+			}
+			throw std::runtime_error( "connection lost" );
+		}
+
+		void terminate_process( std::wstring const &, uint32_t ) override {}
+	};
+
+	void keeps_the_rows_before_an_error( ) {
+		auto opts = options( std::make_shared<failing_source>( 5 ) );
+		opts.columns = daw::make_column_set( {column_number::Name} );
+		// Every row is written as it is formatted
+		opts.buffer_size = 1;
+		opts.concurrency = 2;
+		auto out = std::ostringstream( );
+		auto err = std::ostringstream( );
+		DAW_CHECK( daw::export_processes( {L"good", L"bad", L"good"}, opts, out,
+		                                  err ) == 1 );
+		DAW_CHECK( err.str( ) == "bad: connection lost\n" );
+
+		size_t good = 0;
+		size_t lost = 0;
+		for( auto const &line : lines_of( out.str( ) ) ) {
+			if( line.find( ",good.exe" ) != std::string::npos ) {
+				++good;
+			} else if( line.find( ",lost.exe" ) != std::string::npos ) {
+				DAW_CHECK( line.rfind( "bad,", 0 ) == 0 );
+				++lost;
+			}
+		}
+		DAW_CHECK( good == 2 );
+		DAW_CHECK( lost == 5 );
+	}
+
+	void leaves_out_the_rates( ) {
+		auto const columns = daw::default_export_columns( );
+		DAW_CHECK( columns[static_cast<size_t>( column_number::Name )] );
+		DAW_CHECK( columns[static_cast<size_t>( column_number::ReadTransferCount )] );
+		DAW_CHECK( !columns[static_cast<size_t>( column_number::CpuUsage )] );
+		DAW_CHECK( !columns[static_cast<size_t>( column_number::ReadRate )] );
+		DAW_CHECK( !columns[static_cast<size_t>( column_number::WriteRate )] );
+		DAW_CHECK( !columns[static_cast<size_t>( column_number::PageFaultRate )] );
+	}
+} // namespace
+
+int main( ) {
+	writes_the_columns_asked_for( );
+	writes_ndjson( );
+	keeps_the_rows_before_an_error( );
+	leaves_out_the_rates( );
+	return daw::test::result( );
+}
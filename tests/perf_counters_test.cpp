@@ -0,0 +1,113 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "check.h"
+#include "daw/perf_counters.h"
+#include "daw/process_rates.h"
+#include "daw/wmi_process.h"
+#include "daw/wmi_projection.h"
+
+namespace {
+	// 2020-09-13, as a FILETIME
+	constexpr uint64_t first_timestamp = 132'444'736'000'000'000ULL;
+	// A second in 100ns units
+	constexpr uint64_t filetime_second = 10'000'000;
+
+	daw::raw_process_counters make_counters( uint32_t pid, uint64_t processor_time,
+	                                         uint64_t bytes_read ) {
+		auto result = daw::raw_process_counters{};
+		result.process_id = pid;
+		result.processor_time = processor_time;
+		result.io_read_bytes = bytes_read;
+		result.thread_count = 4;
+		result.working_set = 8'192;
+		result.private_bytes = 4'096;
+		return result;
+	}
+
+	std::vector<daw::wmi_process> to_rows( daw::raw_counter_sample const &sample ) {
+		auto result = std::vector<daw::wmi_process>( sample.processes.size( ) );
+		for( size_t n = 0; n < result.size( ); ++n ) {
+			daw::apply_raw_counters( sample.processes[n], result[n] );
+		}
+		return result;
+	}
+
+	void fills_the_counter_columns( ) {
+		DAW_CHECK( daw::raw_counter_columns( ) == daw::counter_columns( ) );
+		auto row = daw::wmi_process{};
+		daw::apply_raw_counters( make_counters( 7, 100, 200 ), row );
+		DAW_CHECK( row.process_id.value == 7 );
+		DAW_CHECK( row.cpu_time == 100 );
+		DAW_CHECK( row.read_transfer_count.value == 200 );
+		DAW_CHECK( row.thread_count.value == 4 );
+		DAW_CHECK( row.working_set_size.value == 8'192 );
+		DAW_CHECK( row.page_file_usage.value == 4'096 );
+	}
+
+	void times_the_rates_by_the_sample( ) {
+		auto first = daw::raw_counter_sample{};
+		first.timestamp = first_timestamp;
+		first.processes = {make_counters( 1, 0, 0 ), make_counters( 2, 0, 0 )};
+		// Read two seconds later on the host, whatever the local clock says
+		auto second = daw::raw_counter_sample{};
+		second.timestamp = first_timestamp + 2 * filetime_second;
+		second.processes = {make_counters( 1, filetime_second, 3'000 ),
+		                    make_counters( 2, 4 * filetime_second, 0 )};
+		DAW_CHECK( daw::sample_time( second ) - daw::sample_time( first ) ==
+		           std::chrono::seconds( 2 ) );
+
+		auto rates = daw::process_rates{};
+		auto rows = to_rows( first );
+		rates.update( rows, daw::sample_time( first ) );
+		rows = to_rows( second );
+		rates.update( rows, daw::sample_time( second ) );
+		// A second of CPU over two seconds is half a core
+		DAW_CHECK( rows[0].cpu_usage.value == 5'000 );
+		DAW_CHECK( rows[0].read_rate.value == 1'500 );
+		// Two cores
+		DAW_CHECK( rows[1].cpu_usage.value == 20'000 );
+		DAW_CHECK( rows[1].read_rate.value == 0 );
+	}
+
+	void orders_the_sample_times( ) {
+		auto sample = daw::raw_counter_sample{};
+		sample.timestamp = first_timestamp;
+		auto const first = daw::sample_time( sample );
+		sample.timestamp += 1;
+		DAW_CHECK( daw::sample_time( sample ) > first );
+		// Before 1970 is clamped, not wrapped
+		sample.timestamp = 1;
+		DAW_CHECK( daw::sample_time( sample ) < first );
+	}
+} // namespace
+
+int main( ) {
+	fills_the_counter_columns( );
+	times_the_rates_by_the_sample( );
+	orders_the_sample_times( );
+	return daw::test::result( );
+}
@@ -0,0 +1,246 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <wx/datetime.h>
+
+#include "check.h"
+#include "daw/process_source.h"
+#include "daw/wmi_process.h"
+#include "daw/wmi_projection.h"
+
+namespace {
+	using column_number = daw::wmi_process::column_number;
+
+	// A /proc of three processes, written to the directory the test runs in
+	auto const root = std::string( "proc_process_source_test.proc" );
+	constexpr int64_t boot_time = 1'600'000'000;
+
+	struct fake_process {
+		uint32_t pid;
+		std::string stat;
+		std::string statm;
+		std::string status;
+		// Empty when the process has none, like the io of another user's
+		// process
+		std::string io;
+		std::string cmdline;
+	};
+
+	// The fields after comm, from state (3) to rss (24)
+	std::string stat_line( uint32_t pid, std::string const &comm,
+	                       std::string const &fields ) {
+		return std::to_string( pid ) + " (" + comm + ") " + fields + "\n";
+	}
+
+	// /proc/[pid]/cmdline, each argument ends with a '\0'
+	std::string arguments( std::vector<std::string> const &args ) {
+		auto result = std::string( );
+		for( auto const &arg : args ) {
+			result += arg;
+			result += '\0';
+		}
+		return result;
+	}
+
+	std::vector<fake_process> const processes = {
+	  {100,
+	   stat_line( 100, "my (odd) name",
+	              "S 1 100 42 0 -1 4194560 30 0 12 0 200 100 0 0 20 0 7 0 500 "
+	              "1000000 250" ),
+	   "1000 250 50 10 0 300 0\n", "Name:\tmy (odd) name\nVmPeak:\t    8192 kB\n"
+	   "VmHWM:\t    2048 kB\n",
+	   "rchar: 12345\nwchar: 678\nsyscr: 9\n",
+	   arguments( {"/usr/bin/caf\xc3\xa9", "--flag"} )},
+	  {200,
+	   stat_line( 200, "worker", "S 100 200 42 0 -1 0 1 0 0 0 0 0 0 0 20 0 1 0 "
+	                             "900 0 0" ),
+	   "10 5 0 0 0 2 0\n", "VmPeak:\t  64 kB\nVmHWM:\t  20 kB\n", "", ""},
+	  {300,
+	   stat_line( 300, "sh", "R 1 300 7 0 -1 0 5 0 1 0 3 4 0 0 20 0 2 0 1000 "
+	                         "0 0" ),
+	   "20 8 0 0 0 4 0\n", "VmPeak:\t  128 kB\nVmHWM:\t  40 kB\n",
+	   "rchar: 1\nwchar: 2\n", arguments( {"sh", "-c", "true"} )}};
+
+	std::vector<std::string> created;
+
+	void write_file( std::string const &path, std::string const &content ) {
+		auto out = std::ofstream( path, std::ios::binary | std::ios::trunc );
+		out.write( content.data( ), static_cast<std::streamsize>( content.size( ) ) );
+		created.push_back( path );
+	}
+
+	void make_dir( std::string const &path ) {
+		::mkdir( path.c_str( ), 0755 );
+		created.push_back( path );
+	}
+
+	void make_tree( ) {
+		make_dir( root );
+		write_file( root + "/stat", "cpu  1 2 3 4\nbtime " +
+		                              std::to_string( boot_time ) + "\nprocesses 3\n" );
+		// Not a process
+		make_dir( root + "/sys" );
+		for( auto const &process : processes ) {
+			auto const dir = root + "/" + std::to_string( process.pid );
+			make_dir( dir );
+			write_file( dir + "/stat", process.stat );
+			write_file( dir + "/statm", process.statm );
+			write_file( dir + "/status", process.status );
+			if( !process.io.empty( ) ) {
+				write_file( dir + "/io", process.io );
+			}
+			write_file( dir + "/cmdline", process.cmdline );
+		}
+	}
+
+	void remove_tree( ) {
+		// Each directory was created before its files
+		std::for_each( created.rbegin( ), created.rend( ),
+		               []( std::string const &path ) { std::remove( path.c_str( ) ); } );
+		created.clear( );
+	}
+
+	daw::wmi_process const *find( std::vector<daw::wmi_process> const &rows,
+	                              uint32_t pid ) {
+		auto const pos =
+		  std::find_if( rows.begin( ), rows.end( ), [&]( daw::wmi_process const &row ) {
+			  return row.process_id.value == pid;
+		  } );
+		return pos == rows.end( ) ? nullptr : &*pos;
+	}
+
+	bool is_same( daw::wmi_process const &lhs, daw::wmi_process const &rhs ) {
+		for( size_t n = 0; n < daw::wmi_process::column_count; ++n ) {
+			if( lhs[n].compare( rhs[n] ) != 0 ) {
+				return false;
+			}
+		}
+		return lhs.cpu_time == rhs.cpu_time;
+	}
+
+	void reads_the_process_files( ) {
+		auto const ticks = static_cast<uint64_t>( ::sysconf( _SC_CLK_TCK ) );
+		auto const page_size = static_cast<uint64_t>( ::sysconf( _SC_PAGESIZE ) );
+		auto source = daw::make_proc_process_source( root );
+		auto const rows = source->get_processes( L"", daw::all_columns( ) );
+		DAW_CHECK( rows.size( ) == 3 );
+
+		auto const row = find( rows, 100 );
+		DAW_CHECK( row != nullptr );
+		if( row == nullptr ) {
+			return;
+		}
+		DAW_CHECK( row->name.value == L"my (odd) name" );
+		DAW_CHECK( row->handle.value == L"100" );
+		DAW_CHECK( row->parent_process_id.value == 1 );
+		DAW_CHECK( row->session_id.value == 42 );
+		DAW_CHECK( row->page_faults.value == 42 );
+		DAW_CHECK( row->thread_count.value == 7 );
+		DAW_CHECK( row->cpu_time == 300 * 10'000'000U / ticks );
+		auto const start_ms =
+		  boot_time * 1000 + static_cast<int64_t>( 500 * 1000U / ticks );
+		DAW_CHECK( row->creation_date.value == wxDateTime( wxLongLong( start_ms ) ) );
+		DAW_CHECK( row->working_set_size.value == 250 * page_size );
+		DAW_CHECK( row->page_file_usage.value == 300 * page_size );
+		DAW_CHECK( row->peak_working_set_size.value == 2048 * 1024 );
+		DAW_CHECK( row->peak_page_file_usage.value == 8192 * 1024 );
+		DAW_CHECK( row->read_transfer_count.value == 12345 );
+		DAW_CHECK( row->write_transfer_count.value == 678 );
+		DAW_CHECK( row->command_line.value == L"/usr/bin/caf\u00e9 --flag" );
+
+		// No io file, no arguments
+		auto const worker = find( rows, 200 );
+		DAW_CHECK( worker != nullptr && worker->read_transfer_count.value == 0 &&
+		           worker->command_line.value.empty( ) );
+	}
+
+	void clears_the_columns_not_requested( ) {
+		auto source = daw::make_proc_process_source( root );
+		auto const columns = daw::make_column_set( {column_number::Name} );
+		auto count = 0;
+		source->for_each_process( L".", columns, [&]( daw::wmi_process const &row ) {
+			++count;
+			DAW_CHECK( !row.name.value.empty( ) );
+			DAW_CHECK( row.command_line.value.empty( ) );
+			DAW_CHECK( row.handle.value.empty( ) );
+			DAW_CHECK( row.working_set_size.value == 0 );
+			DAW_CHECK( row.read_transfer_count.value == 0 );
+			DAW_CHECK( row.peak_working_set_size.value == 0 );
+		} );
+		DAW_CHECK( count == 3 );
+	}
+
+	// for_each_process reuses one row, nothing of the process before it may
+	// be left over
+	void visits_the_same_rows( ) {
+		auto source = daw::make_proc_process_source( root );
+		auto const expected = source->get_processes( L"", daw::all_columns( ) );
+		auto count = 0;
+		source->for_each_process( L"localhost", daw::all_columns( ),
+		                          [&]( daw::wmi_process const &row ) {
+			                          ++count;
+			                          auto const other =
+			                            find( expected, row.process_id.value );
+			                          DAW_CHECK( other != nullptr && is_same( row, *other ) );
+		                          } );
+		DAW_CHECK( count == 3 );
+	}
+
+	void reads_the_processes_asked_for( ) {
+		auto source = daw::make_proc_process_source( root );
+		auto const rows =
+		  source->get_processes( L"", daw::all_columns( ), {300, 999, 100} );
+		DAW_CHECK( rows.size( ) == 2 );
+		DAW_CHECK( rows.size( ) == 2 && rows[0].process_id.value == 300 &&
+		           rows[1].process_id.value == 100 );
+		DAW_CHECK( rows.size( ) == 2 && rows[0].command_line.value == L"sh -c true" );
+	}
+
+	void rejects_other_hosts( ) {
+		auto source = daw::make_proc_process_source( root );
+		auto is_thrown = false;
+		try {
+			source->get_processes( L"server01", daw::all_columns( ) );
+		} catch( std::invalid_argument const & ) { is_thrown = true; }
+		DAW_CHECK( is_thrown );
+	}
+} // namespace
+
+int main( ) {
+	make_tree( );
+	reads_the_process_files( );
+	clears_the_columns_not_requested( );
+	visits_the_same_rows( );
+	reads_the_processes_asked_for( );
+	rejects_other_hosts( );
+	remove_tree( );
+	return daw::test::result( );
+}
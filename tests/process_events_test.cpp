@@ -0,0 +1,146 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <wx/datetime.h>
+
+#include "check.h"
+#include "daw/process_events.h"
+#include "daw/wmi_process.h"
+#include "daw/wmi_process_table.h"
+#include "fake_process_source.h"
+
+namespace {
+	using column_number = daw::wmi_process::column_number;
+	using kinds = daw::process_event::kinds;
+
+	daw::wmi_process make_process( uint32_t pid, long long created = 0 ) {
+		auto result = daw::wmi_process{};
+		result.process_id = pid;
+		result.name = L"process" + std::to_wstring( pid ) + L".exe";
+		result.creation_date =
+		  wxDateTime( wxLongLong( created == 0 ? 1'000 + pid : created ) );
+		return result;
+	}
+
+	std::vector<daw::wmi_process> make_processes( ) {
+		return {make_process( 1 ), make_process( 2 ), make_process( 3 )};
+	}
+
+	daw::process_event make_event( kinds kind, daw::wmi_process process ) {
+		return daw::process_event{kind, std::move( process )};
+	}
+
+	std::vector<uint32_t> process_ids( daw::wmi_process_table const &table ) {
+		auto result = std::vector<uint32_t>( );
+		for( auto id : table.rows( ) ) {
+			result.push_back( table.store( ).process_id[id] );
+		}
+		return result;
+	}
+
+	// A table subscribed to the events of source, loaded and sorted on the
+	// process id
+	void load( daw::wmi_process_table &table ) {
+		table.sort_column( column_number::ProcessId,
+		                   daw::wmi_process_table::SortOrder::Ascending );
+		table.subscribe_events( );
+		table.update_data( );
+		table.apply_update( );
+	}
+
+	void applies_starts_and_stops( ) {
+		auto source =
+		  std::make_shared<daw::test::fake_process_source>( make_processes( ) );
+		auto table = daw::wmi_process_table( L"host", source );
+		load( table );
+		auto const events = source->events( );
+		DAW_CHECK( events != nullptr );
+		if( !events ) {
+			return;
+		}
+		DAW_CHECK( process_ids( table ) == std::vector<uint32_t>{1, 2, 3} );
+
+		events->push( make_event( kinds::Started, make_process( 10 ) ) );
+		events->push( make_event( kinds::Started, make_process( 0 ) ) );
+		// Reported twice, and a start of a row the poll already showed
+		events->push( make_event( kinds::Started, make_process( 10 ) ) );
+		events->push( make_event( kinds::Started, make_process( 2 ) ) );
+		DAW_CHECK( table.apply_events( ) == 4 );
+		DAW_CHECK( process_ids( table ) == std::vector<uint32_t>{0, 1, 2, 3, 10} );
+
+		// Never shown, and a reused process id whose first process is shown
+		events->push( make_event( kinds::Stopped, make_process( 99 ) ) );
+		events->push( make_event( kinds::Stopped, make_process( 2, 5'000 ) ) );
+		DAW_CHECK( table.apply_events( ) == 2 );
+		DAW_CHECK( table.rows( ).size( ) == 5 );
+
+		events->push( make_event( kinds::Stopped, make_process( 3 ) ) );
+		events->push( make_event( kinds::Stopped, make_process( 0 ) ) );
+		DAW_CHECK( table.apply_events( ) == 2 );
+		DAW_CHECK( process_ids( table ) == std::vector<uint32_t>{1, 2, 10} );
+		DAW_CHECK( table.apply_events( ) == 0 );
+	}
+
+	void rebuilds_after_an_overflow( ) {
+		auto source =
+		  std::make_shared<daw::test::fake_process_source>( make_processes( ) );
+		auto table = daw::wmi_process_table( L"host", source );
+		load( table );
+		auto const events = source->events( );
+		DAW_CHECK( events != nullptr );
+		if( !events ) {
+			return;
+		}
+		// While the events keep up the poll only fetches the counters
+		table.update_data( );
+		table.apply_update( );
+		DAW_CHECK( source->counter_call_count( L"host" ) == 1 );
+
+		auto const count = events->events.capacity( ) + 10;
+		for( uint32_t pid = 100; pid < 100 + count; ++pid ) {
+			events->push( make_event( kinds::Started, make_process( pid ) ) );
+		}
+		DAW_CHECK( events->has_overflowed );
+		DAW_CHECK( table.apply_events( ) == events->events.capacity( ) );
+
+		// The events that were dropped are unknown, every row is fetched again
+		table.update_data( );
+		table.apply_update( );
+		DAW_CHECK( source->counter_call_count( L"host" ) == 1 );
+		DAW_CHECK( !events->has_overflowed );
+		DAW_CHECK( process_ids( table ) == std::vector<uint32_t>{1, 2, 3} );
+
+		table.update_data( );
+		table.apply_update( );
+		DAW_CHECK( source->counter_call_count( L"host" ) == 2 );
+	}
+} // namespace
+
+int main( ) {
+	applies_starts_and_stops( );
+	rebuilds_after_an_overflow( );
+	return daw::test::result( );
+}
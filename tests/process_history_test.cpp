@@ -0,0 +1,117 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <wx/datetime.h>
+
+#include "check.h"
+#include "daw/process_history.h"
+#include "daw/process_store.h"
+#include "daw/wmi_process.h"
+
+namespace {
+	using series_kinds = daw::process_history::series_kinds;
+	using std::chrono::seconds;
+
+	daw::wmi_process make_process( uint32_t pid, uint64_t working_set ) {
+		auto result = daw::wmi_process{};
+		result.process_id = pid;
+		result.creation_date = wxDateTime( wxLongLong( 1'000 + pid ) );
+		result.working_set_size = working_set;
+		return result;
+	}
+
+	auto const start = daw::process_history::clock::time_point{} + seconds( 100 );
+
+	void round_trips_the_values( ) {
+		// Small and huge steps, up and down
+		auto const values = std::vector<uint64_t>{
+		  0, 1, 1, 1'000'000, 999'999, std::numeric_limits<uint64_t>::max( ),
+		  0, 4'096, std::numeric_limits<uint64_t>::max( ) / 2, 4'095};
+		auto history = daw::process_history{};
+		for( size_t n = 0; n < values.size( ); ++n ) {
+			history.record( {make_process( 4, values[n] )}, start + seconds( n ) );
+		}
+		auto const key = daw::key_of( make_process( 4, 0 ) );
+		DAW_CHECK( history.series( key, series_kinds::WorkingSet ) == values );
+		DAW_CHECK( history.series( key, series_kinds::ReadRate ) ==
+		           std::vector<uint64_t>( values.size( ), 0 ) );
+		DAW_CHECK( history.series( daw::key_of( make_process( 5, 0 ) ),
+		                           series_kinds::WorkingSet )
+		             .empty( ) );
+		auto const stats = history.stats( );
+		DAW_CHECK( stats.process_count == 1 );
+		DAW_CHECK( stats.sample_count == values.size( ) );
+		DAW_CHECK( stats.span == seconds( values.size( ) - 1 ) );
+	}
+
+	void keeps_at_most_max_samples( ) {
+		auto options = daw::process_history::options_t{};
+		options.max_samples = 5;
+		auto history = daw::process_history( options );
+		for( uint64_t n = 0; n < 8; ++n ) {
+			history.record( {make_process( 4, n * 300 )}, start + seconds( n ) );
+		}
+		auto const key = daw::key_of( make_process( 4, 0 ) );
+		DAW_CHECK( history.series( key, series_kinds::WorkingSet ) ==
+		           std::vector<uint64_t>{900, 1'200, 1'500, 1'800, 2'100} );
+	}
+
+	void trims_to_the_window( ) {
+		auto options = daw::process_history::options_t{};
+		options.window = seconds( 10 );
+		auto history = daw::process_history( options );
+		for( uint64_t n = 0; n < 6; ++n ) {
+			history.record( {make_process( 4, n ), make_process( 8, n )},
+			                start + seconds( n ) );
+		}
+		// A sample process 8 missed repeats its last value
+		history.record( {make_process( 4, 6 )}, start + seconds( 6 ) );
+		history.record( {make_process( 4, 7 ), make_process( 8, 7 )},
+		                start + seconds( 7 ) );
+		DAW_CHECK( history.series( daw::key_of( make_process( 8, 0 ) ),
+		                           series_kinds::WorkingSet ) ==
+		           std::vector<uint64_t>{0, 1, 2, 3, 4, 5, 5, 7} );
+		// Then it ends, and is forgotten once out of the window
+		for( uint64_t n = 8; n < 12; ++n ) {
+			history.record( {make_process( 4, n )}, start + seconds( 3 * n ) );
+		}
+		auto const series = history.series( daw::key_of( make_process( 4, 0 ) ),
+		                                    series_kinds::WorkingSet );
+		// The samples taken 24s, 27s, 30s and 33s after start
+		DAW_CHECK( series == std::vector<uint64_t>{8, 9, 10, 11} );
+		DAW_CHECK( history.series( daw::key_of( make_process( 8, 0 ) ),
+		                           series_kinds::WorkingSet )
+		             .empty( ) );
+		DAW_CHECK( history.stats( ).process_count == 1 );
+	}
+} // namespace
+
+int main( ) {
+	round_trips_the_values( );
+	keeps_at_most_max_samples( );
+	trims_to_the_window( );
+	return daw::test::result( );
+}
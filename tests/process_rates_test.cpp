@@ -0,0 +1,106 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include <wx/datetime.h>
+
+#include "check.h"
+#include "daw/process_rates.h"
+#include "daw/wmi_process.h"
+
+namespace {
+	using std::chrono::seconds;
+
+	daw::wmi_process make_process( uint32_t pid, long long created,
+	                               uint64_t cpu_time, uint64_t bytes_read,
+	                               uint32_t page_faults ) {
+		auto result = daw::wmi_process{};
+		result.process_id = pid;
+		result.creation_date = wxDateTime( wxLongLong( created ) );
+		result.cpu_time = cpu_time;
+		result.read_transfer_count = bytes_read;
+		result.page_faults = page_faults;
+		return result;
+	}
+
+	auto const start = daw::process_rates::clock::time_point{} + seconds( 100 );
+
+	void joins_on_process_and_creation_date( ) {
+		auto rates = daw::process_rates{};
+		auto first = std::vector<daw::wmi_process>{make_process( 1, 10, 0, 0, 0 ),
+		                                           make_process( 2, 20, 0, 0, 0 )};
+		rates.update( first, start );
+		DAW_CHECK( first[0].cpu_usage.value == 0 );
+		DAW_CHECK( rates.size( ) == 2 );
+
+		// Two seconds later, in another order.  Process id 2 was reused
+		auto second = std::vector<daw::wmi_process>{
+		  make_process( 2, 21, 5'000, 100, 1 ),
+		  make_process( 1, 10, 10'000'000, 2'000, 10 ),
+		  make_process( 3, 30, 9, 9, 9 )};
+		rates.update( second, start + seconds( 2 ) );
+		// A second of CPU over two seconds is half a core
+		DAW_CHECK( second[1].cpu_usage.value == 5'000 );
+		DAW_CHECK( second[1].read_rate.value == 1'000 );
+		DAW_CHECK( second[1].page_fault_rate.value == 5 );
+		// Neither has a previous sample
+		DAW_CHECK( second[0].cpu_usage.value == 0 );
+		DAW_CHECK( second[0].read_rate.value == 0 );
+		DAW_CHECK( second[2].cpu_usage.value == 0 );
+		DAW_CHECK( rates.size( ) == 3 );
+	}
+
+	void ignores_counters_going_backwards( ) {
+		auto rates = daw::process_rates{};
+		auto first =
+		  std::vector<daw::wmi_process>{make_process( 1, 10, 0, 5'000, 10 )};
+		rates.update( first, start );
+		auto second = std::vector<daw::wmi_process>{
+		  make_process( 1, 10, 20'000'000, 1'000, 10 )};
+		rates.update( second, start + seconds( 1 ) );
+		// Two cores for the whole second
+		DAW_CHECK( second[0].cpu_usage.value == 20'000 );
+		DAW_CHECK( second[0].read_rate.value == 0 );
+		DAW_CHECK( second[0].page_fault_rate.value == 0 );
+	}
+
+	void starts_over_when_cleared( ) {
+		auto rates = daw::process_rates{};
+		auto first = std::vector<daw::wmi_process>{make_process( 1, 10, 0, 0, 0 )};
+		rates.update( first, start );
+		rates.clear( );
+		DAW_CHECK( rates.size( ) == 0 );
+		auto second =
+		  std::vector<daw::wmi_process>{make_process( 1, 10, 10'000'000, 0, 0 )};
+		rates.update( second, start + seconds( 1 ) );
+		DAW_CHECK( second[0].cpu_usage.value == 0 );
+	}
+} // namespace
+
+int main( ) {
+	joins_on_process_and_creation_date( );
+	ignores_counters_going_backwards( );
+	starts_over_when_cleared( );
+	return daw::test::result( );
+}
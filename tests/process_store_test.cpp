@@ -0,0 +1,298 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <wx/datetime.h>
+#include <wx/string.h>
+
+#include "check.h"
+#include "daw/process_store.h"
+#include "daw/wmi_process.h"
+
+namespace {
+	using column_number = daw::wmi_process::column_number;
+
+	daw::wmi_process make_process( uint32_t pid, std::wstring_view name,
+	                               uint64_t working_set ) {
+		auto result = daw::wmi_process{};
+		result.process_id = pid;
+		result.name = name;
+		result.command_line = L"C:\\Windows\\" + std::wstring( name );
+		result.creation_date = wxDateTime( wxLongLong( 1'000'000 + pid ) );
+		result.working_set_size = working_set;
+		result.thread_count = pid % 7;
+		return result;
+	}
+
+	void stores_rows_by_column( ) {
+		auto store = daw::process_store{};
+		auto const first = store.add( make_process( 4, L"System", 100 ) );
+		auto const second = store.add( make_process( 8, L"explorer.exe", 300 ) );
+		DAW_CHECK( store.size( ) == 2 );
+		DAW_CHECK( store.view<column_number::ProcessId>( )[second] == 8 );
+		DAW_CHECK( store.string_value( first, column_number::Name ) == L"System" );
+		DAW_CHECK( store.total<column_number::WorkingSetSize>( ) == 400 );
+
+		auto const row = store.to_process( second );
+		DAW_CHECK( row.process_id.value == 8 );
+		DAW_CHECK( row.name.value == L"explorer.exe" );
+		DAW_CHECK( row.command_line.value == L"C:\\Windows\\explorer.exe" );
+		DAW_CHECK( row.working_set_size.value == 300 );
+		DAW_CHECK( row.creation_date.value == wxDateTime( wxLongLong( 1'000'008 ) ) );
+		DAW_CHECK( store.key( second ) == daw::key_of( row ) );
+	}
+
+	void reuses_removed_rows( ) {
+		auto store = daw::process_store{};
+		store.add( make_process( 4, L"System", 100 ) );
+		auto const removed = store.add( make_process( 8, L"explorer.exe", 300 ) );
+		store.remove( removed );
+		DAW_CHECK( store.size( ) == 1 );
+		// Free rows are zeroed, totals run over them
+		DAW_CHECK( store.total<column_number::WorkingSetSize>( ) == 100 );
+		auto const added = store.add( make_process( 12, L"cmd.exe", 5 ) );
+		DAW_CHECK( added == removed );
+		DAW_CHECK( store.capacity( ) == 2 );
+		DAW_CHECK( store.string_value( added, column_number::Name ) == L"cmd.exe" );
+	}
+
+	void finds_rows_by_key( ) {
+		auto store = daw::process_store{};
+		auto const system = store.add( make_process( 4, L"System", 100 ) );
+		auto const explorer = store.add( make_process( 8, L"explorer.exe", 300 ) );
+		auto const key = daw::key_of( make_process( 8, L"explorer.exe", 300 ) );
+		DAW_CHECK( store.find( key ) == explorer );
+		store.remove( explorer );
+		DAW_CHECK( !store.find( key ) );
+		// A reused row takes the key of its new process
+		auto const added = store.add( make_process( 12, L"cmd.exe", 5 ) );
+		DAW_CHECK( store.find( store.key( added ) ) == added );
+		auto const moved = make_process( 16, L"System", 100 );
+		store.assign( system, column_number::ProcessId, moved );
+		store.assign( system, column_number::CreationDate, moved );
+		DAW_CHECK( store.find( daw::key_of( moved ) ) == system );
+		DAW_CHECK( !store.find( daw::key_of( make_process( 4, L"System", 100 ) ) ) );
+		store.clear( );
+		DAW_CHECK( !store.find( daw::key_of( moved ) ) );
+	}
+
+	void interns_strings( ) {
+		auto store = daw::process_store{};
+		for( uint32_t pid = 0; pid < 100; ++pid ) {
+			auto const name = pid % 2 == 0 ? L"svchost.exe" : L"conhost.exe";
+			store.add( make_process( pid, name, pid ) );
+		}
+		auto const string_count = store.strings.size( );
+		DAW_CHECK( store.name[0] == store.name[2] );
+		DAW_CHECK( store.name[0] != store.name[1] );
+		for( uint32_t pid = 1; pid < 100; pid += 2 ) {
+			store.remove( pid );
+		}
+		store.compact_strings( );
+		DAW_CHECK( store.strings.size( ) < string_count );
+		DAW_CHECK( store.string_value( 0, column_number::Name ) == L"svchost.exe" );
+		DAW_CHECK( store.string_value( 98, column_number::CommandLine ) ==
+		           L"C:\\Windows\\svchost.exe" );
+	}
+
+	daw::process_store make_store( ) {
+		auto store = daw::process_store{};
+		store.add( make_process( 30, L"b.exe", 300 ) );
+		store.add( make_process( 10, L"A.exe", 100 ) );
+		store.add( make_process( 20, L"c.exe", 300 ) );
+		store.add( make_process( 40, L"a.exe", 200 ) );
+		return store;
+	}
+
+	std::vector<daw::process_store::row_id>
+	sorted_rows( daw::process_store const &store, column_number col,
+	             bool is_ascending ) {
+		auto rows = std::vector<daw::process_store::row_id>{0, 1, 2, 3};
+		daw::sort_rows( store, rows, col, is_ascending );
+		return rows;
+	}
+
+	void compares_typed_columns( ) {
+		auto const store = make_store( );
+		DAW_CHECK( store.compare( column_number::ProcessId, 1, 0 ) < 0 );
+		DAW_CHECK( store.compare( column_number::WorkingSetSize, 0, 2 ) == 0 );
+		DAW_CHECK( store.compare( column_number::CreationDate, 3, 0 ) > 0 );
+		// Strings compare without case
+		DAW_CHECK( store.compare( column_number::Name, 1, 3 ) == 0 );
+		DAW_CHECK( store.compare( column_number::Name, 1, 0 ) < 0 );
+
+		auto other = daw::process_store{};
+		auto const id = other.add( make_process( 5, L"B.EXE", 50 ) );
+		DAW_CHECK( daw::compare_rows( store, 0, other, id, column_number::Name ) ==
+		           0 );
+		DAW_CHECK( daw::compare_rows( store, 0, other, id,
+		                              column_number::WorkingSetSize ) > 0 );
+	}
+
+	void sorts_rows( ) {
+		auto const store = make_store( );
+		using rows_t = std::vector<daw::process_store::row_id>;
+		DAW_CHECK( sorted_rows( store, column_number::ProcessId, true ) ==
+		           rows_t{1, 2, 0, 3} );
+		// Ties are ordered on the row id
+		DAW_CHECK( sorted_rows( store, column_number::WorkingSetSize, true ) ==
+		           rows_t{1, 3, 0, 2} );
+		// Descending is ascending read backwards, ties included
+		DAW_CHECK( sorted_rows( store, column_number::WorkingSetSize, false ) ==
+		           rows_t{2, 0, 3, 1} );
+		DAW_CHECK( sorted_rows( store, column_number::Name, true ) ==
+		           rows_t{1, 3, 0, 2} );
+	}
+
+	int sign( int value ) {
+		return ( value > 0 ) - ( value < 0 );
+	}
+
+	void folds_sort_keys( ) {
+		// Ties in the first four characters, case only differences, prefixes
+		// and characters past A-Z, which are not folded
+		auto const names = std::vector<std::wstring>{
+		  L"", L"a", L"A", L"ab", L"abcd", L"ABCDE", L"abcdf", L"abce", L"Z",
+		  L"_", L"[", L"\u00e9", L"\u00c9", L"svchost.exe", L"SvcHost.exe"};
+		for( auto const &lhs : names ) {
+			for( auto const &rhs : names ) {
+				auto const lhs_key = daw::folded_sort_key( lhs );
+				auto const rhs_key = daw::folded_sort_key( rhs );
+				auto const order = sign( daw::compare_nocase( lhs, rhs ) );
+				// Different keys decide the order, equal keys leave it open
+				if( lhs_key != rhs_key ) {
+					DAW_CHECK( ( lhs_key < rhs_key ? -1 : 1 ) == order );
+				} else if( lhs.size( ) < 4 && rhs.size( ) < 4 ) {
+					DAW_CHECK( order == 0 );
+				}
+			}
+		}
+
+		auto store = daw::process_store{};
+		auto ids = std::vector<daw::process_store::string_id>( );
+		for( auto const &name : names ) {
+			ids.push_back( store.intern( name ) );
+		}
+		auto const ranks = store.string_ranks( );
+		for( size_t l = 0; l < names.size( ); ++l ) {
+			for( size_t r = 0; r < names.size( ); ++r ) {
+				auto const order = sign( daw::compare_nocase( names[l], names[r] ) );
+				DAW_CHECK( sign( store.compare_strings( ids[l], ids[r] ) ) == order );
+				auto const rank_order =
+				  sign( static_cast<int>( ranks[ids[l]] ) -
+				        static_cast<int>( ranks[ids[r]] ) );
+				DAW_CHECK( rank_order == order );
+			}
+		}
+	}
+
+	std::vector<daw::process_store::row_id>
+	live_rows( daw::process_store const &store ) {
+		auto result = std::vector<daw::process_store::row_id>( );
+		for( daw::process_store::row_id id = 0; id < store.capacity( ); ++id ) {
+			if( std::find( store.free_rows.begin( ), store.free_rows.end( ), id ) ==
+			    store.free_rows.end( ) ) {
+				result.push_back( id );
+			}
+		}
+		return result;
+	}
+
+	// Names repeat and are sorted on ranks, command lines are distinct and
+	// sorted on their keys, both in the order compare gives
+	void sorts_repeated_and_distinct_strings( ) {
+		static wchar_t const *const names[] = {L"svchost.exe", L"SVCHOST.EXE",
+		                                       L"conhost.exe", L"a.exe"};
+		auto rng = std::mt19937( 7 );
+		auto store = daw::process_store{};
+		for( uint32_t pid = 0; pid < 200; ++pid ) {
+			auto row = make_process( pid, names[rng( ) % 4], pid );
+			row.command_line = L"C:\\Windows\\" + std::to_wstring( rng( ) );
+			store.add( row );
+		}
+		for( auto const col : {column_number::Name, column_number::CommandLine} ) {
+			auto expected = live_rows( store );
+			std::stable_sort( expected.begin( ), expected.end( ),
+			                  [&]( auto lhs, auto rhs ) {
+				                  return store.compare( col, lhs, rhs ) < 0;
+			                  } );
+			auto rows = live_rows( store );
+			daw::sort_rows( store, rows, col, true );
+			DAW_CHECK( rows == expected );
+		}
+	}
+
+	void resorts_from_the_previous_order( ) {
+		auto rng = std::mt19937( 13 );
+		auto store = daw::process_store{};
+		for( uint32_t pid = 0; pid < 500; ++pid ) {
+			store.add( make_process( pid, L"p.exe", rng( ) % 64 ) );
+		}
+		auto const col = column_number::WorkingSetSize;
+		auto previous = live_rows( store );
+		daw::sort_rows( store, previous, col, true );
+
+		// Some grow or shrink, some end and others start
+		for( int n = 0; n < 20; ++n ) {
+			auto const id = static_cast<daw::process_store::row_id>( rng( ) % 500 );
+			auto row = store.to_process( id );
+			row.working_set_size = rng( ) % 64;
+			store.assign( id, col, row );
+		}
+		for( daw::process_store::row_id id = 0; id < 500; id += 50 ) {
+			store.remove( id );
+		}
+		for( uint32_t pid = 500; pid < 520; ++pid ) {
+			store.add( make_process( pid, L"p.exe", rng( ) % 64 ) );
+		}
+
+		auto const rows = live_rows( store );
+		auto expected = rows;
+		daw::sort_rows( store, expected, col, true );
+		DAW_CHECK( daw::resort_rows( store, previous, rows, col ) == expected );
+
+		// The sort of a copy taken for another thread agrees
+		DAW_CHECK( daw::make_sort_snapshot( store, rows, col, true ).sort( 2 ) ==
+		           expected );
+		std::reverse( expected.begin( ), expected.end( ) );
+		DAW_CHECK( daw::make_sort_snapshot( store, rows, col, false ).sort( 2 ) ==
+		           expected );
+	}
+} // namespace
+
+int main( ) {
+	stores_rows_by_column( );
+	reuses_removed_rows( );
+	finds_rows_by_key( );
+	interns_strings( );
+	compares_typed_columns( );
+	sorts_rows( );
+	sorts_repeated_and_distinct_strings( );
+	folds_sort_keys( );
+	resorts_from_the_previous_order( );
+	return daw::test::result( );
+}
@@ -0,0 +1,172 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "daw/refresh_scheduler.h"
+#include "daw/wmi_projection.h"
+#include "fake_process_source.h"
+
+namespace {
+	using std::chrono::milliseconds;
+
+	daw::refresh_scheduler::host_id
+	add_host( daw::refresh_scheduler &scheduler,
+	          daw::test::fake_process_source &source, std::wstring host,
+	          bool is_visible = true ) {
+		return scheduler.add_host(
+		  [&source, host]( ) { source.get_processes( host, daw::all_columns( ) ); },
+		  []( std::exception_ptr ) {}, is_visible );
+	}
+
+	void bounds_the_refreshes_running( ) {
+		auto opts = daw::refresh_scheduler_options{};
+		opts.worker_count = 3;
+		opts.visible_interval = milliseconds( 20 );
+		auto source = daw::test::fake_process_source{};
+		auto hosts = std::vector<std::wstring>( );
+		for( int n = 0; n < 12; ++n ) {
+			hosts.push_back( L"host" + std::to_wstring( n ) );
+			source.set_latency( hosts.back( ), milliseconds( 5 ) );
+		}
+		{
+			auto scheduler = daw::refresh_scheduler( opts );
+			for( auto const &host : hosts ) {
+				add_host( scheduler, source, host );
+			}
+			std::this_thread::sleep_for( milliseconds( 300 ) );
+		}
+		DAW_CHECK( source.max_running( ) <= 3 );
+		// The workers were all used
+		DAW_CHECK( source.max_running( ) > 1 );
+		for( auto const &host : hosts ) {
+			DAW_CHECK( source.call_count( host ) > 1 );
+			DAW_CHECK( source.max_running( host ) == 1 );
+		}
+	}
+
+	void prefers_visible_hosts( ) {
+		auto opts = daw::refresh_scheduler_options{};
+		opts.worker_count = 1;
+		opts.visible_interval = milliseconds( 10 );
+		opts.hidden_interval = milliseconds( 100 );
+		opts.jitter = 0;
+		auto source = daw::test::fake_process_source{};
+		{
+			auto scheduler = daw::refresh_scheduler( opts );
+			add_host( scheduler, source, L"shown", true );
+			add_host( scheduler, source, L"hidden", false );
+			std::this_thread::sleep_for( milliseconds( 300 ) );
+		}
+		DAW_CHECK( source.call_count( L"hidden" ) >= 1 );
+		DAW_CHECK( source.call_count( L"shown" ) >
+		           3 * source.call_count( L"hidden" ) );
+	}
+
+	void backs_off_a_slow_host( ) {
+		auto opts = daw::refresh_scheduler_options{};
+		opts.worker_count = 2;
+		opts.visible_interval = milliseconds( 10 );
+		opts.jitter = 0;
+		opts.deadline = milliseconds( 20 );
+		auto source = daw::test::fake_process_source{};
+		source.set_latency( L"slow", milliseconds( 40 ) );
+		auto scheduler = daw::refresh_scheduler( opts );
+		auto const slow = add_host( scheduler, source, L"slow" );
+		auto const fast = add_host( scheduler, source, L"fast" );
+		for( int n = 0; n < 20; ++n ) {
+			std::this_thread::sleep_for( milliseconds( 50 ) );
+			// Ignored while it backs off
+			scheduler.refresh_now( slow );
+		}
+		auto const slow_stats = scheduler.stats( slow );
+		auto const fast_stats = scheduler.stats( fast );
+		DAW_CHECK( slow_stats.missed_deadlines > 0 );
+		DAW_CHECK( fast_stats.missed_deadlines == 0 );
+		DAW_CHECK( slow_stats.refresh_count * 3 < fast_stats.refresh_count );
+	}
+
+	// Hosts waiting for a worker are not late, only a slow refresh is
+	void does_not_back_off_waiting_hosts( ) {
+		auto opts = daw::refresh_scheduler_options{};
+		opts.worker_count = 1;
+		opts.visible_interval = milliseconds( 1 );
+		opts.jitter = 0;
+		opts.deadline = milliseconds( 100 );
+		auto source = daw::test::fake_process_source{};
+		auto ids = std::vector<daw::refresh_scheduler::host_id>( );
+		auto scheduler = daw::refresh_scheduler( opts );
+		for( int n = 0; n < 16; ++n ) {
+			auto const host = L"host" + std::to_wstring( n );
+			source.set_latency( host, milliseconds( 10 ) );
+			ids.push_back( add_host( scheduler, source, host ) );
+		}
+		std::this_thread::sleep_for( milliseconds( 600 ) );
+		for( auto id : ids ) {
+			auto const stats = scheduler.stats( id );
+			DAW_CHECK( stats.refresh_count > 1 );
+			DAW_CHECK( stats.max_wait > opts.deadline );
+			DAW_CHECK( stats.missed_deadlines == 0 );
+		}
+	}
+
+	void reports_errors( ) {
+		auto opts = daw::refresh_scheduler_options{};
+		opts.visible_interval = milliseconds( 10 );
+		auto source = daw::test::fake_process_source{};
+		source.set_failing( L"down", true );
+		auto error_count = std::atomic<size_t>( 0 );
+		auto scheduler = daw::refresh_scheduler( opts );
+		auto const id = scheduler.add_host(
+		  [&source]( ) { source.get_processes( L"down", daw::all_columns( ) ); },
+		  [&error_count]( std::exception_ptr error ) {
+			  if( error ) {
+				  ++error_count;
+			  }
+		  },
+		  true );
+		std::this_thread::sleep_for( milliseconds( 100 ) );
+		scheduler.remove_host( id );
+		// Nothing runs once removed
+		auto const call_count = source.call_count( L"down" );
+		std::this_thread::sleep_for( milliseconds( 50 ) );
+		DAW_CHECK( source.call_count( L"down" ) == call_count );
+		DAW_CHECK( error_count > 1 );
+		DAW_CHECK( error_count == call_count );
+		DAW_CHECK( scheduler.host_count( ) == 0 );
+	}
+} // namespace
+
+int main( ) {
+	bounds_the_refreshes_running( );
+	prefers_visible_hosts( );
+	backs_off_a_slow_host( );
+	does_not_back_off_waiting_hosts( );
+	reports_errors( );
+	return daw::test::result( );
+}
@@ -0,0 +1,213 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <wx/datetime.h>
+
+#include "check.h"
+#include "daw/snapshot_file.h"
+#include "daw/wmi_process.h"
+#include "daw/wmi_projection.h"
+
+namespace {
+	using std::chrono::seconds;
+	namespace snapshot_file = daw::snapshot_file;
+
+	// Written to the directory the test runs in
+	auto const path = std::string( "snapshot_file_test.bin" );
+	auto const start = snapshot_file::clock::time_point( seconds( 1'600'000'000 ) );
+
+	bool is_same( daw::wmi_process const &lhs, daw::wmi_process const &rhs ) {
+		for( size_t n = 0; n < daw::wmi_process::column_count; ++n ) {
+			if( lhs[n].compare( rhs[n] ) != 0 ) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool is_same( std::vector<daw::wmi_process> const &lhs,
+	              std::vector<daw::wmi_process> const &rhs ) {
+		if( lhs.size( ) != rhs.size( ) ) {
+			return false;
+		}
+		for( size_t n = 0; n < lhs.size( ); ++n ) {
+			if( !is_same( lhs[n], rhs[n] ) ) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	daw::wmi_process make_process( uint32_t pid ) {
+		auto result = daw::wmi_process{};
+		result.process_id = pid;
+		result.creation_date = wxDateTime( wxLongLong( 1'000 + pid ) );
+		result.name = L"process" + std::to_wstring( pid % 20 ) + L".exe";
+		result.command_line = L"\u00e9t\u00e9 --pid " + std::to_wstring( pid );
+		return result;
+	}
+
+	// Processes whose counters change, with one ending and one starting every
+	// few snapshots
+	std::vector<std::vector<daw::wmi_process>> make_snapshots( size_t count ) {
+		auto rng = std::mt19937( 3 );
+		auto current = std::vector<daw::wmi_process>( );
+		for( uint32_t pid = 0; pid < 100; ++pid ) {
+			current.push_back( make_process( pid ) );
+		}
+		// Processes without a creation date are recorded too
+		current[0].creation_date = wxDateTime( );
+		auto result = std::vector<std::vector<daw::wmi_process>>( );
+		for( size_t n = 0; n < count; ++n ) {
+			for( auto &row : current ) {
+				row.working_set_size.value += rng( ) % 1'000;
+				if( rng( ) % 10 == 0 ) {
+					row.working_set_size.value -= 500;
+				}
+				row.cpu_usage = rng( ) % 300;
+			}
+			if( n % 5 == 4 ) {
+				current.erase( current.begin( ) + 5 );
+				auto const pid = static_cast<uint32_t>( 1'000 + n );
+				current.push_back( make_process( pid ) );
+			}
+			std::shuffle( current.begin( ) + 1, current.end( ), rng );
+			result.push_back( current );
+		}
+		return result;
+	}
+
+	void write( std::vector<std::vector<daw::wmi_process>> const &snapshots ) {
+		auto options = snapshot_file::writer_options_t{};
+		options.keyframe_interval = 10;
+		auto writer = snapshot_file::writer( path, options );
+		for( size_t n = 0; n < snapshots.size( ); ++n ) {
+			writer.append( snapshots[n], start + seconds( 2 * n ) );
+		}
+		DAW_CHECK( writer.snapshot_count( ) == snapshots.size( ) );
+	}
+
+	void reads_back_what_was_written( ) {
+		auto const snapshots = make_snapshots( 35 );
+		write( snapshots );
+		auto reader = snapshot_file::reader( path );
+		DAW_CHECK( reader.size( ) == snapshots.size( ) );
+		for( size_t n = 0; n < snapshots.size( ); ++n ) {
+			DAW_CHECK( is_same( reader.read( n ), snapshots[n] ) );
+			DAW_CHECK( reader.time( n ) == start + seconds( 2 * n ) );
+		}
+		DAW_CHECK( !reader.read( 0 )[0].creation_date.value.IsValid( ) );
+		// Out of order, from the keyframe before each snapshot
+		for( size_t n : {27U, 3U, 19U, 34U, 0U, 11U} ) {
+			DAW_CHECK( is_same( reader.read( n ), snapshots[n] ) );
+		}
+	}
+
+	void seeks_by_time( ) {
+		auto const snapshots = make_snapshots( 35 );
+		write( snapshots );
+		auto reader = std::make_shared<snapshot_file::reader>( path );
+		DAW_CHECK( reader->find( start + seconds( 7 ) ) == 3 );
+		DAW_CHECK( reader->find( start - seconds( 7 ) ) == 0 );
+		DAW_CHECK( reader->find( start + std::chrono::hours( 7 ) ) == 34 );
+
+		auto replay = daw::replay_source( reader );
+		replay.seek( start + seconds( 64 ) );
+		DAW_CHECK( replay.position( ) == 32 );
+		DAW_CHECK( is_same( replay( ), snapshots[32] ) );
+		DAW_CHECK( is_same( replay( ), snapshots[33] ) );
+		DAW_CHECK( is_same( replay( ), snapshots[34] ) );
+		// The last snapshot repeats
+		DAW_CHECK( is_same( replay( ), snapshots[34] ) );
+	}
+
+	void carries_over_the_columns_not_polled( ) {
+		auto const first = std::vector<daw::wmi_process>{make_process( 1 ),
+		                                                  make_process( 2 )};
+		auto counters = std::vector<daw::wmi_process>( 2 );
+		for( size_t n = 0; n < counters.size( ); ++n ) {
+			counters[n].process_id = first[n].process_id;
+			counters[n].creation_date = first[n].creation_date.value;
+			counters[n].working_set_size = 4'096 * ( n + 1 );
+		}
+		{
+			auto writer = snapshot_file::writer( path );
+			writer.append( first, start );
+			auto const columns = daw::counter_columns( ) | daw::required_columns( );
+			writer.append( counters, columns, start + seconds( 1 ) );
+		}
+		auto reader = snapshot_file::reader( path );
+		auto const rows = reader.read( 1 );
+		DAW_CHECK( rows.size( ) == 2 );
+		DAW_CHECK( rows[1].name.value == first[1].name.value );
+		DAW_CHECK( rows[1].command_line.value == first[1].command_line.value );
+		DAW_CHECK( rows[1].working_set_size.value == 8'192 );
+	}
+
+	void ignores_a_frame_cut_short( ) {
+		write( make_snapshots( 5 ) );
+		auto bytes = std::vector<char>( );
+		{
+			auto in = std::ifstream( path, std::ios::binary );
+			bytes.assign( std::istreambuf_iterator<char>( in ),
+			              std::istreambuf_iterator<char>( ) );
+		}
+		{
+			auto out = std::ofstream( path, std::ios::binary | std::ios::trunc );
+			auto const size = static_cast<std::streamsize>( bytes.size( ) - 10 );
+			out.write( bytes.data( ), size );
+		}
+		DAW_CHECK( snapshot_file::reader( path ).size( ) == 4 );
+	}
+
+	void rejects_other_files( ) {
+		{
+			auto out = std::ofstream( path, std::ios::binary | std::ios::trunc );
+			out << "not a recording";
+		}
+		auto is_thrown = false;
+		try {
+			snapshot_file::reader( path ).size( );
+		} catch( std::runtime_error const & ) { is_thrown = true; }
+		DAW_CHECK( is_thrown );
+	}
+} // namespace
+
+int main( ) {
+	reads_back_what_was_written( );
+	seeks_by_time( );
+	carries_over_the_columns_not_polled( );
+	ignores_a_frame_cut_short( );
+	rejects_other_files( );
+	std::remove( path.c_str( ) );
+	return daw::test::result( );
+}
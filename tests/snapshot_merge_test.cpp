@@ -0,0 +1,258 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "check.h"
+#include "daw/snapshot_merge.h"
+
+namespace {
+	struct fake_row {
+		uint64_t id = 0;
+		std::array<int, 3> cells{};
+	};
+
+	// The rows live in a vector, an id is the index of its row
+	struct fake_store {
+		std::vector<fake_row> rows;
+		std::vector<bool> is_removed;
+		int sort_column = 1;
+
+		daw::row_key key( size_t id ) const {
+			return key( rows[id] );
+		}
+
+		daw::row_key key( fake_row const &row ) const {
+			return daw::row_key{row.id, 0};
+		}
+
+		bool is_equal( size_t id, fake_row const &next, size_t col ) const {
+			return rows[id].cells[col] == next.cells[col];
+		}
+
+		void assign( size_t id, fake_row &&next, uint64_t column_mask ) {
+			for( size_t col = 0; col < next.cells.size( ); ++col ) {
+				if( column_mask & ( uint64_t{1} << col ) ) {
+					rows[id].cells[col] = next.cells[col];
+				}
+			}
+		}
+
+		size_t add( fake_row &&row ) {
+			rows.push_back( std::move( row ) );
+			is_removed.push_back( false );
+			return rows.size( ) - 1;
+		}
+
+		void remove( size_t id ) {
+			is_removed[id] = true;
+		}
+
+		bool less( size_t lhs, size_t rhs ) const {
+			return rows[lhs].cells[sort_column] < rows[rhs].cells[sort_column];
+		}
+	};
+
+	// Replays the notifications on a copy of the grid's row count
+	struct fake_observer {
+		size_t row_count = 0;
+		std::vector<std::pair<size_t, size_t>> inserted;
+		std::vector<std::pair<size_t, size_t>> changed_cells;
+
+		void on_rows_deleted( size_t pos, size_t count ) {
+			DAW_CHECK( pos + count <= row_count );
+			row_count -= count;
+		}
+
+		void on_rows_inserted( size_t pos, size_t count ) {
+			DAW_CHECK( pos <= row_count );
+			row_count += count;
+			inserted.emplace_back( pos, count );
+		}
+
+		void on_cell_changed( size_t row, size_t col ) {
+			changed_cells.emplace_back( row, col );
+		}
+	};
+
+	std::vector<fake_row> make_rows( size_t count ) {
+		auto result = std::vector<fake_row>( );
+		for( size_t n = 0; n < count; ++n ) {
+			auto const value = static_cast<int>( n );
+			result.push_back( fake_row{n, {value, value * 10, 0}} );
+		}
+		return result;
+	}
+
+	// Loads snapshot into an empty table
+	std::vector<size_t> load( std::vector<fake_row> snapshot, fake_store &store,
+	                          fake_observer &observer ) {
+		auto ids = std::vector<size_t>( );
+		daw::merge_snapshot( ids, std::move( snapshot ), 3, store.sort_column,
+		                     store, observer );
+		return ids;
+	}
+
+	bool is_sorted( std::vector<size_t> const &ids, fake_store const &store ) {
+		return std::is_sorted( ids.begin( ), ids.end( ), [&]( size_t l, size_t r ) {
+			return store.less( l, r );
+		} );
+	}
+
+	void merges_the_changes( ) {
+		auto store = fake_store{};
+		auto observer = fake_observer{};
+		auto snapshot = make_rows( 10 );
+		auto ids = load( snapshot, store, observer );
+		DAW_CHECK( ids.size( ) == 10 );
+
+		snapshot[3].cells[2] = 7;    // changed in place
+		snapshot[5].cells[1] = 1000; // moves to the end
+		snapshot.erase( snapshot.begin( ) + 8 );
+		snapshot.push_back( fake_row{42, {42, 15, 0}} );
+		observer.changed_cells.clear( );
+		auto const stats = daw::merge_snapshot( ids, std::move( snapshot ), 3,
+		                                        store.sort_column, store, observer );
+		DAW_CHECK( !stats.is_reset );
+		DAW_CHECK( stats.rows_added == 1 );
+		DAW_CHECK( stats.rows_removed == 1 );
+		DAW_CHECK( stats.rows_moved == 1 );
+		DAW_CHECK( stats.rows_unchanged == 7 );
+		DAW_CHECK( stats.cells_changed == 1 );
+		DAW_CHECK( ids.size( ) == 10 );
+		DAW_CHECK( observer.row_count == ids.size( ) );
+		DAW_CHECK( is_sorted( ids, store ) );
+		DAW_CHECK( store.rows[ids.back( )].id == 5 );
+		DAW_CHECK( store.rows[ids[2]].id == 42 );
+		// Reported at the row's final position
+		DAW_CHECK( observer.changed_cells.size( ) == 1 );
+		DAW_CHECK( store.rows[ids[observer.changed_cells[0].first]].id == 3 );
+		DAW_CHECK( observer.changed_cells[0].second == 2 );
+	}
+
+	void replaces_a_mostly_changed_table( ) {
+		auto store = fake_store{};
+		auto observer = fake_observer{};
+		auto snapshot = make_rows( 10 );
+		auto ids = load( snapshot, store, observer );
+		for( auto &row : snapshot ) {
+			row.id += 100;
+		}
+		auto const stats = daw::merge_snapshot( ids, std::move( snapshot ), 3,
+		                                        store.sort_column, store, observer );
+		DAW_CHECK( stats.is_reset );
+		DAW_CHECK( stats.rows_added == 10 );
+		DAW_CHECK( stats.rows_removed == 10 );
+		DAW_CHECK( observer.row_count == 10 );
+		DAW_CHECK( store.rows[ids.front( )].id == 100 );
+	}
+
+	// A poll of the counter columns, see wmi_process_table::apply_update.
+	// Column 0 is fixed, the others are counters
+	void merges_only_the_columns_polled( ) {
+		auto store = fake_store{};
+		auto observer = fake_observer{};
+		auto ids = load( make_rows( 10 ), store, observer );
+
+		// The last process ended
+		auto counters = std::vector<fake_row>( );
+		for( uint64_t id = 0; id < 9; ++id ) {
+			auto const value = static_cast<int>( id );
+			// The fixed column is not polled and holds nothing meaningful
+			counters.push_back(
+			  fake_row{id, {-1, id == 2 ? 1000 : value * 10, id == 4 ? 9 : 0}} );
+		}
+		// New processes come with every column
+		counters.push_back( fake_row{42, {42, 15, 0}} );
+		auto opts = daw::merge_options{};
+		opts.allow_reset = false;
+		observer.changed_cells.clear( );
+		auto const stats =
+		  daw::merge_rows( ids, std::move( counters ), uint64_t{0b110},
+		                   store.sort_column, opts, store, observer );
+		DAW_CHECK( !stats.is_reset );
+		DAW_CHECK( stats.rows_added == 1 );
+		DAW_CHECK( stats.rows_removed == 1 );
+		DAW_CHECK( stats.rows_moved == 1 );
+		DAW_CHECK( stats.cells_changed == 1 );
+		DAW_CHECK( ids.size( ) == 10 );
+		DAW_CHECK( observer.row_count == 10 );
+		DAW_CHECK( is_sorted( ids, store ) );
+		for( auto id : ids ) {
+			auto const &row = store.rows[id];
+			DAW_CHECK( row.cells[0] == static_cast<int>( row.id ) );
+			DAW_CHECK( row.id != 9 );
+		}
+		DAW_CHECK( store.rows[ids.back( )].id == 2 );
+		DAW_CHECK( store.rows[ids.back( )].cells[1] == 1000 );
+	}
+
+	// Below the reset threshold, with new rows between and equal to the
+	// kept ones
+	void inserts_many_rows_in_order( ) {
+		auto store = fake_store{};
+		auto observer = fake_observer{};
+		auto snapshot = make_rows( 100 );
+		auto ids = load( snapshot, store, observer );
+		for( uint64_t id = 1'000; id < 1'040; ++id ) {
+			// Every other one ties with a kept row
+			auto const value = static_cast<int>( ( id % 20 ) * 50 + ( id % 2 ) * 5 );
+			snapshot.push_back( fake_row{id, {0, value, 0}} );
+		}
+		observer.inserted.clear( );
+		auto const stats = daw::merge_snapshot( ids, std::move( snapshot ), 3,
+		                                        store.sort_column, store, observer );
+		DAW_CHECK( !stats.is_reset );
+		DAW_CHECK( stats.rows_added == 40 );
+		DAW_CHECK( ids.size( ) == 140 );
+		DAW_CHECK( observer.row_count == 140 );
+		DAW_CHECK( is_sorted( ids, store ) );
+		// Kept rows before the new rows they tie with, the new ones in the
+		// order they came
+		for( size_t n = 1; n < ids.size( ); ++n ) {
+			auto const &prev = store.rows[ids[n - 1]];
+			auto const &row = store.rows[ids[n]];
+			if( prev.cells[1] == row.cells[1] ) {
+				DAW_CHECK( prev.id < row.id );
+			}
+		}
+		// Reported front to back, in runs
+		DAW_CHECK( observer.inserted.size( ) < 40 );
+		for( size_t n = 1; n < observer.inserted.size( ); ++n ) {
+			auto const &prev = observer.inserted[n - 1];
+			DAW_CHECK( prev.first + prev.second < observer.inserted[n].first );
+		}
+	}
+} // namespace
+
+int main( ) {
+	merges_the_changes( );
+	replaces_a_mostly_changed_table( );
+	merges_only_the_columns_polled( );
+	inserts_many_rows_in_order( );
+	return daw::test::result( );
+}
@@ -0,0 +1,154 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <wx/datetime.h>
+
+#include "check.h"
+#include "daw/process_rates.h"
+#include "daw/process_source.h"
+#include "daw/wmi_process.h"
+
+namespace {
+	using column_number = daw::wmi_process::column_number;
+
+	daw::wmi_process make_process( uint32_t pid, uint64_t working_set,
+	                               uint64_t bytes_read = 0 ) {
+		auto result = daw::wmi_process{};
+		result.process_id = pid;
+		result.creation_date = wxDateTime( wxLongLong( pid * 10 ) );
+		result.working_set_size = working_set;
+		result.read_transfer_count = bytes_read;
+		return result;
+	}
+
+	std::vector<uint32_t> pids( std::vector<daw::wmi_process> const &rows ) {
+		auto result = std::vector<uint32_t>{};
+		for( auto const &row : rows ) {
+			result.push_back( row.process_id.value );
+		}
+		return result;
+	}
+
+	std::vector<uint32_t> select( std::vector<daw::wmi_process> const &rows,
+	                              bool is_ascending, size_t count ) {
+		auto selector = daw::top_selector( column_number::WorkingSetSize,
+		                                   is_ascending, count );
+		for( auto const &row : rows ) {
+			selector.offer( row );
+		}
+		auto top = std::move( selector ).take( );
+		DAW_CHECK( top.total == rows.size( ) );
+		DAW_CHECK( top.processes.size( ) == std::min( count, rows.size( ) ) );
+		return pids( top.processes );
+	}
+
+	void matches_a_full_sort( ) {
+		// Few distinct sizes, so there are plenty of ties
+		auto rng = std::mt19937( 7 );
+		auto rows = std::vector<daw::wmi_process>{};
+		for( uint32_t pid = 1; pid <= 500; ++pid ) {
+			rows.push_back( make_process( pid, rng( ) % 20 ) );
+		}
+		std::shuffle( rows.begin( ), rows.end( ), rng );
+
+		for( auto const is_ascending : {true, false} ) {
+			auto sorted = rows;
+			std::sort( sorted.begin( ), sorted.end( ),
+			           [&]( daw::wmi_process const &lhs, daw::wmi_process const &rhs ) {
+				           auto const l = lhs.working_set_size.value;
+				           auto const r = rhs.working_set_size.value;
+				           if( l != r ) {
+					           return is_ascending ? l < r : l > r;
+				           }
+				           return lhs.process_id.value < rhs.process_id.value;
+			           } );
+			for( auto const count : {size_t{0}, size_t{1}, size_t{37}, size_t{500},
+			                         size_t{600}} ) {
+				auto expected = pids( sorted );
+				expected.resize( std::min( count, expected.size( ) ) );
+				DAW_CHECK( select( rows, is_ascending, count ) == expected );
+			}
+		}
+	}
+
+	void breaks_ties_on_process_id( ) {
+		auto const rows = std::vector<daw::wmi_process>{
+		  make_process( 9, 5 ), make_process( 3, 5 ), make_process( 7, 5 ),
+		  make_process( 1, 1 ), make_process( 5, 5 )};
+		DAW_CHECK( select( rows, false, 3 ) == ( std::vector<uint32_t>{3, 5, 7} ) );
+		DAW_CHECK( select( rows, true, 3 ) == ( std::vector<uint32_t>{1, 3, 5} ) );
+	}
+
+	std::vector<uint32_t> select_rate( std::vector<daw::wmi_process> const &rows,
+	                                   daw::process_rates *rates, size_t count ) {
+		auto selector =
+		  daw::top_selector( column_number::ReadRate, false, count, rates );
+		for( auto const &row : rows ) {
+			selector.offer( row );
+		}
+		return pids( std::move( selector ).take( ).processes );
+	}
+
+	void ranks_rates_on_the_change( ) {
+		auto const start = daw::process_rates::clock::time_point{};
+		auto rates = daw::process_rates{};
+		auto first = std::vector<daw::wmi_process>{make_process( 1, 0, 1'000'000 ),
+		                                           make_process( 2, 0, 10 ),
+		                                           make_process( 3, 0, 500 )};
+		// Without samples the counters are all there is
+		DAW_CHECK( select_rate( first, &rates, 2 ) ==
+		           ( std::vector<uint32_t>{1, 3} ) );
+		// Only the kept rows get their rates, the others were still sampled
+		auto top = std::vector<daw::wmi_process>{first[0], first[2]};
+		rates.update( top, start );
+		DAW_CHECK( rates.size( ) == 3 );
+
+		// 1 is idle with the biggest total, 2 read the most since, 4 is new
+		auto second = std::vector<daw::wmi_process>{
+		  make_process( 1, 0, 1'000'000 ), make_process( 2, 0, 900 ),
+		  make_process( 3, 0, 600 ), make_process( 4, 0, 300 )};
+		DAW_CHECK( select_rate( second, &rates, 3 ) ==
+		           ( std::vector<uint32_t>{2, 4, 3} ) );
+		// Without rates it is the counters again
+		DAW_CHECK( select_rate( second, nullptr, 3 ) ==
+		           ( std::vector<uint32_t>{1, 2, 3} ) );
+
+		// The rates the grid sorts on agree
+		top = second;
+		rates.update( top, start + std::chrono::seconds( 1 ) );
+		DAW_CHECK( top[1].read_rate.value == 890 );
+		DAW_CHECK( top[2].read_rate.value == 100 );
+		DAW_CHECK( top[0].read_rate.value == 0 );
+	}
+} // namespace
+
+int main( ) {
+	matches_a_full_sort( );
+	breaks_ties_on_process_id( );
+	ranks_rates_on_the_change( );
+	return daw::test::result( );
+}
@@ -0,0 +1,121 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <atlcomcli.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <Wbemidl.h>
+
+#include "check.h"
+#include "daw/wmi_enumerate.h"
+#include "daw/wmi_impl.h"
+#include "daw/wmi_process.h"
+
+namespace {
+	struct fake_batch {
+		HRESULT result;
+		ULONG count;
+	};
+
+	// Hands out the batches in order, with null records.  Once they are used
+	// up every call times out without records
+	struct fake_enumerator {
+		std::vector<fake_batch> batches;
+		size_t call_count = 0;
+		std::vector<ULONG> requested;
+		std::vector<long> timeouts;
+
+		HRESULT Next( long timeout, ULONG count, IWbemClassObject **objects,
+		              ULONG *returned ) {
+			requested.push_back( count );
+			timeouts.push_back( timeout );
+			if( call_count >= batches.size( ) ) {
+				std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+				*returned = 0;
+				return WBEM_S_TIMEDOUT;
+			}
+			auto const batch = batches[call_count++];
+			for( ULONG n = 0; n < batch.count; ++n ) {
+				objects[n] = nullptr;
+			}
+			*returned = batch.count;
+			return batch.result;
+		}
+	};
+
+	daw::wmi_enumerate_options small_batches( ) {
+		auto opts = daw::wmi_enumerate_options{};
+		opts.batch_size = 3;
+		opts.batch_timeout = std::chrono::milliseconds( 50 );
+		return opts;
+	}
+
+	void reads_in_batches( ) {
+		auto enumerator = fake_enumerator{};
+		enumerator.batches = {{WBEM_S_NO_ERROR, 3},
+		                      {WBEM_S_TIMEDOUT, 0},
+		                      {WBEM_S_TIMEDOUT, 2},
+		                      {WBEM_S_FALSE, 1}};
+		auto record_count = 0;
+		daw::for_each_wmi_record(
+		  &enumerator, small_batches( ),
+		  [&]( CComPtr<IWbemClassObject> & ) { ++record_count; } );
+		DAW_CHECK( record_count == 6 );
+		DAW_CHECK( enumerator.call_count == 4 );
+		DAW_CHECK( enumerator.requested == std::vector<ULONG>( 4, 3 ) );
+		DAW_CHECK( enumerator.timeouts == std::vector<long>( 4, 50 ) );
+	}
+
+	void gives_up_on_an_idle_host( ) {
+		auto enumerator = fake_enumerator{};
+		enumerator.batches = {{WBEM_S_NO_ERROR, 3}};
+		auto opts = small_batches( );
+		opts.idle_timeout = std::chrono::milliseconds( 20 );
+		auto code = long{0};
+		try {
+			daw::for_each_wmi_record( &enumerator, opts,
+			                          []( CComPtr<IWbemClassObject> & ) {} );
+		} catch( daw::wmi_error_t const &ex ) { code = ex.code; }
+		DAW_CHECK( code == WBEM_E_TIMED_OUT );
+		// It kept waiting while the host still had time
+		DAW_CHECK( enumerator.requested.size( ) > 2 );
+	}
+
+	void reports_failures( ) {
+		auto enumerator = fake_enumerator{};
+		enumerator.batches = {{WBEM_S_NO_ERROR, 1}, {WBEM_E_FAILED, 0}};
+		auto code = long{0};
+		try {
+			daw::for_each_wmi_record( &enumerator, small_batches( ),
+			                          []( CComPtr<IWbemClassObject> & ) {} );
+		} catch( daw::wmi_error_t const &ex ) { code = ex.code; }
+		DAW_CHECK( code == WBEM_E_FAILED );
+	}
+} // namespace
+
+int main( ) {
+	reads_in_batches( );
+	gives_up_on_an_idle_host( );
+	reports_failures( );
+	return daw::test::result( );
+}
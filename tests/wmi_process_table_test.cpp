@@ -0,0 +1,143 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+#include <wx/datetime.h>
+
+#include "check.h"
+#include "daw/wmi_process.h"
+#include "daw/wmi_process_table.h"
+#include "fake_process_source.h"
+
+namespace {
+	using column_number = daw::wmi_process::column_number;
+	using SortOrder = daw::wmi_process_table::SortOrder;
+
+	// More than one batch of the stream, in no order
+	std::vector<daw::wmi_process> make_processes( ) {
+		auto rng = std::mt19937( 5 );
+		auto result = std::vector<daw::wmi_process>( );
+		for( uint32_t pid = 1; pid <= 1'000; ++pid ) {
+			auto row = daw::wmi_process{};
+			row.process_id = pid;
+			row.creation_date = wxDateTime( wxLongLong( 1'000 + pid ) );
+			row.working_set_size = rng( ) % 100'000;
+			result.push_back( row );
+		}
+		std::shuffle( result.begin( ), result.end( ), rng );
+		return result;
+	}
+
+	std::vector<uint32_t> process_ids( std::vector<daw::wmi_process> const &rows ) {
+		auto result = std::vector<uint32_t>( );
+		for( auto const &row : rows ) {
+			result.push_back( row.process_id.value );
+		}
+		return result;
+	}
+
+	std::vector<uint32_t> process_ids( daw::wmi_process_table const &table ) {
+		auto result = std::vector<uint32_t>( );
+		for( auto id : table.rows( ) ) {
+			result.push_back( table.store( ).process_id[id] );
+		}
+		return result;
+	}
+
+	void streams_the_first_load( ) {
+		auto const processes = make_processes( );
+		auto source = std::make_shared<daw::test::fake_process_source>( processes );
+		auto table = daw::wmi_process_table( L"host", source );
+		table.sort_column( column_number::WorkingSetSize, SortOrder::Descending );
+		size_t streamed = 0;
+		table.set_stream_callback( [&] { ++streamed; } );
+
+		table.update_data( );
+		DAW_CHECK( streamed > 1 );
+		DAW_CHECK( table.apply_stream( ) == processes.size( ) );
+		// As they arrived, the sort waits for the whole load
+		DAW_CHECK( process_ids( table ) == process_ids( processes ) );
+		// A sort asked for while streaming replaces the one before
+		table.sort_column( column_number::ProcessId, SortOrder::Ascending );
+		DAW_CHECK( process_ids( table ) == process_ids( processes ) );
+
+		table.apply_update( );
+		auto expected = process_ids( processes );
+		std::sort( expected.begin( ), expected.end( ) );
+		DAW_CHECK( process_ids( table ) == expected );
+
+		auto const timing = table.last_load_timing( );
+		DAW_CHECK( timing.first_row && timing.first_paint && timing.complete );
+		if( timing.first_row && timing.first_paint && timing.complete ) {
+			DAW_CHECK( *timing.first_row <= *timing.first_paint );
+			DAW_CHECK( *timing.first_paint <= *timing.complete );
+		}
+		DAW_CHECK( timing.rows == processes.size( ) );
+
+		// Only the first load streams
+		table.update_data( );
+		DAW_CHECK( table.apply_stream( ) == 0 );
+		table.apply_update( );
+		DAW_CHECK( process_ids( table ) == expected );
+	}
+
+	void sorts_on_the_sort_before_the_stream( ) {
+		auto const processes = make_processes( );
+		auto source = std::make_shared<daw::test::fake_process_source>( processes );
+		auto table = daw::wmi_process_table( L"host", source );
+		table.sort_column( column_number::WorkingSetSize, SortOrder::Descending );
+		table.set_stream_callback( [] {} );
+		table.update_data( );
+		table.apply_stream( );
+		table.apply_update( );
+
+		auto const &store = table.store( );
+		auto const &rows = table.rows( );
+		DAW_CHECK( rows.size( ) == processes.size( ) );
+		DAW_CHECK( std::is_sorted( rows.begin( ), rows.end( ),
+		                           [&]( auto lhs, auto rhs ) {
+			                           return store.working_set_size[lhs] >
+			                                  store.working_set_size[rhs];
+		                           } ) );
+	}
+
+	void does_not_stream_without_a_callback( ) {
+		auto source = std::make_shared<daw::test::fake_process_source>( make_processes( ) );
+		auto table = daw::wmi_process_table( L"host", source );
+		table.update_data( );
+		DAW_CHECK( table.apply_stream( ) == 0 );
+		table.apply_update( );
+		DAW_CHECK( table.rows( ).size( ) == 1'000 );
+		DAW_CHECK( !table.last_load_timing( ).complete );
+	}
+} // namespace
+
+int main( ) {
+	streams_the_first_load( );
+	sorts_on_the_sort_before_the_stream( );
+	does_not_stream_without_a_callback( );
+	return daw::test::result( );
+}
@@ -0,0 +1,83 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "daw/wmi_process.h"
+#include "daw/wmi_projection.h"
+
+namespace {
+	using column_number = daw::wmi_process::column_number;
+
+	void selects_only_the_columns_shown( ) {
+		auto const query = daw::make_projected_query(
+		  daw::make_column_set( {column_number::Name} ), L"Win32_Process" );
+		// The process id and creation date identify a row, they always come
+		DAW_CHECK( query ==
+		           L"SELECT Name, ProcessId, CreationDate FROM Win32_Process" );
+	}
+
+	void adds_the_where_clause( ) {
+		auto const query = daw::make_projected_query(
+		  daw::make_column_set( {column_number::ProcessId} ), L"Win32_Process",
+		  L"ProcessId = 4" );
+		DAW_CHECK( query == L"SELECT ProcessId, CreationDate FROM Win32_Process "
+		                    L"WHERE ProcessId = 4" );
+	}
+
+	void selects_the_sources_of_rates( ) {
+		auto const props = daw::projected_properties( daw::make_column_set(
+		  {column_number::CpuUsage, column_number::ReadRate} ) );
+		auto const has = [&]( std::wstring const &name ) {
+			return std::find( props.begin( ), props.end( ), name ) != props.end( );
+		};
+		DAW_CHECK( has( L"ReadTransferCount" ) );
+		DAW_CHECK( has( L"KernelModeTime" ) );
+		DAW_CHECK( has( L"UserModeTime" ) );
+		DAW_CHECK( !has( L"WriteTransferCount" ) );
+		DAW_CHECK( !has( L"CommandLine" ) );
+		// The rate columns have no property of their own
+		DAW_CHECK( daw::property_name( column_number::CpuUsage ) == nullptr );
+		DAW_CHECK( props.size( ) == 5 );
+	}
+
+	void selects_every_property_once( ) {
+		auto const props = daw::projected_properties( daw::all_columns( ) );
+		auto names = std::vector<std::wstring>( props.begin( ), props.end( ) );
+		std::sort( names.begin( ), names.end( ) );
+		DAW_CHECK( std::adjacent_find( names.begin( ), names.end( ) ) ==
+		           names.end( ) );
+		// Every column but the four rates, and the two CPU times
+		DAW_CHECK( names.size( ) == daw::wmi_process::column_count - 4 + 2 );
+	}
+} // namespace
+
+int main( ) {
+	selects_only_the_columns_shown( );
+	adds_the_where_clause( );
+	selects_the_sources_of_rates( );
+	selects_every_property_once( );
+	return daw::test::result( );
+}
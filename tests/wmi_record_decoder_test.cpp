@@ -0,0 +1,270 @@
+// MIT License
+//
+// Copyright (c) 2018 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <wx/datetime.h>
+
+#include "check.h"
+#include "daw/column_items.h"
+#include "daw/wmi_process.h"
+#include "daw/wmi_projection.h"
+#include "daw/wmi_record_decoder.h"
+
+namespace {
+	using column_number = daw::wmi_process::column_number;
+	using P = daw::process_properties;
+
+	// The properties of one Win32_Process, by name.  Counts the reads made
+	// through each accessor
+	struct fake_record {
+		std::map<std::wstring, uint64_t> integers;
+		std::map<std::wstring, std::wstring> strings;
+		std::map<std::wstring, wxDateTime> dates;
+		int name_reads = 0;
+		int handle_reads = 0;
+		int resolves = 0;
+	};
+
+	std::wstring name_of( P prop ) {
+		return daw::process_property_list[static_cast<size_t>( prop )].name;
+	}
+
+	fake_record make_record( ) {
+		auto result = fake_record{};
+		result.strings[L"Name"] = L"app.exe";
+		result.strings[L"CommandLine"] = L"app.exe --run";
+		result.strings[L"Handle"] = L"42";
+		result.integers[L"ProcessId"] = 42;
+		result.integers[L"ParentProcessId"] = 4;
+		result.integers[L"SessionId"] = 1;
+		result.dates[L"CreationDate"] = wxDateTime( wxLongLong( 1'000'000 ) );
+		result.integers[L"ThreadCount"] = 12;
+		result.integers[L"PageFaults"] = 900;
+		result.integers[L"PageFileUsage"] = 3;
+		result.integers[L"PeakPageFileUsage"] = 5;
+		result.integers[L"WorkingSetSize"] = 7'000;
+		result.integers[L"PeakWorkingSetSize"] = 11;
+		result.integers[L"ReadTransferCount"] = 1'000'000'000'000;
+		result.integers[L"WriteTransferCount"] = 2'000;
+		result.integers[L"KernelModeTime"] = 300;
+		result.integers[L"UserModeTime"] = 45;
+		return result;
+	}
+
+	bool has( fake_record const &record, wchar_t const *name,
+	          daw::cim_kinds kind ) {
+		switch( kind ) {
+		case daw::cim_kinds::String:
+			return record.strings.count( name ) != 0;
+		case daw::cim_kinds::Datetime:
+			return record.dates.count( name ) != 0;
+		default:
+			return record.integers.count( name ) != 0;
+		}
+	}
+
+	// Like IWbemClassObject::Get, resolves without looking at the record
+	struct name_access {
+		using record_t = fake_record;
+		using handle_t = wchar_t const *;
+
+		std::optional<handle_t> resolve( record_t &, wchar_t const *name,
+		                                 daw::cim_kinds ) const {
+			return name;
+		}
+
+		uint32_t read_uint32( record_t &record, handle_t name ) const {
+			return static_cast<uint32_t>( read_uint64( record, name ) );
+		}
+
+		uint64_t read_uint64( record_t &record, handle_t name ) const {
+			++record.name_reads;
+			return record.integers[name];
+		}
+
+		void read_string( record_t &record, handle_t name,
+		                  daw::String &dest ) const {
+			++record.name_reads;
+			dest = record.strings[name];
+		}
+
+		wxDateTime read_datetime( record_t &record, handle_t name ) const {
+			++record.name_reads;
+			return record.dates[name];
+		}
+	};
+
+	// Like IWbemObjectAccess, fails to resolve a property the record does
+	// not have
+	struct handle_access {
+		using record_t = fake_record;
+		using handle_t = std::wstring;
+
+		std::optional<handle_t> resolve( record_t &record, wchar_t const *name,
+		                                 daw::cim_kinds kind ) const {
+			++record.resolves;
+			if( !has( record, name, kind ) ) {
+				return std::nullopt;
+			}
+			return std::wstring( name );
+		}
+
+		uint32_t read_uint32( record_t &record, handle_t const &name ) const {
+			return static_cast<uint32_t>( read_uint64( record, name ) );
+		}
+
+		uint64_t read_uint64( record_t &record, handle_t const &name ) const {
+			++record.handle_reads;
+			return record.integers[name];
+		}
+
+		void read_string( record_t &record, handle_t const &name,
+		                  daw::String &dest ) const {
+			++record.handle_reads;
+			dest = record.strings[name];
+		}
+
+		wxDateTime read_datetime( record_t &record, handle_t const &name ) const {
+			++record.handle_reads;
+			return record.dates[name];
+		}
+	};
+
+	void decodes_every_column( ) {
+		auto record = make_record( );
+		auto decode = daw::record_decoder<handle_access>( handle_access{},
+		                                                  daw::all_columns( ) );
+		DAW_CHECK( decode.resolve( record ) );
+		auto item = daw::wmi_process{};
+		decode( record, item );
+		DAW_CHECK( item.name.value == L"app.exe" );
+		DAW_CHECK( item.command_line.value == L"app.exe --run" );
+		DAW_CHECK( item.handle.value == L"42" );
+		DAW_CHECK( item.process_id.value == 42 );
+		DAW_CHECK( item.parent_process_id.value == 4 );
+		DAW_CHECK( item.session_id.value == 1 );
+		DAW_CHECK( item.creation_date.value == wxDateTime( wxLongLong( 1'000'000 ) ) );
+		DAW_CHECK( item.thread_count.value == 12 );
+		DAW_CHECK( item.page_faults.value == 900 );
+		DAW_CHECK( item.working_set_size.value == 7'000 );
+		DAW_CHECK( item.read_transfer_count.value == 1'000'000'000'000 );
+		DAW_CHECK( item.write_transfer_count.value == 2'000 );
+		// Win32_Process has these in kB
+		DAW_CHECK( item.page_file_usage.value == 3 * 1024 );
+		DAW_CHECK( item.peak_page_file_usage.value == 5 * 1024 );
+		DAW_CHECK( item.peak_working_set_size.value == 11 * 1024 );
+		// Kernel and user time together
+		DAW_CHECK( item.cpu_time == 345 );
+	}
+
+	void leaves_other_columns_alone( ) {
+		auto record = make_record( );
+		auto decode = daw::record_decoder<handle_access>(
+		  handle_access{},
+		  daw::make_column_set( {column_number::ProcessId, column_number::CpuUsage} ) );
+		DAW_CHECK( decode.resolve( record ) );
+		// A property each, and kernel and user time for the CPU
+		DAW_CHECK( record.resolves == 3 );
+
+		auto item = daw::wmi_process{};
+		item.name = std::wstring_view( L"before.exe" );
+		item.working_set_size = 5;
+		item.page_file_usage = 6;
+		item.creation_date = wxDateTime( wxLongLong( 77 ) );
+		decode( record, item );
+		DAW_CHECK( item.process_id.value == 42 );
+		DAW_CHECK( item.cpu_time == 345 );
+		DAW_CHECK( record.handle_reads == 3 );
+		DAW_CHECK( item.name.value == L"before.exe" );
+		DAW_CHECK( item.working_set_size.value == 5 );
+		DAW_CHECK( item.page_file_usage.value == 6 );
+		DAW_CHECK( item.creation_date.value == wxDateTime( wxLongLong( 77 ) ) );
+	}
+
+	void fails_to_resolve_a_missing_property( ) {
+		auto record = make_record( );
+		record.integers.erase( name_of( P::UserModeTime ) );
+		auto decode =
+		  daw::record_decoder<handle_access>( handle_access{}, daw::all_columns( ) );
+		DAW_CHECK( !decode.resolve( record ) );
+
+		// Not needed by the columns asked for
+		auto pid_only = daw::record_decoder<handle_access>(
+		  handle_access{}, daw::make_column_set( {column_number::ProcessId} ) );
+		DAW_CHECK( pid_only.resolve( record ) );
+	}
+
+	using decoder_t = daw::fallback_decoder<handle_access, name_access>;
+
+	void falls_back_to_names( ) {
+		// Every property resolves, the handles are used from then on
+		{
+			auto decode = decoder_t( handle_access{}, name_access{}, daw::all_columns( ) );
+			auto record = make_record( );
+			auto item = daw::wmi_process{};
+			decode( record, &record, item );
+			DAW_CHECK( record.handle_reads > 0 );
+			DAW_CHECK( record.name_reads == 0 );
+			DAW_CHECK( item.cpu_time == 345 );
+		}
+		// One property does not resolve, every record is read by name
+		{
+			auto decode = decoder_t( handle_access{}, name_access{}, daw::all_columns( ) );
+			auto first = make_record( );
+			first.integers.erase( name_of( P::KernelModeTime ) );
+			auto item = daw::wmi_process{};
+			decode( first, &first, item );
+			DAW_CHECK( first.handle_reads == 0 );
+			DAW_CHECK( first.name_reads > 0 );
+			DAW_CHECK( item.process_id.value == 42 );
+
+			// The handles are only resolved once
+			auto second = make_record( );
+			decode( second, &second, item );
+			DAW_CHECK( second.resolves == 0 );
+			DAW_CHECK( second.handle_reads == 0 );
+			DAW_CHECK( item.cpu_time == 345 );
+			DAW_CHECK( item.page_file_usage.value == 3 * 1024 );
+		}
+		// The record cannot be read by handle
+		{
+			auto decode = decoder_t( handle_access{}, name_access{}, daw::all_columns( ) );
+			auto record = make_record( );
+			auto item = daw::wmi_process{};
+			decode( record, nullptr, item );
+			DAW_CHECK( record.resolves == 0 );
+			DAW_CHECK( record.handle_reads == 0 );
+			DAW_CHECK( item.name.value == L"app.exe" );
+		}
+	}
+} // namespace
+
+int main( ) {
+	decodes_every_column( );
+	leaves_other_columns_alone( );
+	fails_to_resolve_a_missing_property( );
+	falls_back_to_names( );
+	return daw::test::result( );
+}